@@ -0,0 +1,112 @@
+# Core of LIC, shared by the application and the benchmarks
+
+# === Where files can be found
+INCLUDEPATH += $$PWD/src/
+INCLUDEPATH += $$PWD/../Shared/
+DEPENDPATH += $$PWD/src/
+
+# === Frameworks and compiler
+# (QtGui only for QImage and its PNG encoder; no platform plugin is needed)
+QT += gui
+# (QtNetwork only for the local socket of the render server)
+QT += network
+QT += xml
+QT -= widgets
+CONFIG += c++17
+CONFIG += release
+CONFIG += silent
+
+# Don't allow deprecated versions of methods (before Qt 6.8)
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060800
+
+# Count heap allocations per stage ("qmake CONFIG+=alloc_count")
+alloc_count {
+    DEFINES += LIC_COUNT_ALLOCATIONS
+}
+
+# Shared classes
+HEADERS += $$PWD/../Shared/CallTracer.h
+SOURCES += $$PWD/../Shared/CallTracer.cpp
+HEADERS += $$PWD/../Shared/MessageLogger.h
+SOURCES += $$PWD/../Shared/MessageLogger.cpp
+HEADERS += $$PWD/../Shared/StringHelper.h
+SOURCES += $$PWD/../Shared/StringHelper.cpp
+
+# Specific classes
+HEADERS += $$PWD/src/AbstractFunction.h
+SOURCES += $$PWD/src/AbstractFunction.cpp
+HEADERS += $$PWD/src/AllocationCounter.h
+SOURCES += $$PWD/src/AllocationCounter.cpp
+HEADERS += $$PWD/src/Autotuner.h
+SOURCES += $$PWD/src/Autotuner.cpp
+HEADERS += $$PWD/src/BatchRenderer.h
+SOURCES += $$PWD/src/BatchRenderer.cpp
+HEADERS += $$PWD/src/Checkpoint.h
+SOURCES += $$PWD/src/Checkpoint.cpp
+HEADERS += $$PWD/src/Colormap.h
+SOURCES += $$PWD/src/Colormap.cpp
+HEADERS += $$PWD/src/ConfigWatcher.h
+SOURCES += $$PWD/src/ConfigWatcher.cpp
+HEADERS += $$PWD/src/CpuDispatch.h
+SOURCES += $$PWD/src/CpuDispatch.cpp
+HEADERS += $$PWD/src/Deploy.h
+HEADERS += $$PWD/src/Function_Constant.h
+SOURCES += $$PWD/src/Function_Constant.cpp
+HEADERS += $$PWD/src/Function_Cos.h
+SOURCES += $$PWD/src/Function_Cos.cpp
+HEADERS += $$PWD/src/Function_Difference.h
+SOURCES += $$PWD/src/Function_Difference.cpp
+HEADERS += $$PWD/src/Function_Exp.h
+SOURCES += $$PWD/src/Function_Exp.cpp
+HEADERS += $$PWD/src/Function_Exponent.h
+SOURCES += $$PWD/src/Function_Exponent.cpp
+HEADERS += $$PWD/src/Function_Log.h
+SOURCES += $$PWD/src/Function_Log.cpp
+HEADERS += $$PWD/src/Function_Product.h
+SOURCES += $$PWD/src/Function_Product.cpp
+HEADERS += $$PWD/src/Function_Quotient.h
+SOURCES += $$PWD/src/Function_Quotient.cpp
+HEADERS += $$PWD/src/Function_Sign.h
+SOURCES += $$PWD/src/Function_Sign.cpp
+HEADERS += $$PWD/src/Function_Sin.h
+SOURCES += $$PWD/src/Function_Sin.cpp
+HEADERS += $$PWD/src/Function_Sqrt.h
+SOURCES += $$PWD/src/Function_Sqrt.cpp
+HEADERS += $$PWD/src/Function_Sum.h
+SOURCES += $$PWD/src/Function_Sum.cpp
+HEADERS += $$PWD/src/Function_Tan.h
+SOURCES += $$PWD/src/Function_Tan.cpp
+HEADERS += $$PWD/src/Function_Variable.h
+SOURCES += $$PWD/src/Function_Variable.cpp
+HEADERS += $$PWD/src/LIC.h
+SOURCES += $$PWD/src/LIC.cpp
+HEADERS += $$PWD/src/Macros.h
+HEADERS += $$PWD/src/NumaTopology.h
+SOURCES += $$PWD/src/NumaTopology.cpp
+HEADERS += $$PWD/src/PerformanceReport.h
+SOURCES += $$PWD/src/PerformanceReport.cpp
+HEADERS += $$PWD/src/ProcessPool.h
+SOURCES += $$PWD/src/ProcessPool.cpp
+HEADERS += $$PWD/src/ProgressReporter.h
+SOURCES += $$PWD/src/ProgressReporter.cpp
+HEADERS += $$PWD/src/PyramidRenderer.h
+SOURCES += $$PWD/src/PyramidRenderer.cpp
+HEADERS += $$PWD/src/RenderClient.h
+SOURCES += $$PWD/src/RenderClient.cpp
+HEADERS += $$PWD/src/RenderEstimator.h
+SOURCES += $$PWD/src/RenderEstimator.cpp
+HEADERS += $$PWD/src/RenderServer.h
+SOURCES += $$PWD/src/RenderServer.cpp
+HEADERS += $$PWD/src/ShardRenderer.h
+SOURCES += $$PWD/src/ShardRenderer.cpp
+HEADERS += $$PWD/src/SimdKernels.h
+SOURCES += $$PWD/src/SimdKernels_AVX2.cpp
+SOURCES += $$PWD/src/SimdKernels_AVX512.cpp
+SOURCES += $$PWD/src/SimdKernels_Generic.cpp
+SOURCES += $$PWD/src/SimdKernels_SSE42.cpp
+HEADERS += $$PWD/src/StageCache.h
+SOURCES += $$PWD/src/StageCache.cpp
+HEADERS += $$PWD/src/ThreadPool.h
+SOURCES += $$PWD/src/ThreadPool.cpp
+HEADERS += $$PWD/src/TileScheduler.h
+SOURCES += $$PWD/src/TileScheduler.cpp
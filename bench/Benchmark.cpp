@@ -0,0 +1,1476 @@
+// Benchmark.cpp
+// Class implementation
+
+// Project includes
+#include "AbstractFunction.h"
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "Colormap.h"
+#include "CpuDispatch.h"
+#include "ImageComparison.h"
+#include "LIC.h"
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "NumaTopology.h"
+#include "PerfCounter.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QSysInfo>
+#include <QThread>
+
+// System includes
+#include <algorithm>
+#include <cstring>
+
+
+
+// Version of the JSON layout; increase when fields change meaning
+static const int BENCHMARK_SCHEMA_VERSION = 1;
+
+// Startup time we want to stay below so short renders can be fanned out
+static const double STARTUP_BUDGET_SECONDS = 0.020;
+
+// Smallest configuration that goes through every stage of a render
+static const char * STARTUP_CONFIGURATION =
+    "<lic>\n"
+    "  <vectorfield>\n"
+    "    <formulas>\n"
+    "      <x>y</x>\n"
+    "      <y>x</y>\n"
+    "    </formulas>\n"
+    "  </vectorfield>\n"
+    "  <background type=\"gaussian\" sigma=\"3\" seed=\"1\"/>\n"
+    "  <image steps=\"5\">\n"
+    "    <ranges>\n"
+    "      <range variable=\"x\" min=\"-1\" max=\"+1\"/>\n"
+    "      <range variable=\"y\" min=\"-1\" max=\"+1\"/>\n"
+    "    </ranges>\n"
+    "    <resolution x=\"16\" y=\"16\"/>\n"
+    "    <output filename=\"startup.png\"/>\n"
+    "  </image>\n"
+    "</lic>\n";
+
+// Bytes transferred per cache miss
+static const int CACHE_LINE_SIZE = 64;
+
+// Results of evaluations end up here so they can't be optimized away
+static volatile double benchmark_sink = 0.;
+
+// One expression per Function_* type
+static const QList < QPair < QString, QString > > function_type_formulas =
+{
+    { "Constant", "2.5" },
+    { "Variable", "x" },
+    { "Sum", "x+y" },
+    { "Difference", "x-y" },
+    { "Product", "x*y" },
+    { "Quotient", "x/y" },
+    { "Sign", "-x" },
+    { "Exponent", "x^y" },
+    { "Cos", "cos(x)" },
+    { "Sin", "sin(x)" },
+    { "Tan", "tan(x)" },
+    { "Exp", "exp(x)" },
+    { "Log", "log(x)" },
+    { "Sqrt", "sqrt(x)" }
+};
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+Benchmark::Benchmark()
+{
+    m_Quick = false;
+
+    // LIC is built next to the bench directory
+    m_ApplicationFilename = QDir(QCoreApplication::applicationDirPath())
+        .filePath("../LIC");
+
+    // Output of images goes here
+    m_TemporaryDirectory = QDir(QDir::tempPath()).filePath(
+        QString("lic-bench-%1").arg(QCoreApplication::applicationPid()));
+    QDir().mkpath(m_TemporaryDirectory);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+Benchmark::~Benchmark()
+{
+    QDir(m_TemporaryDirectory).removeRecursively();
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Directory with the Example-*.xml configurations
+bool Benchmark::SetExamplesDirectory(const QString mcDirectory)
+{
+    QDir directory(mcDirectory);
+    const QStringList files =
+        directory.entryList(QStringList() << "Example-*.xml", QDir::Files,
+            QDir::Name);
+    if (files.isEmpty())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("No Example-*.xml found in \"%1\".").arg(mcDirectory));
+        return false;
+    }
+    m_ExampleFiles.clear();
+    for (const QString & file : files)
+    {
+        m_ExampleFiles << directory.absoluteFilePath(file);
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LIC executable for the startup benchmark
+void Benchmark::SetApplication(const QString mcFilename)
+{
+    m_ApplicationFilename = mcFilename;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Only run benchmarks whose "group/name" contains this text
+void Benchmark::SetFilter(const QString mcFilter)
+{
+    m_Filter = mcFilter;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Shorter measurements and smaller images
+void Benchmark::SetQuick(bool mQuick)
+{
+    m_Quick = mQuick;
+}
+
+
+
+// ================================================================= Benchmarks
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Run all benchmarks
+void Benchmark::Run()
+{
+    RunParserBenchmarks();
+    RunEvaluatorBenchmarks();
+    RunVectorfieldBenchmarks();
+    RunTracerBenchmarks();
+    RunNoiseBenchmarks();
+    RunEncoderBenchmarks();
+    RunEndToEndBenchmarks();
+    RunStartupBenchmarks();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AbstractFunction::CreateFunction
+void Benchmark::RunParserBenchmarks()
+{
+    // Individual function types
+    for (const QPair < QString, QString > & formula : function_type_formulas)
+    {
+        const QString text = formula.second;
+        Measure("parser", formula.first, "formula", 1.,
+            [text]()
+            {
+                delete AbstractFunction::CreateFunction(text);
+            });
+    }
+
+    // Formulas of the examples
+    for (const QString & filename : m_ExampleFiles)
+    {
+        LIC * lic = LoadExample(filename, 0, 0);
+        if (!lic)
+        {
+            continue;
+        }
+        for (const QString coordinate : { "x", "y" })
+        {
+            const QString text =
+                lic -> m_Vectorfield[coordinate] -> ToString();
+            Measure("parser",
+                QString("%1/%2").arg(GetExampleName(filename), coordinate),
+                "formula", 1.,
+                [text]()
+                {
+                    delete AbstractFunction::CreateFunction(text);
+                });
+        }
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AbstractFunction::Evaluate for each Function_* type and the examples
+void Benchmark::RunEvaluatorBenchmarks()
+{
+    // Many evaluations per call so timer overhead doesn't matter
+    const int num_evaluations = 1000;
+
+    // Individual function types
+    QHash < QString, double > variables;
+    variables["x"] = 0.3;
+    variables["y"] = 0.7;
+    for (const QPair < QString, QString > & formula : function_type_formulas)
+    {
+        AbstractFunction * function =
+            AbstractFunction::CreateFunction(formula.second);
+        Measure("evaluator", formula.first, "evaluation", num_evaluations,
+            [function, variables, num_evaluations]()
+            {
+                double sum = 0.;
+                for (int idx = 0; idx < num_evaluations; idx++)
+                {
+                    sum += function -> Evaluate(variables);
+                }
+                benchmark_sink = sum;
+            });
+        delete function;
+    }
+
+    // Formulas of the examples
+    for (const QString & filename : m_ExampleFiles)
+    {
+        LIC * lic = LoadExample(filename, 0, 0);
+        if (!lic)
+        {
+            continue;
+        }
+        QHash < QString, double > example_variables = lic -> m_Parameters;
+        example_variables["x"] = 0.3;
+        example_variables["y"] = 0.7;
+        for (const QString coordinate : { "x", "y" })
+        {
+            AbstractFunction * function = lic -> m_Vectorfield[coordinate];
+            Measure("evaluator",
+                QString("%1/%2").arg(GetExampleName(filename), coordinate),
+                "evaluation", num_evaluations,
+                [function, example_variables, num_evaluations]()
+                {
+                    double sum = 0.;
+                    for (int idx = 0; idx < num_evaluations; idx++)
+                    {
+                        sum += function -> Evaluate(example_variables);
+                    }
+                    benchmark_sink = sum;
+                });
+        }
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LIC::EvaluateVectorfield
+void Benchmark::RunVectorfieldBenchmarks()
+{
+    const int num_evaluations = 1000;
+    for (const QString & filename : m_ExampleFiles)
+    {
+        LIC * lic = LoadExample(filename, 0, 0);
+        if (!lic)
+        {
+            continue;
+        }
+
+        // Walk along a diagonal of the domain
+        const double x_min = lic -> m_Image_XMin;
+        const double x_max = lic -> m_Image_XMax;
+        const double y_min = lic -> m_Image_YMin;
+        const double y_max = lic -> m_Image_YMax;
+        LIC::TraceWorkspace workspace;
+        lic -> InitializeWorkspace(workspace);
+        Measure("vectorfield", GetExampleName(filename), "evaluation",
+            num_evaluations,
+            [lic, &workspace, x_min, x_max, y_min, y_max, num_evaluations]()
+            {
+                double sum = 0.;
+                for (int idx = 0; idx < num_evaluations; idx++)
+                {
+                    const double t = idx / (num_evaluations - 1.);
+                    const QPair < double, double > v =
+                        lic -> EvaluateVectorfield(
+                            x_min + t * (x_max - x_min),
+                            y_min + t * (y_max - y_min),
+                            workspace.variables);
+                    sum += v.first + v.second;
+                }
+                benchmark_sink = sum;
+            });
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Streamline tracing per pixel
+void Benchmark::RunTracerBenchmarks()
+{
+    const int size = (m_Quick ? 128 : 256);
+    const int num_pixels = 256;
+    for (const QString & filename : m_ExampleFiles)
+    {
+        LIC * lic = LoadExample(filename, size, size);
+        if (!lic)
+        {
+            continue;
+        }
+        lic -> GenerateNoise();
+        lic -> m_LIC_R.resize(size * size);
+        lic -> m_LIC_G.resize(size * size);
+        lic -> m_LIC_B.resize(size * size);
+        lic -> m_LIC_Strength.resize(size * size);
+
+        // Same scattered set of pixels in every iteration
+        QList < QPair < int, int > > pixels;
+        srand48(1);
+        for (int idx = 0; idx < num_pixels; idx++)
+        {
+            pixels << QPair < int, int >(int(drand48() * size),
+                int(drand48() * size));
+        }
+
+        LIC::TraceWorkspace workspace;
+        lic -> InitializeWorkspace(workspace);
+        lic -> SetWorkspaceTarget(workspace, lic -> GetImageTarget());
+        Measure("tracer", GetExampleName(filename), "pixel", num_pixels,
+            [lic, &workspace, pixels]()
+            {
+                for (const QPair < int, int > & pixel : pixels)
+                {
+                    lic -> TracePixel(pixel.first, pixel.second, workspace);
+                }
+                benchmark_sink = workspace.length;
+            });
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LIC::GenerateNoise for each background type
+void Benchmark::RunNoiseBenchmarks()
+{
+    if (m_ExampleFiles.isEmpty())
+    {
+        return;
+    }
+    const int size = (m_Quick ? 256 : 1024);
+    LIC * lic = LoadExample(m_ExampleFiles.first(), size, size);
+    if (!lic)
+    {
+        return;
+    }
+    lic -> m_BackgroundSeed = 1;
+    lic -> m_WhiteNoise_Cutoff = 0.5;
+    lic -> m_Checkerboard_Width = 4;
+    lic -> m_Gaussian_Sigma = 1.;
+    lic -> m_Gaussian_Low = 0.;
+    lic -> m_Gaussian_High = 1.;
+    for (const QString type : { "white noise", "checkerboard", "gaussian" })
+    {
+        lic -> m_BackgroundType = type;
+        Measure("noise", QString("%1/%2x%2").arg(type, QString::number(size)),
+            "pixel", double(size) * size,
+            [lic]()
+            {
+                lic -> GenerateNoise();
+            });
+    }
+    delete lic;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// LIC::GenerateImage (normalization, coloring, PNG encoding)
+void Benchmark::RunEncoderBenchmarks()
+{
+    const int size = (m_Quick ? 256 : 512);
+    const QString gray_name = QString("gray/%1x%1").arg(size);
+    const QString viridis_name = QString("viridis/%1x%1").arg(size);
+    const QString buffer_name = QString("float-buffer/%1x%1").arg(size);
+    if (m_ExampleFiles.isEmpty() ||
+        (!IsSelected("encoder", gray_name) &&
+         !IsSelected("encoder", viridis_name) &&
+         !IsSelected("encoder", buffer_name)))
+    {
+        // Don't trace an image nobody is going to encode
+        return;
+    }
+    LIC * lic = LoadExample(m_ExampleFiles.first(), size, size);
+    if (!lic)
+    {
+        return;
+    }
+    lic -> GenerateNoise();
+    lic -> GenerateLIC();
+
+    // Grayscale
+    Measure("encoder", gray_name, "pixel",
+        double(size) * size,
+        [lic]()
+        {
+            lic -> SaveImage(lic -> m_Outputs.first().filename);
+        });
+
+    // Colored by strength
+    delete lic -> m_Colormap;
+    lic -> m_Colormap = Colormap::CreateColormap("viridis", 1.);
+    Measure("encoder", viridis_name, "pixel",
+        double(size) * size,
+        [lic]()
+        {
+            lic -> SaveImage(lic -> m_Outputs.first().filename);
+        });
+
+    // Colored, into a caller-owned buffer without encoding
+    QList < float > buffer(3 * size * size);
+    Measure("encoder", buffer_name, "pixel",
+        double(size) * size,
+        [lic, &buffer, size]()
+        {
+            lic -> GenerateImage(buffer.data(), 3 * sizeof(float) * size,
+                LIC::PixelFormat_RGB_Float);
+        });
+    delete lic;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Complete runs of the examples at several resolutions
+void Benchmark::RunEndToEndBenchmarks()
+{
+    const QList < int > sizes = (m_Quick ?
+        QList < int >({ 64, 128 }) : QList < int >({ 128, 256, 512 }));
+    for (const QString & filename : m_ExampleFiles)
+    {
+        for (const int size : sizes)
+        {
+            Measure("end-to-end",
+                QString("%1/%2x%2").arg(GetExampleName(filename),
+                    QString::number(size)),
+                "pixel", double(size) * size,
+                [this, filename, size]()
+                {
+                    LIC * lic = LoadExample(filename, size, size);
+                    if (lic)
+                    {
+                        lic -> Execute();
+                        delete lic;
+                    }
+                });
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Process startup of the LIC executable
+void Benchmark::RunStartupBenchmarks()
+{
+    if (!QFileInfo(m_ApplicationFilename).isExecutable())
+    {
+        qDebug().noquote() << QString("Startup benchmark skipped: \"%1\" "
+            "is not an executable.").arg(m_ApplicationFilename);
+        return;
+    }
+
+    // Tiny configuration, rendered in the temporary directory
+    const QString config_filename =
+        QDir(m_TemporaryDirectory).filePath("startup.xml");
+    QFile config_file(config_filename);
+    if (!config_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Configuration \"%1\" could not be written.")
+                .arg(config_filename));
+        return;
+    }
+    config_file.write(STARTUP_CONFIGURATION);
+    config_file.close();
+
+    // Without arguments, LIC only sets up the application and prints its
+    // usage; that is the fixed cost paid by every render. The tiny render
+    // adds reading a configuration, the stages, and the PNG encoder.
+    const QList < QPair < QString, QStringList > > runs =
+    {
+        { "usage", QStringList() },
+        { "render", QStringList() << config_filename }
+    };
+    const QString application_filename = m_ApplicationFilename;
+    const QString working_directory = m_TemporaryDirectory;
+    for (const QPair < QString, QStringList > & run : runs)
+    {
+        if (!IsSelected("startup", run.first))
+        {
+            continue;
+        }
+
+        // A run that fails to start or exits with an error would only
+        // measure the failure
+        QString error;
+        if (!RunApplication(application_filename, run.second,
+            working_directory, error))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Startup benchmark \"%1\" failed: %2")
+                    .arg(run.first, error));
+            continue;
+        }
+        bool failed = false;
+        const QStringList arguments = run.second;
+        Measure("startup", run.first, "process", 1,
+            [application_filename, arguments, working_directory, &failed]()
+            {
+                QString error;
+                if (!RunApplication(application_filename, arguments,
+                    working_directory, error))
+                {
+                    failed = true;
+                }
+            });
+
+        // Check against the budget (median per process)
+        QJsonObject result = m_Results.last().toObject();
+        const double median_seconds = result["median_seconds"].toDouble();
+        result["budget_seconds"] = STARTUP_BUDGET_SECONDS;
+        result["failed"] = failed;
+        result["within_budget"] = (!failed &&
+            median_seconds <= STARTUP_BUDGET_SECONDS);
+        m_Results[m_Results.size() - 1] = result;
+        if (failed)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Startup benchmark \"%1\" failed in some runs.")
+                    .arg(run.first));
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Run the LIC executable once
+bool Benchmark::RunApplication(const QString mcFilename,
+    const QStringList mcArguments, const QString mcWorkingDirectory,
+    QString & mrError)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.setWorkingDirectory(mcWorkingDirectory);
+    process.start(mcFilename, mcArguments);
+    if (!process.waitForStarted() ||
+        !process.waitForFinished())
+    {
+        mrError = process.errorString();
+        return false;
+    }
+    if (process.exitStatus() != QProcess::NormalExit ||
+        process.exitCode() != 0)
+    {
+        mrError = QString("exit code %1: %2")
+            .arg(QString::number(process.exitCode()),
+                QString::fromLocal8Bit(process.readAll()).trimmed());
+        return false;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Thread scaling of LIC::GenerateLIC
+void Benchmark::RunScaling(int mMaxThreads)
+{
+    // 1, 2, 4, ... threads up to the maximum
+    const int max_threads =
+        (mMaxThreads > 0 ? mMaxThreads : QThread::idealThreadCount());
+    QList < int > thread_counts;
+    for (int num_threads = 1; num_threads < max_threads; num_threads *= 2)
+    {
+        thread_counts << num_threads;
+    }
+    thread_counts << max_threads;
+
+    // All examples at a small size; the cheapest one (fewest steps) also at
+    // poster size
+    QList < QPair < QString, int > > configurations;
+    QString cheapest_filename;
+    int cheapest_steps = 0;
+    for (const QString & filename : m_ExampleFiles)
+    {
+        configurations << QPair < QString, int >(filename, 512);
+        LIC * lic = LoadExample(filename, 0, 0);
+        if (lic &&
+            (cheapest_filename.isEmpty() ||
+             lic -> m_Steps < cheapest_steps))
+        {
+            cheapest_filename = filename;
+            cheapest_steps = lic -> m_Steps;
+        }
+        delete lic;
+    }
+    if (!m_Quick &&
+        !cheapest_filename.isEmpty())
+    {
+        configurations << QPair < QString, int >(cheapest_filename, 4096);
+    }
+
+    // Cache misses of the last level cache
+    PerfCounter llc_misses(PerfCounter::Event_LLCMisses);
+    if (!llc_misses.IsAvailable())
+    {
+        qDebug().noquote() << QString("Cache misses can't be counted: %1")
+            .arg(llc_misses.GetError());
+    }
+
+    const int num_repetitions = (m_Quick ? 1 : 3);
+    for (const QPair < QString, int > & configuration : configurations)
+    {
+        const int size = configuration.second;
+        const QString name = QString("%1/%2x%2")
+            .arg(GetExampleName(configuration.first),
+                 QString::number(size));
+        if (!IsSelected("scaling", name))
+        {
+            continue;
+        }
+        LIC * lic = LoadExample(configuration.first, size, size);
+        if (!lic)
+        {
+            continue;
+        }
+        lic -> GenerateNoise();
+
+        const double num_pixels = double(size) * size;
+        double single_thread_seconds = 0.;
+        for (const int num_threads : thread_counts)
+        {
+            lic -> SetNumThreads(num_threads);
+
+            // Fastest of a few runs; cache misses of that run
+            const RenderTimings timings =
+                TimeGenerateLIC(lic, num_repetitions, &llc_misses);
+            const double best_seconds = timings.best_seconds;
+            const qint64 best_misses = timings.best_misses;
+            if (num_threads == 1)
+            {
+                single_thread_seconds = best_seconds;
+            }
+
+            QJsonObject result = CreateResult("scaling",
+                QString("%1/threads-%2").arg(name,
+                    QString::number(num_threads)),
+                "pixel", num_pixels, 1, timings.seconds);
+            const double speedup = single_thread_seconds / best_seconds;
+            result["threads"] = num_threads;
+            result["speedup"] = speedup;
+            result["parallel_efficiency"] = speedup / num_threads;
+            if (best_misses >= 0)
+            {
+                // Every miss transfers one cache line from memory
+                result["llc_misses_per_pixel"] = best_misses / num_pixels;
+                result["memory_bandwidth_bytes_per_second"] =
+                    best_misses * CACHE_LINE_SIZE / best_seconds;
+            } else
+            {
+                result["llc_misses_per_pixel"] = QJsonValue();
+                result["memory_bandwidth_bytes_per_second"] = QJsonValue();
+            }
+            m_Results.append(result);
+        }
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Threads and worker processes for LIC::GenerateLIC
+void Benchmark::RunBackends(int mMaxThreads)
+{
+    const int num_workers =
+        (mMaxThreads > 0 ? mMaxThreads : QThread::idealThreadCount());
+    const int size = (m_Quick ? 256 : 1024);
+    const int num_repetitions = (m_Quick ? 1 : 3);
+    for (const QString & filename : m_ExampleFiles)
+    {
+        const QString name = QString("%1/%2x%2")
+            .arg(GetExampleName(filename), QString::number(size));
+        if (!IsSelected("backends", name))
+        {
+            continue;
+        }
+        LIC * lic = LoadExample(filename, size, size);
+        if (!lic)
+        {
+            continue;
+        }
+        lic -> GenerateNoise();
+        lic -> SetNumThreads(num_workers);
+
+        // Threads first; they are the reference for speed and pixels
+        const double num_pixels = double(size) * size;
+        double threads_seconds = 0.;
+        QList < QList < double > > reference;
+        const QList < QPair < LIC::Backend, QString > > backends({
+            QPair < LIC::Backend, QString >(LIC::Backend_Threads,
+                "threads"),
+            QPair < LIC::Backend, QString >(LIC::Backend_Processes,
+                "processes") });
+        for (const QPair < LIC::Backend, QString > & backend : backends)
+        {
+            lic -> SetBackend(backend.first);
+            const RenderTimings timings =
+                TimeGenerateLIC(lic, num_repetitions);
+            if (backend.first == LIC::Backend_Threads)
+            {
+                threads_seconds = timings.best_seconds;
+                reference = timings.planes;
+            }
+
+            QJsonObject result = CreateResult("backends",
+                QString("%1/%2-%3").arg(name, backend.second,
+                    QString::number(num_workers)),
+                "pixel", num_pixels, 1, timings.seconds);
+            result["backend"] = backend.second;
+            result["workers"] = num_workers;
+            result["speedup_over_threads"] =
+                threads_seconds / timings.best_seconds;
+            result["pixel_checksum"] = timings.checksum;
+            result["identical"] = IsIdentical(timings.planes, reference);
+            m_Results.append(result);
+        }
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Placement of buffers on the memory nodes for LIC::GenerateLIC
+void Benchmark::RunNUMA(int mMaxThreads)
+{
+    const int num_threads =
+        (mMaxThreads > 0 ? mMaxThreads : QThread::idealThreadCount());
+    const int num_nodes = NumaTopology::GetHost().GetNumNodes();
+    if (num_nodes < 2)
+    {
+        qDebug().noquote() << "This host has one memory node; placement "
+            "and pinning can't make a difference.";
+    }
+    const int size = (m_Quick ? 512 : 2048);
+    const int num_repetitions = (m_Quick ? 1 : 3);
+
+    // Variants: placement, pinning
+    struct Variant
+    {
+        QString name;
+        bool placement;
+        bool pin_threads;
+    };
+    const QList < Variant > variants({
+        { "first-touch-main", false, false },
+        { "node-strips", true, false },
+        { "node-strips-pinned", true, true } });
+
+    for (const QString & filename : m_ExampleFiles)
+    {
+        const QString name = QString("%1/%2x%2")
+            .arg(GetExampleName(filename), QString::number(size));
+        if (!IsSelected("numa", name))
+        {
+            continue;
+        }
+        LIC * lic = LoadExample(filename, size, size);
+        if (!lic)
+        {
+            continue;
+        }
+        lic -> SetNumThreads(num_threads);
+
+        const double num_pixels = double(size) * size;
+        double baseline_seconds = 0.;
+        QList < QList < double > > reference;
+        for (const Variant & variant : variants)
+        {
+            // Noise is placed when it is generated
+            lic -> SetNUMAPlacement(variant.placement);
+            lic -> SetPinThreads(variant.pin_threads);
+            lic -> GenerateNoise();
+
+            // Pinned threads on several nodes have to use their own copies
+            // of the formulas
+            const double replicas_before =
+                lic -> GetPerformanceReport().GetCounter("formula_replicas");
+            const RenderTimings timings =
+                TimeGenerateLIC(lic, num_repetitions, nullptr,
+                    [lic]()
+                    {
+                        // New planes every time, so their pages are
+                        // touched first by this run
+                        lic -> TakeTracedPlanes();
+                        lic -> m_DistributedPlane = nullptr;
+                    });
+            if (reference.isEmpty())
+            {
+                baseline_seconds = timings.best_seconds;
+                reference = timings.planes;
+            }
+
+            QJsonObject result = CreateResult("numa",
+                QString("%1/%2").arg(name, variant.name), "pixel",
+                num_pixels, 1, timings.seconds);
+            result["numa_nodes"] = num_nodes;
+            result["threads"] = num_threads;
+            result["speedup_over_first_touch_main"] =
+                baseline_seconds / timings.best_seconds;
+            result["pixel_checksum"] = timings.checksum;
+            result["identical"] = IsIdentical(timings.planes, reference);
+            const int num_replicas = qRound(
+                (lic -> GetPerformanceReport().GetCounter("formula_replicas") -
+                    replicas_before) / num_repetitions);
+            const bool replicas_expected =
+                variant.pin_threads && num_nodes > 1;
+            result["formula_replicas"] = num_replicas;
+            result["replicated"] = (!replicas_expected || num_replicas > 0);
+            if (replicas_expected &&
+                num_replicas == 0)
+            {
+                MessageLogger::Error(METHOD_NAME,
+                    QString("\"%1/%2\" used no copies of the formulas.")
+                        .arg(name, variant.name));
+            }
+            m_Results.append(result);
+        }
+        delete lic;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Compare renderings of the examples with golden images
+bool Benchmark::RunGolden(const QString mcGoldenDirectory, bool mUpdate,
+    bool mStrict)
+{
+    // Manifest with resolution, thresholds, and runtime budgets
+    const QString manifest_filename =
+        QDir(mcGoldenDirectory).filePath("golden.json");
+    QFile manifest_file(manifest_filename);
+    if (!manifest_file.open(QIODevice::ReadOnly))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Golden manifest \"%1\" could not be read.")
+                .arg(manifest_filename));
+        return false;
+    }
+    QJsonObject manifest =
+        QJsonDocument::fromJson(manifest_file.readAll()).object();
+    manifest_file.close();
+    const int size = manifest["resolution"].toInt(256);
+    const double tolerance =
+        manifest["runtime_tolerance_percent"].toDouble(25.) / 100.;
+    const QJsonObject thresholds = manifest["thresholds"].toObject();
+    QJsonObject budgets = manifest["budgets"].toObject();
+
+    const int num_repetitions = (m_Quick ? 1 : 3);
+    const CpuDispatch::ISA default_isa = CpuDispatch::GetISA();
+    bool success = true;
+    for (const QString & filename : m_ExampleFiles)
+    {
+        const QString example = GetExampleName(filename);
+
+        // Every engine and precision mode with thresholds
+        for (const QString & variant : thresholds.keys())
+        {
+            const QString name = QString("%1/%2").arg(example, variant);
+            if (!IsSelected("golden", name))
+            {
+                continue;
+            }
+
+            // Kernels this CPU doesn't have are checked on other hosts
+            CpuDispatch::ISA isa = default_isa;
+            const QString isa_name = variant.section('/', 2);
+            if (!isa_name.isEmpty() &&
+                CpuDispatch::ISAFromString(isa_name, isa) &&
+                isa > CpuDispatch::GetDetectedISA())
+            {
+                qDebug().noquote() << QString("%1 skipped: this CPU can't "
+                    "run the \"%2\" kernels.").arg(name, isa_name);
+                continue;
+            }
+
+            // Render; the fastest run counts for the budget
+            QList < double > seconds;
+            QString output_filename;
+            for (int repetition = 0; repetition < num_repetitions;
+                 repetition++)
+            {
+                LIC * lic = LoadExample(filename, size, size);
+                if (!lic ||
+                    !ConfigureVariant(lic, variant))
+                {
+                    delete lic;
+                    break;
+                }
+                QElapsedTimer timer;
+                timer.start();
+                lic -> Execute();
+                seconds << timer.nsecsElapsed() * 1e-9;
+                output_filename = lic -> m_Outputs.first().filename;
+                delete lic;
+            }
+            CpuDispatch::SetISA(default_isa);
+            if (seconds.isEmpty())
+            {
+                MessageLogger::Error(METHOD_NAME,
+                    QString("%1 could not be rendered.").arg(name));
+                success = false;
+                continue;
+            }
+            const double best_seconds =
+                *std::min_element(seconds.begin(), seconds.end());
+            const QImage image(output_filename);
+
+            // Golden image
+            const QString golden_filename =
+                QDir(mcGoldenDirectory).filePath(QString("%1-%2.png")
+                    .arg(example, QString(variant).replace("/", "-")));
+            if (mUpdate)
+            {
+                image.save(golden_filename, "png");
+                budgets[name] = best_seconds;
+            }
+            const QImage golden_image(golden_filename);
+
+            // Quality; without a golden image, this fails in strict mode
+            // and is skipped otherwise
+            const QString missing_status = (mStrict ? "missing" : "skipped");
+            const QJsonObject threshold = thresholds[variant].toObject();
+            const double min_psnr = threshold["min_psnr"].toDouble();
+            const double min_ssim = threshold["min_ssim"].toDouble();
+            QString quality = missing_status;
+            double psnr = 0.;
+            double ssim = 0.;
+            if (!golden_image.isNull())
+            {
+                psnr = ImageComparison::PSNR(image, golden_image);
+                ssim = ImageComparison::SSIM(image, golden_image);
+                quality = (psnr >= min_psnr && ssim >= min_ssim ?
+                    "passed" : "failed");
+            }
+
+            // Runtime; the same for a missing budget
+            const double budget = budgets[name].toDouble(0.);
+            QString runtime = missing_status;
+            if (budget > 0.)
+            {
+                runtime = (best_seconds <= budget * (1. + tolerance) ?
+                    "passed" : "failed");
+            }
+            const bool passed = (quality != "failed" &&
+                quality != "missing" &&
+                runtime != "failed" &&
+                runtime != "missing");
+
+            QJsonObject result = CreateResult("golden", name, "pixel",
+                double(size) * size, 1, seconds);
+            result["psnr"] = (golden_image.isNull() ? QJsonValue() :
+                QJsonValue(psnr));
+            result["ssim"] = (golden_image.isNull() ? QJsonValue() :
+                QJsonValue(ssim));
+            result["min_psnr"] = min_psnr;
+            result["min_ssim"] = min_ssim;
+            result["budget_seconds"] = (budget > 0. ? QJsonValue(budget) :
+                QJsonValue());
+            result["quality"] = quality;
+            result["runtime"] = runtime;
+            result["passed"] = passed;
+            m_Results.append(result);
+
+            QStringList missing;
+            if (golden_image.isNull())
+            {
+                missing << QString("golden image \"%1\"")
+                    .arg(golden_filename);
+            }
+            if (budget <= 0.)
+            {
+                missing << "runtime budget";
+            }
+            if (!missing.isEmpty())
+            {
+                const QString message = QString("%1 %2: no %3 recorded "
+                    "(see --update-golden).")
+                    .arg(name,
+                         mStrict ? QString("failed") :
+                            QString("partly skipped"),
+                         missing.join(" and no "));
+                if (mStrict)
+                {
+                    MessageLogger::Error(METHOD_NAME, message);
+                } else
+                {
+                    qDebug().noquote() << message;
+                }
+            }
+            if (!passed)
+            {
+                MessageLogger::Error(METHOD_NAME,
+                    QString("%1 failed: PSNR %2 dB (min %3), SSIM %4 (min "
+                        "%5), %6 s (budget %7 s + %8%).")
+                        .arg(name,
+                             golden_image.isNull() ? QString("n/a") :
+                                QString::number(psnr, 'f', 2),
+                             QString::number(min_psnr),
+                             golden_image.isNull() ? QString("n/a") :
+                                QString::number(ssim, 'f', 4),
+                             QString::number(min_ssim),
+                             QString::number(best_seconds, 'f', 3),
+                             budget > 0. ? QString::number(budget, 'f', 3) :
+                                QString("n/a"),
+                             QString::number(tolerance * 100.)));
+                success = false;
+            }
+        }
+    }
+
+    // Save new budgets
+    if (mUpdate)
+    {
+        manifest["budgets"] = budgets;
+        if (!manifest_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Golden manifest \"%1\" could not be written.")
+                    .arg(manifest_filename));
+            return false;
+        }
+        manifest_file.write(
+            QJsonDocument(manifest).toJson(QJsonDocument::Indented));
+        manifest_file.close();
+    }
+
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Count heap allocations in the tracing hot path
+bool Benchmark::RunAllocationCheck()
+{
+    if (!AllocationCounter::IsEnabled())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            "Allocations are not counted in this build; "
+            "rebuild with \"qmake CONFIG+=alloc_count\".");
+        return false;
+    }
+
+    const int size = (m_Quick ? 128 : 256);
+    bool success = true;
+    for (const QString & filename : m_ExampleFiles)
+    {
+        const QString name = GetExampleName(filename);
+        if (!IsSelected("allocations", name))
+        {
+            continue;
+        }
+        LIC * lic = LoadExample(filename, size, size);
+        if (!lic)
+        {
+            success = false;
+            continue;
+        }
+        lic -> GenerateNoise();
+        lic -> m_LIC_R.resize(size * size);
+        lic -> m_LIC_G.resize(size * size);
+        lic -> m_LIC_B.resize(size * size);
+        lic -> m_LIC_Strength.resize(size * size);
+
+        // Warm up: the first evaluations may still insert into the variable
+        // hash of the workspace
+        LIC::TraceWorkspace workspace;
+        lic -> InitializeWorkspace(workspace);
+        lic -> SetWorkspaceTarget(workspace, lic -> GetImageTarget());
+        for (int ix = 0; ix < size; ix++)
+        {
+            lic -> TracePixel(ix, 0, workspace);
+        }
+
+        // Steady state: every remaining pixel, counted on this thread only
+        const qint64 allocations_start =
+            AllocationCounter::GetThreadAllocations();
+        for (int ix = 0; ix < size; ix++)
+        {
+            for (int iy = 1; iy < size; iy++)
+            {
+                lic -> TracePixel(ix, iy, workspace);
+            }
+        }
+        const qint64 allocations =
+            AllocationCounter::GetThreadAllocations() - allocations_start;
+        const double num_pixels = double(size) * (size - 1);
+
+        // Complete stage for comparison; this includes setting up threads
+        // and buffers, which is a constant per run
+        const qint64 stage_start = AllocationCounter::GetTotalAllocations();
+        lic -> GenerateLIC();
+        const qint64 stage_allocations =
+            AllocationCounter::GetTotalAllocations() - stage_start;
+
+        QJsonObject result;
+        result["group"] = "allocations";
+        result["name"] = name;
+        result["pixels"] = num_pixels;
+        result["steps"] = double(workspace.steps);
+        result["allocations"] = double(allocations);
+        result["allocations_per_pixel"] = allocations / num_pixels;
+        result["generate_lic_allocations"] = double(stage_allocations);
+        result["passed"] = (allocations == 0);
+        m_Results.append(result);
+        if (allocations > 0)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("%1: %2 heap allocations while tracing %3 pixels.")
+                    .arg(name,
+                         QString::number(allocations),
+                         QString::number(num_pixels)));
+            success = false;
+        }
+        delete lic;
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Select engine and precision mode ("engine/precision") for rendering
+bool Benchmark::ConfigureVariant(LIC * mpLIC, const QString mcVariant)
+{
+    Q_UNUSED(mpLIC);
+
+    // Formulas are evaluated exactly in double precision; there is no other
+    // engine yet
+    if (mcVariant.section('/', 0, 1) != "exact/double")
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Unknown engine/precision \"%1\".").arg(mcVariant));
+        return false;
+    }
+
+    // Noise, position, and color kernels of one instruction set
+    const QString isa_name = mcVariant.section('/', 2);
+    CpuDispatch::ISA isa;
+    if (!isa_name.isEmpty() &&
+        (!CpuDispatch::ISAFromString(isa_name, isa) ||
+         !CpuDispatch::SetISA(isa)))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Instruction set \"%1\" is unknown or not supported "
+                "by this CPU.").arg(isa_name));
+        return false;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Load an example and change its resolution
+LIC * Benchmark::LoadExample(const QString mcFilename, int mWidth,
+    int mHeight)
+{
+    LIC * lic = new LIC();
+    lic -> SetProgressMode(ProgressReporter::Mode_Quiet);
+    if (!lic -> ReadXMLConfiguration(mcFilename))
+    {
+        delete lic;
+        return nullptr;
+    }
+
+    // 0 keeps the resolution of the example
+    if (mWidth > 0)
+    {
+        lic -> m_Image_Width = mWidth;
+    }
+    if (mHeight > 0)
+    {
+        lic -> m_Image_Height = mHeight;
+    }
+    for (LIC::Output & output : lic -> m_Outputs)
+    {
+        output.filename = QDir(m_TemporaryDirectory).filePath(
+            QFileInfo(output.filename).fileName());
+    }
+    return lic;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Short name of an example
+QString Benchmark::GetExampleName(const QString mcFilename)
+{
+    return QFileInfo(mcFilename).completeBaseName();
+}
+
+
+
+// ================================================================ Measurement
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Check filter
+bool Benchmark::IsSelected(const QString mcGroup, const QString mcName) const
+{
+    if (m_Filter.isEmpty())
+    {
+        return true;
+    }
+    return QString("%1/%2").arg(mcGroup, mcName).contains(m_Filter);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Time a piece of code and save the result
+void Benchmark::Measure(const QString mcGroup, const QString mcName,
+    const QString mcUnit, double mItemsPerIteration,
+    std::function < void() > mFunction)
+{
+    if (!IsSelected(mcGroup, mcName))
+    {
+        return;
+    }
+
+    // Warm up and find out how many iterations fit into the time we want
+    // to spend per repetition
+    const double target_seconds = (m_Quick ? 0.05 : 0.25);
+    const int num_repetitions = (m_Quick ? 3 : 5);
+    QElapsedTimer timer;
+    timer.start();
+    mFunction();
+    const double first_seconds = qMax(timer.nsecsElapsed() * 1e-9, 1e-9);
+    const int num_iterations =
+        qBound(1, int(target_seconds / first_seconds), 1000000);
+
+    // Measure
+    QList < double > seconds_per_iteration;
+    for (int repetition = 0; repetition < num_repetitions; repetition++)
+    {
+        timer.start();
+        for (int iteration = 0; iteration < num_iterations; iteration++)
+        {
+            mFunction();
+        }
+        seconds_per_iteration << timer.nsecsElapsed() * 1e-9 / num_iterations;
+    }
+    // Save
+    m_Results.append(CreateResult(mcGroup, mcName, mcUnit,
+        mItemsPerIteration, num_iterations, seconds_per_iteration));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Statistics of a measurement in the common result format
+QJsonObject Benchmark::CreateResult(const QString mcGroup,
+    const QString mcName, const QString mcUnit, double mItemsPerIteration,
+    int mNumIterations, QList < double > mSecondsPerIteration) const
+{
+    std::sort(mSecondsPerIteration.begin(), mSecondsPerIteration.end());
+    const double min_seconds = mSecondsPerIteration.first();
+    const double median_seconds =
+        mSecondsPerIteration[mSecondsPerIteration.size() / 2];
+    double mean_seconds = 0.;
+    for (const double seconds : mSecondsPerIteration)
+    {
+        mean_seconds += seconds;
+    }
+    mean_seconds /= mSecondsPerIteration.size();
+
+    QJsonObject result;
+    result["group"] = mcGroup;
+    result["name"] = mcName;
+    result["unit"] = mcUnit;
+    result["items_per_iteration"] = mItemsPerIteration;
+    result["iterations"] = mNumIterations;
+    result["repetitions"] = mSecondsPerIteration.size();
+    result["min_seconds"] = min_seconds;
+    result["median_seconds"] = median_seconds;
+    result["mean_seconds"] = mean_seconds;
+    result["nanoseconds_per_item"] = median_seconds * 1e9 / mItemsPerIteration;
+    result["items_per_second"] = mItemsPerIteration / median_seconds;
+
+    qDebug().noquote() << QString("%1/%2: %3 ns/%4")
+        .arg(mcGroup,
+             mcName,
+             QString::number(median_seconds * 1e9 / mItemsPerIteration, 'f',
+                 1),
+             mcUnit);
+    return result;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Time repeated runs of LIC::GenerateLIC
+Benchmark::RenderTimings Benchmark::TimeGenerateLIC(LIC * mpLIC,
+    int mNumRepetitions, PerfCounter * mpLLCMisses,
+    std::function < void() > mPrepareRun) const
+{
+    RenderTimings timings;
+    timings.best_seconds = 0.;
+    timings.best_misses = -1;
+    for (int repetition = 0; repetition < mNumRepetitions; repetition++)
+    {
+        if (mPrepareRun)
+        {
+            mPrepareRun();
+        }
+        QElapsedTimer timer;
+        if (mpLLCMisses)
+        {
+            mpLLCMisses -> Start();
+        }
+        timer.start();
+        mpLIC -> GenerateLIC();
+        const double elapsed = timer.nsecsElapsed() * 1e-9;
+        const qint64 misses = (mpLLCMisses ? mpLLCMisses -> Stop() : -1);
+        if (timings.seconds.isEmpty() ||
+            elapsed < timings.best_seconds)
+        {
+            timings.best_seconds = elapsed;
+            timings.best_misses = misses;
+        }
+        timings.seconds << elapsed;
+    }
+
+    // Pixels of the last run
+    timings.planes = mpLIC -> GetTracedPlanes();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (const QList < double > & plane : timings.planes)
+    {
+        hash.addData(QByteArray::fromRawData(
+            reinterpret_cast < const char * >(plane.constData()),
+            plane.size() * qsizetype(sizeof(double))));
+    }
+    timings.checksum = QString::fromLatin1(hash.result().toHex());
+    return timings;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Whether two renderings have the same bits
+bool Benchmark::IsIdentical(const QList < QList < double > > & mcPlanes,
+    const QList < QList < double > > & mcReference)
+{
+    if (mcPlanes.size() != mcReference.size())
+    {
+        return false;
+    }
+    for (int plane_idx = 0; plane_idx < mcPlanes.size(); plane_idx++)
+    {
+        if (mcPlanes[plane_idx].size() != mcReference[plane_idx].size() ||
+            memcmp(mcPlanes[plane_idx].constData(),
+                mcReference[plane_idx].constData(),
+                size_t(mcReference[plane_idx].size()) * sizeof(double)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+// ============================================================== Serialization
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// All results as JSON
+QJsonObject Benchmark::ToJSON() const
+{
+    QJsonObject host;
+    host["name"] = QSysInfo::machineHostName();
+    host["architecture"] = QSysInfo::currentCpuArchitecture();
+    host["os"] = QSysInfo::prettyProductName();
+    host["threads"] = QThread::idealThreadCount();
+
+    QJsonObject json;
+    json["schema"] = "lic-benchmark";
+    json["schema_version"] = BENCHMARK_SCHEMA_VERSION;
+    json["timestamp"] =
+        QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["quick"] = m_Quick;
+    json["host"] = host;
+    json["results"] = m_Results;
+    return json;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write results to file
+bool Benchmark::WriteJSON(const QString mcFilename) const
+{
+    QFile output_file(mcFilename);
+    if (!output_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Results file \"%1\" could not be written.")
+                .arg(mcFilename));
+        return false;
+    }
+    output_file.write(QJsonDocument(ToJSON()).toJson(QJsonDocument::Indented));
+    output_file.close();
+    return true;
+}
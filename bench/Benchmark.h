@@ -0,0 +1,190 @@
+// Benchmark.h
+// Class definition
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// Qt includes
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+// System includes
+#include <functional>
+
+// Forward declaration
+class LIC;
+class PerfCounter;
+
+
+
+// Define class
+class Benchmark
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    Benchmark();
+
+    // Destructor
+    virtual ~Benchmark();
+
+
+
+    // ========================================================== Configuration
+public:
+    // Directory with the Example-*.xml configurations
+    bool SetExamplesDirectory(const QString mcDirectory);
+
+    // LIC executable for the startup benchmark
+    void SetApplication(const QString mcFilename);
+
+    // Only run benchmarks whose "group/name" contains this text
+    void SetFilter(const QString mcFilter);
+
+    // Shorter measurements and smaller images
+    void SetQuick(bool mQuick);
+
+private:
+    QStringList m_ExampleFiles;
+    QString m_ApplicationFilename;
+    QString m_Filter;
+    bool m_Quick;
+    QString m_TemporaryDirectory;
+
+
+
+    // ============================================================= Benchmarks
+public:
+    // Run all benchmarks
+    void Run();
+
+    // Thread scaling of GenerateLIC with 1, 2, 4, ..., mMaxThreads threads
+    // (0: one per core)
+    void RunScaling(int mMaxThreads);
+
+    // GenerateLIC with mMaxThreads threads (0: one per core) and with as
+    // many worker processes, and whether both give the same pixels
+    void RunBackends(int mMaxThreads);
+
+    // GenerateLIC with buffers first touched by the main thread, placed on
+    // the nodes of the threads using them, and placed with pinned threads
+    // (on hosts with one memory node, all three are the same)
+    void RunNUMA(int mMaxThreads);
+
+    // Render the examples at reduced resolution and compare them with the
+    // golden images in mcGoldenDirectory (quality and runtime). With
+    // mUpdate, golden images and runtime budgets are recorded instead.
+    // Checks without a recorded golden image or budget fail with mStrict
+    // and are skipped otherwise; variants with kernels this CPU can't run
+    // are always skipped. Returns false if any example fails.
+    bool RunGolden(const QString mcGoldenDirectory, bool mUpdate,
+        bool mStrict);
+
+    // Trace the examples with a warmed-up workspace and count heap
+    // allocations per pixel (needs a build with "CONFIG+=alloc_count").
+    // Returns false if the hot path allocates.
+    bool RunAllocationCheck();
+
+private:
+    // AbstractFunction::CreateFunction
+    void RunParserBenchmarks();
+
+    // AbstractFunction::Evaluate for each Function_* type and the examples
+    void RunEvaluatorBenchmarks();
+
+    // LIC::EvaluateVectorfield
+    void RunVectorfieldBenchmarks();
+
+    // Streamline tracing per pixel
+    void RunTracerBenchmarks();
+
+    // LIC::GenerateNoise for each background type
+    void RunNoiseBenchmarks();
+
+    // LIC::GenerateImage (normalization, coloring, PNG encoding)
+    void RunEncoderBenchmarks();
+
+    // Complete runs of the examples at several resolutions
+    void RunEndToEndBenchmarks();
+
+    // Process startup of the LIC executable, with and without a tiny
+    // render
+    void RunStartupBenchmarks();
+
+    // Run the LIC executable once in a directory; false (with the reason)
+    // if it fails to start or exits with an error
+    static bool RunApplication(const QString mcFilename,
+        const QStringList mcArguments, const QString mcWorkingDirectory,
+        QString & mrError);
+
+    // Load an example and change its resolution; output goes to a
+    // temporary directory
+    LIC * LoadExample(const QString mcFilename, int mWidth, int mHeight);
+
+    // Select engine, precision mode, and optionally the instruction set of
+    // the kernels ("engine/precision[/isa]") for rendering
+    bool ConfigureVariant(LIC * mpLIC, const QString mcVariant);
+
+    // Short name of an example ("Example-1")
+    static QString GetExampleName(const QString mcFilename);
+
+
+
+    // ============================================================ Measurement
+private:
+    // Check filter
+    bool IsSelected(const QString mcGroup, const QString mcName) const;
+
+    // Time a piece of code and save the result. mItemsPerIteration is the
+    // number of items (evaluations, pixels...) processed by one call.
+    void Measure(const QString mcGroup, const QString mcName,
+        const QString mcUnit, double mItemsPerIteration,
+        std::function < void() > mFunction);
+
+    // Statistics of a measurement in the common result format
+    QJsonObject CreateResult(const QString mcGroup, const QString mcName,
+        const QString mcUnit, double mItemsPerIteration, int mNumIterations,
+        QList < double > mSecondsPerIteration) const;
+
+    // Repeated runs of LIC::GenerateLIC
+    struct RenderTimings
+    {
+        // Seconds of every run
+        QList < double > seconds;
+
+        // Fastest run and its last level cache misses (-1: not counted)
+        double best_seconds;
+        qint64 best_misses;
+
+        // Traced planes of the last run, and their SHA-256
+        QList < QList < double > > planes;
+        QString checksum;
+    };
+
+    // Time mNumRepetitions runs of GenerateLIC. mpLLCMisses counts cache
+    // misses if given; mPrepareRun is called before every run, untimed.
+    RenderTimings TimeGenerateLIC(LIC * mpLIC, int mNumRepetitions,
+        PerfCounter * mpLLCMisses = nullptr,
+        std::function < void() > mPrepareRun = nullptr) const;
+
+    // Whether two renderings have the same bits; unlike comparing the
+    // values, NaN pixels compare equal
+    static bool IsIdentical(const QList < QList < double > > & mcPlanes,
+        const QList < QList < double > > & mcReference);
+
+    QJsonArray m_Results;
+
+
+
+    // ========================================================== Serialization
+public:
+    // All results as JSON
+    QJsonObject ToJSON() const;
+
+    // Write results to file
+    bool WriteJSON(const QString mcFilename) const;
+};
+
+#endif
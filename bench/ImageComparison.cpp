@@ -0,0 +1,170 @@
+// ImageComparison.cpp
+// Class implementation
+
+// Project includes
+#include "ImageComparison.h"
+
+// Qt includes
+#include <QList>
+
+// System includes
+#include <cmath>
+
+
+
+// Size of and distance between windows for SSIM
+static const int SSIM_WINDOW = 8;
+static const int SSIM_STRIDE = 4;
+
+// Stabilizing constants for SSIM (8 bit dynamic range)
+static const double SSIM_C1 = (0.01 * 255) * (0.01 * 255);
+static const double SSIM_C2 = (0.03 * 255) * (0.03 * 255);
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Luminance of an image
+static QList < double > GetLuminance(const QImage & mcrImage)
+{
+    const QImage image = mcrImage.convertToFormat(QImage::Format_RGB32);
+    QList < double > luminance(image.width() * image.height());
+    for (int iy = 0; iy < image.height(); iy++)
+    {
+        const QRgb * line =
+            reinterpret_cast < const QRgb * >(image.constScanLine(iy));
+        for (int ix = 0; ix < image.width(); ix++)
+        {
+            luminance[iy * image.width() + ix] = 0.299 * qRed(line[ix]) +
+                0.587 * qGreen(line[ix]) + 0.114 * qBlue(line[ix]);
+        }
+    }
+    return luminance;
+}
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+ImageComparison::ImageComparison()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+ImageComparison::~ImageComparison()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Peak signal-to-noise ratio
+double ImageComparison::PSNR(const QImage & mcrImage1,
+    const QImage & mcrImage2)
+{
+    if (mcrImage1.width() != mcrImage2.width() ||
+        mcrImage1.height() != mcrImage2.height() ||
+        mcrImage1.isNull())
+    {
+        return 0.;
+    }
+
+    const QImage image1 = mcrImage1.convertToFormat(QImage::Format_RGB32);
+    const QImage image2 = mcrImage2.convertToFormat(QImage::Format_RGB32);
+    double sum_squares = 0.;
+    for (int iy = 0; iy < image1.height(); iy++)
+    {
+        const QRgb * line1 =
+            reinterpret_cast < const QRgb * >(image1.constScanLine(iy));
+        const QRgb * line2 =
+            reinterpret_cast < const QRgb * >(image2.constScanLine(iy));
+        for (int ix = 0; ix < image1.width(); ix++)
+        {
+            const double delta_r = qRed(line1[ix]) - qRed(line2[ix]);
+            const double delta_g = qGreen(line1[ix]) - qGreen(line2[ix]);
+            const double delta_b = qBlue(line1[ix]) - qBlue(line2[ix]);
+            sum_squares +=
+                delta_r * delta_r + delta_g * delta_g + delta_b * delta_b;
+        }
+    }
+    const double mse =
+        sum_squares / (3. * image1.width() * image1.height());
+    if (mse <= 0.)
+    {
+        return MAX_PSNR;
+    }
+    return qMin(MAX_PSNR, 10. * log10(255. * 255. / mse));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Mean structural similarity
+double ImageComparison::SSIM(const QImage & mcrImage1,
+    const QImage & mcrImage2)
+{
+    const int width = mcrImage1.width();
+    const int height = mcrImage1.height();
+    if (width != mcrImage2.width() ||
+        height != mcrImage2.height() ||
+        width < SSIM_WINDOW ||
+        height < SSIM_WINDOW)
+    {
+        return 0.;
+    }
+
+    const QList < double > luminance1 = GetLuminance(mcrImage1);
+    const QList < double > luminance2 = GetLuminance(mcrImage2);
+    const double num_window_pixels = SSIM_WINDOW * SSIM_WINDOW;
+    double sum_ssim = 0.;
+    int num_windows = 0;
+    for (int y0 = 0; y0 + SSIM_WINDOW <= height; y0 += SSIM_STRIDE)
+    {
+        for (int x0 = 0; x0 + SSIM_WINDOW <= width; x0 += SSIM_STRIDE)
+        {
+            // Means, variances, and covariance in this window
+            double sum1 = 0.;
+            double sum2 = 0.;
+            double sum11 = 0.;
+            double sum22 = 0.;
+            double sum12 = 0.;
+            for (int iy = y0; iy < y0 + SSIM_WINDOW; iy++)
+            {
+                for (int ix = x0; ix < x0 + SSIM_WINDOW; ix++)
+                {
+                    const double value1 = luminance1[iy * width + ix];
+                    const double value2 = luminance2[iy * width + ix];
+                    sum1 += value1;
+                    sum2 += value2;
+                    sum11 += value1 * value1;
+                    sum22 += value2 * value2;
+                    sum12 += value1 * value2;
+                }
+            }
+            const double mean1 = sum1 / num_window_pixels;
+            const double mean2 = sum2 / num_window_pixels;
+            const double variance1 = sum11 / num_window_pixels - mean1 * mean1;
+            const double variance2 = sum22 / num_window_pixels - mean2 * mean2;
+            const double covariance =
+                sum12 / num_window_pixels - mean1 * mean2;
+            sum_ssim += ((2. * mean1 * mean2 + SSIM_C1) *
+                    (2. * covariance + SSIM_C2)) /
+                ((mean1 * mean1 + mean2 * mean2 + SSIM_C1) *
+                    (variance1 + variance2 + SSIM_C2));
+            num_windows++;
+        }
+    }
+    return sum_ssim / num_windows;
+}
@@ -0,0 +1,39 @@
+// ImageComparison.h
+// Class definition
+
+#ifndef IMAGECOMPARISON_H
+#define IMAGECOMPARISON_H
+
+// Qt includes
+#include <QImage>
+
+
+
+// Define class
+class ImageComparison
+{
+    // ============================================================== Lifecycle
+private:
+    // Constructor; only static methods
+    ImageComparison();
+
+public:
+    // Destructor
+    virtual ~ImageComparison();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Peak signal-to-noise ratio over all color channels in dB. Identical
+    // images yield MAX_PSNR; images of different size yield 0.
+    static double PSNR(const QImage & mcrImage1, const QImage & mcrImage2);
+
+    // Mean structural similarity of the luminance (1 = identical)
+    static double SSIM(const QImage & mcrImage1, const QImage & mcrImage2);
+
+    // PSNR reported for identical images
+    static constexpr double MAX_PSNR = 100.;
+};
+
+#endif
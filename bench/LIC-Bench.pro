@@ -0,0 +1,36 @@
+# Benchmarks for LIC
+
+# === Where files go
+OBJECTS_DIR = build/
+MOC_DIR = build/
+
+# === Frameworks and compiler
+TEMPLATE = app
+TARGET = LIC-Bench
+CONFIG -= app_bundle
+DEPENDPATH += .
+
+# Core classes
+include(../LIC.pri)
+
+# Benchmarks
+INCLUDEPATH += $$PWD
+HEADERS += Benchmark.h
+SOURCES += Benchmark.cpp
+HEADERS += ImageComparison.h
+SOURCES += ImageComparison.cpp
+HEADERS += PerfCounter.h
+SOURCES += PerfCounter.cpp
+SOURCES += main.cpp
+
+# === Checks
+# "make check" renders the examples and compares them with the golden
+# images and runtime budgets in golden/; a missing one is a failure.
+# "make golden" records them on the reference host.
+check.commands = ./$(TARGET) --examples $$PWD/../examples \
+    --golden $$PWD/golden --quick --strict
+check.depends = $(TARGET)
+golden.commands = ./$(TARGET) --examples $$PWD/../examples \
+    --golden $$PWD/golden --quick --update-golden
+golden.depends = $(TARGET)
+QMAKE_EXTRA_TARGETS += check golden
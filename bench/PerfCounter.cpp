@@ -0,0 +1,126 @@
+// PerfCounter.cpp
+// Class implementation
+
+// Project includes
+#include "PerfCounter.h"
+
+// System includes
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+PerfCounter::PerfCounter(Event mEvent)
+{
+    m_FileDescriptor = -1;
+
+#ifdef __linux__
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = (mEvent == Event_LLCMisses ?
+        PERF_COUNT_HW_CACHE_MISSES : PERF_COUNT_HW_CACHE_REFERENCES);
+    attributes.disabled = 1;
+    attributes.inherit = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    // This process (and its threads) on any CPU
+    m_FileDescriptor = int(syscall(SYS_perf_event_open, &attributes, 0, -1,
+        -1, 0));
+    if (m_FileDescriptor < 0)
+    {
+        m_Error = QString("perf_event_open() failed: %1")
+            .arg(strerror(errno));
+    }
+#else
+    Q_UNUSED(mEvent);
+    m_Error = "Hardware counters are only supported on Linux.";
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+PerfCounter::~PerfCounter()
+{
+#ifdef __linux__
+    if (m_FileDescriptor >= 0)
+    {
+        close(m_FileDescriptor);
+    }
+#endif
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Check if hardware events can be counted
+bool PerfCounter::IsAvailable() const
+{
+    return (m_FileDescriptor >= 0);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Why the counter isn't available
+QString PerfCounter::GetError() const
+{
+    return m_Error;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Start counting
+void PerfCounter::Start()
+{
+#ifdef __linux__
+    if (m_FileDescriptor >= 0)
+    {
+        ioctl(m_FileDescriptor, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_FileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Stop counting and return the number of events
+qint64 PerfCounter::Stop()
+{
+#ifdef __linux__
+    if (m_FileDescriptor >= 0)
+    {
+        ioctl(m_FileDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+        // Counts of threads that have finished are included
+        long long count = 0;
+        if (read(m_FileDescriptor, &count, sizeof(count)) == sizeof(count))
+        {
+            return qint64(count);
+        }
+    }
+#endif
+    return -1;
+}
@@ -0,0 +1,52 @@
+// PerfCounter.h
+// Class definition
+
+#ifndef PERFCOUNTER_H
+#define PERFCOUNTER_H
+
+// Qt includes
+#include <QString>
+
+
+
+// Define class
+class PerfCounter
+{
+    // ============================================================== Lifecycle
+public:
+    // Hardware events that can be counted
+    enum Event
+    {
+        Event_LLCMisses,
+        Event_LLCReferences
+    };
+
+    // Constructor
+    PerfCounter(Event mEvent);
+
+    // Destructor
+    virtual ~PerfCounter();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Counting hardware events needs perf_event_open(), which may not be
+    // permitted (see /proc/sys/kernel/perf_event_paranoid) or supported
+    bool IsAvailable() const;
+
+    // Why the counter isn't available
+    QString GetError() const;
+
+    // Start counting; threads created afterwards are included
+    void Start();
+
+    // Stop counting and return the number of events
+    qint64 Stop();
+
+private:
+    int m_FileDescriptor;
+    QString m_Error;
+};
+
+#endif
@@ -0,0 +1,188 @@
+// main.cpp
+// Benchmarks
+
+// Project includes
+#include "Benchmark.h"
+#include "CpuDispatch.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonDocument>
+
+// System includes
+#include <cstdio>
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Main
+int main(int mNumParameters, char * mpParameter[])
+{
+    // Application
+    QCoreApplication app(mNumParameters, mpParameter);
+
+    // Parse command line
+    QString examples_directory = "examples";
+    QString application_filename;
+    QString output_filename;
+    QString filter;
+    bool quick = false;
+    bool scaling = false;
+    bool backends = false;
+    bool numa = false;
+    int max_threads = 0;
+    QString golden_directory;
+    bool update_golden = false;
+    bool strict_golden = false;
+    bool check_allocations = false;
+    const QStringList arguments = app.arguments();
+    for (int idx = 1; idx < arguments.size(); idx++)
+    {
+        const QString argument = arguments[idx];
+        if (argument == "--examples" &&
+            idx + 1 < arguments.size())
+        {
+            examples_directory = arguments[++idx];
+            continue;
+        }
+        if (argument == "--application" &&
+            idx + 1 < arguments.size())
+        {
+            application_filename = arguments[++idx];
+            continue;
+        }
+        if (argument == "--output" &&
+            idx + 1 < arguments.size())
+        {
+            output_filename = arguments[++idx];
+            continue;
+        }
+        if (argument == "--filter" &&
+            idx + 1 < arguments.size())
+        {
+            filter = arguments[++idx];
+            continue;
+        }
+        if (argument == "--quick")
+        {
+            quick = true;
+            continue;
+        }
+        if (argument == "--scaling")
+        {
+            scaling = true;
+            continue;
+        }
+        if (argument == "--backends")
+        {
+            backends = true;
+            continue;
+        }
+        if (argument == "--numa")
+        {
+            numa = true;
+            continue;
+        }
+        if (argument == "--isa" &&
+            idx + 1 < arguments.size())
+        {
+            // Kernels of every run, e.g. to compare them with the golden
+            // images of another host
+            CpuDispatch::ISA isa = CpuDispatch::ISA_Generic;
+            if (!CpuDispatch::ISAFromString(arguments[++idx], isa) ||
+                !CpuDispatch::SetISA(isa))
+            {
+                qDebug().noquote() <<
+                    QString("Instruction set \"%1\" is unknown or not "
+                        "supported by this CPU.").arg(arguments[idx]);
+                return 1;
+            }
+            continue;
+        }
+        if (argument == "--golden" &&
+            idx + 1 < arguments.size())
+        {
+            golden_directory = arguments[++idx];
+            continue;
+        }
+        if (argument == "--update-golden")
+        {
+            update_golden = true;
+            continue;
+        }
+        if (argument == "--strict")
+        {
+            strict_golden = true;
+            continue;
+        }
+        if (argument == "--check-allocations")
+        {
+            check_allocations = true;
+            continue;
+        }
+        if (argument == "--max-threads" &&
+            idx + 1 < arguments.size())
+        {
+            max_threads = arguments[++idx].toInt();
+            continue;
+        }
+        const QString command_name = mpParameter[0];
+        qDebug().noquote() <<
+            QString("Usage: %1 [--examples directory] [--application LIC] "
+                "[--output results.json] "
+                "[--filter text] [--quick] "
+                "[--scaling|--backends|--numa [--max-threads n]] "
+                "[--isa generic|sse4.2|avx2|avx512] "
+                "[--golden directory [--update-golden|--strict]] "
+                "[--check-allocations]\n")
+                .arg(command_name);
+        return 1;
+    }
+
+    // Run
+    Benchmark benchmark;
+    if (!benchmark.SetExamplesDirectory(examples_directory))
+    {
+        return 1;
+    }
+    if (!application_filename.isEmpty())
+    {
+        benchmark.SetApplication(application_filename);
+    }
+    benchmark.SetFilter(filter);
+    benchmark.SetQuick(quick);
+    bool success = true;
+    if (check_allocations)
+    {
+        success = benchmark.RunAllocationCheck();
+    } else if (!golden_directory.isEmpty())
+    {
+        success = benchmark.RunGolden(golden_directory, update_golden,
+            strict_golden);
+    } else if (scaling)
+    {
+        benchmark.RunScaling(max_threads);
+    } else if (backends)
+    {
+        benchmark.RunBackends(max_threads);
+    } else if (numa)
+    {
+        benchmark.RunNUMA(max_threads);
+    } else
+    {
+        benchmark.Run();
+    }
+
+    // Results
+    if (output_filename.isEmpty())
+    {
+        const QByteArray json =
+            QJsonDocument(benchmark.ToJSON()).toJson(QJsonDocument::Indented);
+        fwrite(json.constData(), 1, json.size(), stdout);
+    } else if (!benchmark.WriteJSON(output_filename))
+    {
+        success = false;
+    }
+    return (success ? 0 : 1);
+}
@@ -0,0 +1,19 @@
+# LIC as a shared library: C++ interface in LIC.h, plain C interface in
+# liblic.h
+
+# === Where files go
+OBJECTS_DIR = build/
+MOC_DIR = build/
+
+# === Frameworks and compiler
+TEMPLATE = lib
+TARGET = lic
+CONFIG += shared
+DEPENDPATH += .
+
+# Core classes
+include(../LIC.pri)
+
+# C interface
+HEADERS += $$PWD/../src/liblic.h
+SOURCES += $$PWD/../src/liblic.cpp
@@ -35,8 +35,12 @@ public:
     // Serialize to String
     virtual QString ToString() const = 0;
 
+    // Deep copy; shares nothing with the original, so copies can be placed
+    // on other memory nodes
+    virtual AbstractFunction * Clone() const = 0;
+
     // Evaluate
-    virtual double Evaluate(const QHash < QString, double > mcVariables
+    virtual double Evaluate(const QHash < QString, double > & mcVariables
         ) const = 0;
 
 protected:
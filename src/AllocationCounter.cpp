@@ -0,0 +1,177 @@
+// AllocationCounter.cpp
+// Class implementation
+
+// Project includes
+#include "AllocationCounter.h"
+
+// System includes
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+
+
+#ifdef LIC_COUNT_ALLOCATIONS
+
+// Counters
+static std::atomic < qint64 > total_allocations(0);
+static thread_local qint64 thread_allocations = 0;
+
+static inline void CountAllocation()
+{
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    thread_allocations++;
+}
+
+#ifdef __GLIBC__
+
+// With glibc, malloc itself can be replaced; this also catches Qt's
+// containers and strings, which don't use operator new
+extern "C"
+{
+    void * __libc_malloc(size_t mSize);
+    void * __libc_calloc(size_t mNumber, size_t mSize);
+    void * __libc_realloc(void * mpMemory, size_t mSize);
+    void * __libc_memalign(size_t mAlignment, size_t mSize);
+
+    void * malloc(size_t mSize) noexcept
+    {
+        CountAllocation();
+        return __libc_malloc(mSize);
+    }
+
+    void * calloc(size_t mNumber, size_t mSize) noexcept
+    {
+        CountAllocation();
+        return __libc_calloc(mNumber, mSize);
+    }
+
+    void * realloc(void * mpMemory, size_t mSize) noexcept
+    {
+        CountAllocation();
+        return __libc_realloc(mpMemory, mSize);
+    }
+
+    void * aligned_alloc(size_t mAlignment, size_t mSize) noexcept
+    {
+        CountAllocation();
+        return __libc_memalign(mAlignment, mSize);
+    }
+
+    int posix_memalign(void ** mppMemory, size_t mAlignment,
+        size_t mSize) noexcept
+    {
+        CountAllocation();
+        *mppMemory = __libc_memalign(mAlignment, mSize);
+        return (*mppMemory ? 0 : ENOMEM);
+    }
+}
+
+#else
+
+// Elsewhere, only allocations through operator new are counted
+void * operator new(size_t mSize)
+{
+    CountAllocation();
+    void * memory = std::malloc(mSize ? mSize : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void * operator new[](size_t mSize)
+{
+    return operator new(mSize);
+}
+
+void operator delete(void * mpMemory) noexcept
+{
+    std::free(mpMemory);
+}
+
+void operator delete[](void * mpMemory) noexcept
+{
+    std::free(mpMemory);
+}
+
+void operator delete(void * mpMemory, size_t) noexcept
+{
+    std::free(mpMemory);
+}
+
+void operator delete[](void * mpMemory, size_t) noexcept
+{
+    std::free(mpMemory);
+}
+
+#endif
+
+#endif
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+AllocationCounter::AllocationCounter()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+AllocationCounter::~AllocationCounter()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// If allocations are being counted in this build
+bool AllocationCounter::IsEnabled()
+{
+#ifdef LIC_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of allocations by all threads so far
+qint64 AllocationCounter::GetTotalAllocations()
+{
+#ifdef LIC_COUNT_ALLOCATIONS
+    return total_allocations.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of allocations by the calling thread so far
+qint64 AllocationCounter::GetThreadAllocations()
+{
+#ifdef LIC_COUNT_ALLOCATIONS
+    return thread_allocations;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,44 @@
+// AllocationCounter.h
+// Class definition
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+// Qt includes
+#include <QtGlobal>
+
+
+
+// Counting heap allocations is only compiled in with
+//   qmake CONFIG+=alloc_count
+// which defines LIC_COUNT_ALLOCATIONS. Without it, all counts are 0.
+
+
+
+// Define class
+class AllocationCounter
+{
+    // ============================================================== Lifecycle
+private:
+    // Constructor; only static methods
+    AllocationCounter();
+
+public:
+    // Destructor
+    virtual ~AllocationCounter();
+
+
+
+    // ========================================================== Functionality
+public:
+    // If allocations are being counted in this build
+    static bool IsEnabled();
+
+    // Number of allocations by all threads so far
+    static qint64 GetTotalAllocations();
+
+    // Number of allocations by the calling thread so far
+    static qint64 GetThreadAllocations();
+};
+
+#endif
@@ -0,0 +1,433 @@
+// Autotuner.cpp
+// Class implementation
+
+// Project includes
+#include "AbstractFunction.h"
+#include "Autotuner.h"
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "ProcessPool.h"
+#include "SimdKernels.h"
+
+// Qt includes
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QThread>
+
+// System includes
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+
+// Tiles of every size that is tried cover whole blocks of this size, so
+// all settings trace the same pixels
+static const int SAMPLE_BLOCK_SIZE = 128;
+
+// The sample is this fraction of the blocks, but at least two blocks per
+// thread, so every thread has work with the largest tiles
+static const int SAMPLE_FRACTION = 64;
+static const int MIN_SAMPLE_BLOCKS_PER_THREAD = 2;
+
+// Settings only replace the best so far if they are faster by more than
+// the noise of a measurement
+static const double MIN_SPEEDUP = 1.03;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+Autotuner::Autotuner(LIC * mpLIC)
+{
+    m_LIC = mpLIC;
+    m_CacheFilename = QString("%1/.cache/LIC/tuning-%2.json")
+        .arg(QDir::homePath(), QSysInfo::machineHostName());
+    m_NumBlocksX = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+Autotuner::~Autotuner()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File the tuned settings are kept in
+void Autotuner::SetCacheFilename(const QString mcFilename)
+{
+    m_CacheFilename = mcFilename;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File the tuned settings are kept in
+QString Autotuner::GetCacheFilename() const
+{
+    return m_CacheFilename;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Find the fastest settings for this configuration on this host
+bool Autotuner::Execute()
+{
+    LIC & lic = *m_LIC;
+    PerformanceReport & report = lic.GetMutablePerformanceReport();
+    lic.ResetCancel();
+    report.StartStage("Autotune");
+
+    // Calibration renders don't show progress
+    const ProgressReporter::Mode progress_mode = lic.GetProgressMode();
+    lic.SetProgressMode(ProgressReporter::Mode_Quiet);
+    lic.GenerateNoise();
+
+    // Sample of the blocks the traced pixels are in, spread over the image
+    // the same way in every run
+    const QRect rect = (lic.GetTraceRect().isEmpty() ?
+        QRect(0, 0, lic.GetImageWidth(), lic.GetImageHeight()) :
+        lic.GetTraceRect());
+    m_NumBlocksX =
+        (lic.GetImageWidth() + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
+    const int num_blocks_y =
+        (lic.GetImageHeight() + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE;
+    QList < QPair < double, int > > order;
+    for (int block_x = rect.left() / SAMPLE_BLOCK_SIZE;
+         block_x <= rect.right() / SAMPLE_BLOCK_SIZE;
+         block_x++)
+    {
+        for (int block_y = rect.top() / SAMPLE_BLOCK_SIZE;
+             block_y <= rect.bottom() / SAMPLE_BLOCK_SIZE;
+             block_y++)
+        {
+            order << QPair < double, int >(
+                SimdKernels::GetPositionNoise(0, block_x, block_y),
+                block_y * m_NumBlocksX + block_x);
+        }
+    }
+    std::sort(order.begin(), order.end());
+    const int max_threads = QThread::idealThreadCount();
+    const int num_sample = qMin(int(order.size()),
+        qMax(int(order.size()) / SAMPLE_FRACTION,
+            MIN_SAMPLE_BLOCKS_PER_THREAD * max_threads));
+    m_SampleBlocks.fill(false, m_NumBlocksX * num_blocks_y);
+    for (int order_idx = 0; order_idx < num_sample; order_idx++)
+    {
+        m_SampleBlocks[order[order_idx].second] = true;
+    }
+    m_Reference.clear();
+
+    // Current settings; the first measurement also warms up caches and
+    // gives the reference pixels
+    Settings best;
+    best.tile_size = lic.GetTileSize();
+    best.tile_interleave = lic.GetTileInterleave();
+    best.num_threads = lic.GetNumThreads();
+    best.backend = lic.GetBackend();
+    double best_seconds = Measure(best);
+    if (best_seconds >= 0)
+    {
+        best_seconds = Measure(best);
+    }
+    if (best_seconds < 0)
+    {
+        lic.SetProgressMode(progress_mode);
+        report.EndStage("Autotune");
+        MessageLogger::Error(METHOD_NAME, "Calibration has been cancelled.");
+        return false;
+    }
+    qDebug().noquote() << QString("Autotune: %1: %2 s")
+        .arg(ToString(best), QString::number(best_seconds, 'f', 3));
+
+    // Settings are tuned one after the other, starting with the one that
+    // makes the largest difference
+    auto consider = [this, &best, &best_seconds](const Settings & mcSettings)
+    {
+        if (ToString(mcSettings) == ToString(best))
+        {
+            return;
+        }
+        const double seconds = Measure(mcSettings);
+        qDebug().noquote() << QString("Autotune: %1: %2")
+            .arg(ToString(mcSettings), (seconds < 0 ? QString("rejected") :
+                QString("%1 s").arg(QString::number(seconds, 'f', 3))));
+        if (seconds >= 0 &&
+            seconds * MIN_SPEEDUP < best_seconds)
+        {
+            best = mcSettings;
+            best_seconds = seconds;
+        }
+    };
+
+    // Backend and threads; hyperthreads don't always help
+    QList < Settings > engines;
+    for (int num_threads : { max_threads, qMax(max_threads / 2, 1) })
+    {
+        Settings settings = best;
+        settings.backend = LIC::Backend_Threads;
+        settings.num_threads = num_threads;
+        engines << settings;
+    }
+    if (ProcessPool::IsAvailable())
+    {
+        Settings settings = best;
+        settings.backend = LIC::Backend_Processes;
+        settings.num_threads = max_threads;
+        engines << settings;
+    }
+    for (const Settings & settings : engines)
+    {
+        consider(settings);
+    }
+
+    // Tile size: small tiles balance the load, large ones have fewer items
+    for (int tile_size : { 32, 64, 128 })
+    {
+        Settings settings = best;
+        settings.tile_size = tile_size;
+        consider(settings);
+    }
+
+    // Order of the tiles: interleaved, or row by row
+    for (int tile_interleave : { 16, 1 })
+    {
+        Settings settings = best;
+        settings.tile_interleave = tile_interleave;
+        consider(settings);
+    }
+    lic.SetProgressMode(progress_mode);
+    m_Reference.clear();
+    Apply(best, "autotuned");
+    report.EndStage("Autotune");
+    qDebug().noquote() << QString("Autotune: using %1 for \"%2\".")
+        .arg(ToString(best), GetKey());
+
+    // Keep the settings for later runs
+    QJsonObject entry;
+    entry["tile_size"] = best.tile_size;
+    entry["tile_interleave"] = best.tile_interleave;
+    entry["threads"] = best.num_threads;
+    entry["backend"] = (best.backend == LIC::Backend_Processes ?
+        "processes" : "threads");
+    entry["sample_seconds"] = best_seconds;
+    entry["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    QJsonObject cache = ReadCache();
+    cache[GetKey()] = entry;
+    QSaveFile cache_file(m_CacheFilename);
+    if (!QDir().mkpath(QFileInfo(m_CacheFilename).path()) ||
+        !cache_file.open(QIODevice::WriteOnly) ||
+        cache_file.write(QJsonDocument(cache).toJson(QJsonDocument::Indented))
+            < 0 ||
+        !cache_file.commit())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Tuning cache \"%1\" could not be written.")
+                .arg(m_CacheFilename));
+        return false;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Apply the settings tuned earlier
+bool Autotuner::ApplyCached()
+{
+    const QJsonObject entry = ReadCache()[GetKey()].toObject();
+    Settings settings;
+    settings.tile_size = entry["tile_size"].toInt();
+    settings.tile_interleave = entry["tile_interleave"].toInt();
+    settings.num_threads = entry["threads"].toInt();
+    if (settings.tile_size < 1 ||
+        settings.tile_interleave < 1 ||
+        settings.num_threads < 1 ||
+        !LIC::BackendFromString(entry["backend"].toString(),
+            settings.backend))
+    {
+        return false;
+    }
+    Apply(settings, "cached");
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configurations sharing their settings
+QString Autotuner::GetKey() const
+{
+    // Cost of an evaluation of the vector field
+    const LIC & lic = *m_LIC;
+    const QPair < QString, QString > formulas =
+        lic.GetVectorfieldFormulas();
+    const qint64 operations =
+        (CountOperations(formulas.first) + CountOperations(formulas.second)) *
+        qint64(lic.GetVectorfieldIterations());
+
+    // Pixels, in units of 256 x 256
+    const qint64 pixels = qint64(lic.GetImageWidth()) * lic.GetImageHeight();
+    return QString("c%1-r%2").arg(QString::number(GetClass(operations)),
+        QString::number(GetClass(pixels >> 16)));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Apply settings to the renderer
+void Autotuner::Apply(const Settings & mcSettings, const QString mcSource)
+{
+    LIC & lic = *m_LIC;
+    lic.SetTileSize(mcSettings.tile_size);
+    lic.SetTileInterleave(mcSettings.tile_interleave);
+    lic.SetNumThreads(mcSettings.num_threads);
+    lic.SetBackend(mcSettings.backend);
+
+    PerformanceReport & report = lic.GetMutablePerformanceReport();
+    report.SetInfo("tuning", mcSource);
+    report.SetInfo("tuning_key", GetKey());
+    report.SetInfo("tile_size", mcSettings.tile_size);
+    report.SetInfo("tile_interleave", mcSettings.tile_interleave);
+    report.SetInfo("threads", mcSettings.num_threads);
+    report.SetInfo("backend", (mcSettings.backend == LIC::Backend_Processes ?
+        "processes" : "threads"));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Settings in a notice
+QString Autotuner::ToString(const Settings & mcSettings) const
+{
+    return QString("tiles %1, %2 passes, %3 %4")
+        .arg(QString::number(mcSettings.tile_size),
+            QString::number(mcSettings.tile_interleave),
+            QString::number(mcSettings.num_threads),
+            (mcSettings.backend == LIC::Backend_Processes ?
+                "processes" : "threads"));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace the sample with some settings
+double Autotuner::Measure(const Settings & mcSettings)
+{
+    LIC & lic = *m_LIC;
+    lic.SetTileSize(mcSettings.tile_size);
+    lic.SetTileInterleave(mcSettings.tile_interleave);
+    lic.SetNumThreads(mcSettings.num_threads);
+    lic.SetBackend(mcSettings.backend);
+
+    // Pixels that aren't traced stay NaN, so they are found below
+    const double nan = std::numeric_limits < double >::quiet_NaN();
+    lic.AdoptTracedPlanes(QList < QList < double > >(4,
+        QList < double >(qsizetype(lic.GetImageWidth()) *
+            lic.GetImageHeight(), nan)));
+
+    // Only the tiles in the blocks of the sample
+    QList < bool > tiles_done(lic.GetNumTiles(), true);
+    for (int tile = 0; tile < tiles_done.size(); tile++)
+    {
+        const QRect pixels = lic.GetTilePixels(tile, QRect());
+        tiles_done[tile] =
+            !m_SampleBlocks[(pixels.top() / SAMPLE_BLOCK_SIZE) * m_NumBlocksX +
+                pixels.left() / SAMPLE_BLOCK_SIZE];
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (!lic.TraceTargets({ lic.GetImageTarget() }, lic.GetTraceRect(),
+        &tiles_done))
+    {
+        return -1;
+    }
+    const double seconds = timer.nsecsElapsed() * 1e-9;
+
+    // Every setting has to give the same pixels as the first one
+    const QList < QList < double > > planes = lic.GetTracedPlanes();
+    if (m_Reference.isEmpty())
+    {
+        m_Reference = planes;
+        return seconds;
+    }
+    for (int plane_idx = 0; plane_idx < planes.size(); plane_idx++)
+    {
+        if (memcmp(planes[plane_idx].constData(),
+            m_Reference[plane_idx].constData(),
+            size_t(m_Reference[plane_idx].size()) * sizeof(double)) != 0)
+        {
+            return -1;
+        }
+    }
+    return seconds;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Operators and calls in a formula
+int Autotuner::CountOperations(const QString mcFormula)
+{
+    // Every call and every group has an opening parenthesis
+    int operations = 0;
+    for (int idx = 0; idx < mcFormula.size(); idx++)
+    {
+        if (QString("+-*/^(").contains(mcFormula[idx]))
+        {
+            operations++;
+        }
+    }
+    return operations;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of bits of a value
+int Autotuner::GetClass(qint64 mValue)
+{
+    int bits = 0;
+    while (mValue > 0)
+    {
+        mValue >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Entries of the cache
+QJsonObject Autotuner::ReadCache() const
+{
+    // No cache yet is the same as an empty one
+    QFile cache_file(m_CacheFilename);
+    if (!cache_file.open(QIODevice::ReadOnly))
+    {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(cache_file.readAll()).object();
+}
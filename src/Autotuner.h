@@ -0,0 +1,87 @@
+// Autotuner.h
+// Class definition
+
+#ifndef AUTOTUNER_H
+#define AUTOTUNER_H
+
+// Project includes
+#include "LIC.h"
+
+// Qt includes
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+
+
+// Define class
+class Autotuner
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; tunes a configured renderer
+    Autotuner(LIC * mpLIC);
+
+    // Destructor
+    virtual ~Autotuner();
+
+
+
+    // ========================================================== Functionality
+public:
+    // File the settings tuned on this host are kept in (default:
+    // ~/.cache/LIC/tuning-<host>.json)
+    void SetCacheFilename(const QString mcFilename);
+    QString GetCacheFilename() const;
+
+    // Trace a sample of the tiles with several tile sizes, tile orders,
+    // backends, and numbers of threads; the fastest settings are applied to
+    // the renderer and kept in the cache. All of them give the same pixels;
+    // settings whose pixels differ are rejected.
+    bool Execute();
+
+    // Apply the settings tuned earlier for configurations like this one;
+    // returns false if there are none
+    bool ApplyCached();
+
+    // Configurations with the same key share their settings: classes
+    // (powers of two) of the cost of the formulas and of the number of
+    // pixels ("c4-r6")
+    QString GetKey() const;
+
+private:
+    // What is tuned
+    struct Settings
+    {
+        int tile_size;
+        int tile_interleave;
+        int num_threads;
+        LIC::Backend backend;
+    };
+    void Apply(const Settings & mcSettings, const QString mcSource);
+    QString ToString(const Settings & mcSettings) const;
+
+    // Seconds to trace the sample with some settings; -1 if its pixels
+    // differ from the first settings measured, or tracing was cancelled
+    double Measure(const Settings & mcSettings);
+
+    // Operators and calls in a formula
+    static int CountOperations(const QString mcFormula);
+
+    // Number of bits of a value
+    static int GetClass(qint64 mValue);
+
+    // Entries of the cache, by key
+    QJsonObject ReadCache() const;
+
+    LIC * m_LIC;
+    QString m_CacheFilename;
+
+    // Blocks of the sample, and the traced pixels of the first settings
+    // measured
+    QList < bool > m_SampleBlocks;
+    int m_NumBlocksX;
+    QList < QList < double > > m_Reference;
+};
+
+#endif
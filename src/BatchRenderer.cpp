@@ -0,0 +1,427 @@
+// BatchRenderer.cpp
+// Class implementation
+
+// Project includes
+#include "BatchRenderer.h"
+#include "LIC.h"
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "ThreadPool.h"
+
+// Qt includes
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QThread>
+
+
+
+// Version of the JSON layout; increase when fields change meaning
+static const int BATCH_SCHEMA_VERSION = 1;
+
+// Renderers in use at the same time: one tracing, one encoding
+static const int NUM_RENDERERS = 2;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+BatchRenderer::BatchRenderer()
+{
+    m_NumThreads = 0;
+    m_ProgressMode = ProgressReporter::GetDefaultMode();
+    m_StopEncoder = false;
+    m_WallSeconds = 0.;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+BatchRenderer::~BatchRenderer()
+{
+    for (LIC * renderer : m_Renderers)
+    {
+        delete renderer;
+    }
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Add the configurations listed in a manifest
+bool BatchRenderer::AddManifest(const QString mcFilename)
+{
+    QFile manifest_file(mcFilename);
+    if (!manifest_file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Manifest \"%1\" could not be read.").arg(mcFilename));
+        return false;
+    }
+    const QDir manifest_directory = QFileInfo(mcFilename).dir();
+    QTextStream stream(&manifest_file);
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() ||
+            line.startsWith("#"))
+        {
+            continue;
+        }
+        m_Configurations << manifest_directory.filePath(line);
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Add a single configuration
+void BatchRenderer::AddConfiguration(const QString mcFilename)
+{
+    m_Configurations << mcFilename;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads used for tracing
+void BatchRenderer::SetNumThreads(int mNumThreads)
+{
+    m_NumThreads = mNumThreads;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// How progress is shown while tracing
+void BatchRenderer::SetProgressMode(ProgressReporter::Mode mMode)
+{
+    m_ProgressMode = mMode;
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render all configurations
+bool BatchRenderer::Execute()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Which results are needed more than once
+    PlanReuse();
+
+    // All jobs trace with the same threads; the calling thread is one of
+    // them
+    const int num_threads =
+        (m_NumThreads > 0 ? m_NumThreads : QThread::idealThreadCount());
+    ThreadPool pool(num_threads - 1);
+
+    m_StopEncoder = false;
+    m_EncoderThread = std::thread(&BatchRenderer::RunEncoder, this);
+    for (int job_idx = 0; job_idx < m_Jobs.size(); job_idx++)
+    {
+        const QString noise_key = m_NoiseKeys[job_idx];
+        const QString tracing_key = m_TracingKeys[job_idx];
+        if (noise_key.isEmpty())
+        {
+            // Configuration is invalid; already reported
+            continue;
+        }
+
+        // Configure a renderer that is not encoding right now
+        LIC * lic = AcquireRenderer();
+        lic -> GetMutablePerformanceReport().Clear();
+        lic -> SetProgressMode(m_ProgressMode);
+        lic -> SetNumThreads(m_NumThreads);
+        lic -> SetThreadPool(&pool);
+        if (!lic -> ReadXMLConfiguration(m_Configurations[job_idx]))
+        {
+            ReleaseRenderer(lic);
+            continue;
+        }
+        lic -> ResetCancel();
+
+        // Sweeps render many images with stages of their own
+        if (lic -> HasSweep())
+        {
+            const bool success = lic -> Execute();
+            {
+                std::lock_guard < std::mutex > lock(m_Mutex);
+                m_Jobs[job_idx].success = success;
+                m_Jobs[job_idx].report =
+                    lic -> GetPerformanceReport().ToJSON();
+            }
+            ReleaseRenderer(lic);
+            continue;
+        }
+
+        // Noise
+        bool noise_reused = false;
+        if (m_NoiseCache.contains(noise_key))
+        {
+            lic -> AdoptNoisePlanes(m_NoiseCache[noise_key]);
+            noise_reused = true;
+        } else
+        {
+            lic -> RunStage("GenerateNoise",
+                [lic]()
+                {
+                    lic -> GenerateNoise();
+                    return true;
+                });
+        }
+        if (--m_NoiseUses[noise_key] > 0)
+        {
+            m_NoiseCache[noise_key] = lic -> GetNoisePlanes();
+        } else
+        {
+            m_NoiseCache.remove(noise_key);
+        }
+
+        // Tracing
+        bool tracing_reused = false;
+        if (m_TracingCache.contains(tracing_key))
+        {
+            lic -> AdoptTracedPlanes(m_TracingCache[tracing_key]);
+            tracing_reused = true;
+        } else
+        {
+            lic -> RunStage("GenerateLIC",
+                [lic]()
+                {
+                    return lic -> GenerateLIC();
+                });
+        }
+        if (--m_TracingUses[tracing_key] > 0)
+        {
+            m_TracingCache[tracing_key] = lic -> GetTracedPlanes();
+        } else
+        {
+            m_TracingCache.remove(tracing_key);
+        }
+        PerformanceReport & report = lic -> GetMutablePerformanceReport();
+        report.SetCounter("noise_reused", noise_reused);
+        report.SetCounter("tracing_reused", tracing_reused);
+
+        // Encode while the next job is traced
+        {
+            std::lock_guard < std::mutex > lock(m_Mutex);
+            m_Jobs[job_idx].noise_reused = noise_reused;
+            m_Jobs[job_idx].tracing_reused = tracing_reused;
+            m_EncoderQueue << QPair < int, LIC * >(job_idx, lic);
+        }
+        m_Condition.notify_all();
+    }
+
+    // Wait for the last images
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        m_StopEncoder = true;
+    }
+    m_Condition.notify_all();
+    m_EncoderThread.join();
+    m_WallSeconds = timer.nsecsElapsed() * 1e-9;
+
+    // Check results
+    bool success = true;
+    for (const Job & job : m_Jobs)
+    {
+        success = success && job.success;
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Find out which noise planes and traced images are used more than once
+void BatchRenderer::PlanReuse()
+{
+    m_Jobs.clear();
+    m_NoiseUses.clear();
+    m_TracingUses.clear();
+    m_NoiseKeys.clear();
+    m_TracingKeys.clear();
+
+    // Parsing is cheap compared to tracing, so every configuration is read
+    // once up front just for its keys
+    LIC probe;
+    for (const QString & configuration : m_Configurations)
+    {
+        Job job;
+        job.configuration = configuration;
+        m_Jobs << job;
+        if (!probe.ReadXMLConfiguration(configuration))
+        {
+            m_NoiseKeys << QString();
+            m_TracingKeys << QString();
+            continue;
+        }
+        // Results of sweeps are never shared with other jobs
+        const QString noise_key = (probe.HasSweep() ?
+            QString("sweep %1").arg(m_Jobs.size()) : probe.GetNoiseKey());
+        const QString tracing_key = (probe.HasSweep() ?
+            noise_key : probe.GetTracingKey());
+        m_NoiseKeys << noise_key;
+        m_TracingKeys << tracing_key;
+        m_NoiseUses[noise_key]++;
+        m_TracingUses[tracing_key]++;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Get a renderer that is not in use
+LIC * BatchRenderer::AcquireRenderer()
+{
+    std::unique_lock < std::mutex > lock(m_Mutex);
+    if (m_IdleRenderers.isEmpty() &&
+        m_Renderers.size() < NUM_RENDERERS)
+    {
+        LIC * renderer = new LIC();
+        m_Renderers << renderer;
+        return renderer;
+    }
+    m_Condition.wait(lock,
+        [this]()
+        {
+            return !m_IdleRenderers.isEmpty();
+        });
+    return m_IdleRenderers.takeFirst();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Renderer can be used for the next job
+void BatchRenderer::ReleaseRenderer(LIC * mpRenderer)
+{
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        m_IdleRenderers << mpRenderer;
+    }
+    m_Condition.notify_all();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Encoder thread
+void BatchRenderer::RunEncoder()
+{
+    while (true)
+    {
+        QPair < int, LIC * > item;
+        {
+            std::unique_lock < std::mutex > lock(m_Mutex);
+            m_Condition.wait(lock,
+                [this]()
+                {
+                    return m_StopEncoder || !m_EncoderQueue.isEmpty();
+                });
+            if (m_EncoderQueue.isEmpty())
+            {
+                // Stop requested and nothing left to do
+                return;
+            }
+            item = m_EncoderQueue.takeFirst();
+        }
+
+        // Normalize, color, and save; batches always trace the whole image,
+        // so it can be shared with other jobs
+        LIC * lic = item.second;
+        const bool success = lic -> RunStage("GenerateImage",
+            [lic]()
+            {
+                return lic -> WriteOutputs(QRect(0, 0,
+                    lic -> GetImageWidth(), lic -> GetImageHeight()));
+            });
+        lic -> UpdateDerivedCounters();
+        {
+            std::lock_guard < std::mutex > lock(m_Mutex);
+            m_Jobs[item.first].success = success;
+            m_Jobs[item.first].report =
+                lic -> GetPerformanceReport().ToJSON();
+        }
+        ReleaseRenderer(lic);
+    }
+}
+
+
+
+// ============================================================== Serialization
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Results of all jobs as JSON
+QJsonObject BatchRenderer::ToJSON() const
+{
+    QJsonObject json;
+    json["schema"] = "lic-batch-report";
+    json["schema_version"] = BATCH_SCHEMA_VERSION;
+    json["wall_seconds"] = m_WallSeconds;
+
+    QJsonArray jobs;
+    int num_failed = 0;
+    int num_noise_reused = 0;
+    int num_tracing_reused = 0;
+    for (const Job & job : m_Jobs)
+    {
+        QJsonObject json_job;
+        json_job["configuration"] = job.configuration;
+        json_job["success"] = job.success;
+        json_job["noise_reused"] = job.noise_reused;
+        json_job["tracing_reused"] = job.tracing_reused;
+        json_job["report"] = job.report;
+        jobs.append(json_job);
+        num_failed += (job.success ? 0 : 1);
+        num_noise_reused += (job.noise_reused ? 1 : 0);
+        num_tracing_reused += (job.tracing_reused ? 1 : 0);
+    }
+    json["jobs"] = jobs;
+    json["failed"] = num_failed;
+    json["noise_reused"] = num_noise_reused;
+    json["tracing_reused"] = num_tracing_reused;
+    return json;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write results to file
+bool BatchRenderer::WriteJSON(const QString mcFilename) const
+{
+    QFile output_file(mcFilename);
+    if (!output_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Report file \"%1\" could not be written.")
+                .arg(mcFilename));
+        return false;
+    }
+    output_file.write(QJsonDocument(ToJSON()).toJson(QJsonDocument::Indented));
+    output_file.close();
+    return true;
+}
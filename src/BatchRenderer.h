@@ -0,0 +1,126 @@
+// BatchRenderer.h
+// Class definition
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+// Project includes
+#include "ProgressReporter.h"
+
+// Qt includes
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+// System includes
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Forward declaration
+class LIC;
+
+
+
+// Define class
+class BatchRenderer
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    BatchRenderer();
+
+    // Destructor
+    virtual ~BatchRenderer();
+
+
+
+    // ========================================================== Configuration
+public:
+    // Add the configurations listed in a manifest (one file per line; empty
+    // lines and lines starting with # are ignored, relative paths are
+    // relative to the manifest)
+    bool AddManifest(const QString mcFilename);
+
+    // Add a single configuration
+    void AddConfiguration(const QString mcFilename);
+
+    // Number of threads used for tracing (0: one per core)
+    void SetNumThreads(int mNumThreads);
+
+    // How progress is shown while tracing
+    void SetProgressMode(ProgressReporter::Mode mMode);
+
+private:
+    QStringList m_Configurations;
+    int m_NumThreads;
+    ProgressReporter::Mode m_ProgressMode;
+
+
+
+    // ========================================================== Functionality
+public:
+    // Render all configurations; returns false if any of them failed
+    bool Execute();
+
+private:
+    // Find out which noise planes and traced images are used more than once
+    void PlanReuse();
+
+    // Outcome of one configuration
+    struct Job
+    {
+        QString configuration;
+        bool success = false;
+        bool noise_reused = false;
+        bool tracing_reused = false;
+        QJsonObject report;
+    };
+    QList < Job > m_Jobs;
+
+    // Results of stages that later jobs need again. Lists are implicitly
+    // shared, so handing them to a renderer doesn't copy anything.
+    QHash < QString, QList < QList < double > > > m_NoiseCache;
+    QHash < QString, QList < QList < double > > > m_TracingCache;
+
+    // Number of jobs (still) using a key
+    QHash < QString, int > m_NoiseUses;
+    QHash < QString, int > m_TracingUses;
+    QStringList m_NoiseKeys;
+    QStringList m_TracingKeys;
+
+    // Renderers are reused, so the buffers of a job are usually allocated
+    // by an earlier one already. There are two: one is tracing while the
+    // other one is encoding.
+    LIC * AcquireRenderer();
+    void ReleaseRenderer(LIC * mpRenderer);
+
+    QList < LIC * > m_Renderers;
+    QList < LIC * > m_IdleRenderers;
+
+    // Encoding runs in its own thread, overlapping tracing of the next job
+    void RunEncoder();
+
+    QList < QPair < int, LIC * > > m_EncoderQueue;
+    std::thread m_EncoderThread;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_StopEncoder;
+
+    double m_WallSeconds;
+
+
+
+    // ========================================================== Serialization
+public:
+    // Results of all jobs as JSON
+    QJsonObject ToJSON() const;
+
+    // Write results to file
+    bool WriteJSON(const QString mcFilename) const;
+};
+
+#endif
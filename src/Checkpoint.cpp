@@ -0,0 +1,377 @@
+// Checkpoint.cpp
+// Class implementation
+
+// Project includes
+#include "Checkpoint.h"
+#include "Macros.h"
+#include "MessageLogger.h"
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QDebug>
+
+// System includes
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+
+
+// Version of the file layout; increase when it changes
+static const qint32 CHECKPOINT_FILE_VERSION = 2;
+
+// Start of every file
+static const char CHECKPOINT_FILE_MAGIC[8] = { 'L', 'I', 'C', 'C', 'H', 'K',
+    'P', 'T' };
+
+// Planes in the file (red, green, blue, strength)
+static const int NUM_PLANES = 4;
+
+// Copied tiles are written to disk at most this often. Writing is
+// asynchronous to tracing until then, so the cost is mostly copying a
+// tile (microseconds) after tracing it (milliseconds to seconds).
+static const qint64 SYNC_INTERVAL_MS = 30000;
+
+// Layout: header, one flag per tile, planes from the next page boundary
+// (so they can be synced on their own). The key is stored as a hash; its
+// size doesn't depend on the configuration.
+struct CheckpointFileHeader
+{
+    char magic[8];
+    qint32 version;
+    qint32 num_tiles;
+    qint32 width;
+    qint32 height;
+    qint32 tile_size;
+    char key_hash[32];
+};
+
+// Planes start here
+static qint64 GetPlanesOffset(int mNumTiles)
+{
+    const qint64 page_size = 4096;
+    return (qint64(sizeof(CheckpointFileHeader)) + mNumTiles + page_size -
+        1) / page_size * page_size;
+}
+
+// Write mapped pages to disk. Without a way to do so, the system writes
+// them back eventually; they survive the process being killed either way.
+static bool FlushToDisk(uchar * mpData, qint64 mSize)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return msync(mpData, size_t(mSize), MS_SYNC) == 0;
+#else
+    Q_UNUSED(mpData);
+    Q_UNUSED(mSize);
+    return true;
+#endif
+}
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+Checkpoint::Checkpoint()
+{
+    m_Resume = false;
+    m_Data = nullptr;
+    m_Size = 0;
+    m_TileFlags = nullptr;
+    m_Planes = nullptr;
+    m_Width = 0;
+    m_Height = 0;
+    m_NumResumedTiles = 0;
+    m_Nanoseconds = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+Checkpoint::~Checkpoint()
+{
+    Close(false);
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File finished tiles are kept in
+void Checkpoint::SetFilename(const QString mcFilename, bool mResume)
+{
+    m_Filename = mcFilename;
+    m_Resume = mResume;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Tiles are kept at all
+bool Checkpoint::IsEnabled() const
+{
+    return !m_Filename.isEmpty();
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Map the file for a traced image
+bool Checkpoint::Open(const QString mcKey, int mWidth, int mHeight,
+    int mNumTiles, int mTileSize, const QList < QList < double > * > mcPlanes,
+    QList < bool > & mrTilesDone)
+{
+    Close(false);
+    m_Width = mWidth;
+    m_Height = mHeight;
+    m_NumResumedTiles = 0;
+    m_Nanoseconds = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    CheckpointFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_FILE_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_FILE_VERSION;
+    header.num_tiles = mNumTiles;
+    header.width = mWidth;
+    header.height = mHeight;
+    header.tile_size = mTileSize;
+    const QByteArray key_hash = QCryptographicHash::hash(mcKey.toUtf8(),
+        QCryptographicHash::Sha256);
+    memcpy(header.key_hash, key_hash.constData(), sizeof(header.key_hash));
+
+    const qint64 plane_size = qint64(mWidth) * mHeight;
+    const qint64 planes_offset = GetPlanesOffset(mNumTiles);
+    m_Size = planes_offset +
+        NUM_PLANES * plane_size * qint64(sizeof(double));
+
+    // Continue where the last run stopped, if it rendered the same
+    m_File.setFileName(m_Filename);
+    bool resumed = false;
+    if (m_Resume &&
+        m_File.exists() &&
+        m_File.size() == m_Size &&
+        m_File.open(QIODevice::ReadWrite))
+    {
+        m_Data = m_File.map(0, m_Size);
+        resumed = m_Data &&
+            memcmp(m_Data, &header, sizeof(header)) == 0;
+        if (!resumed)
+        {
+            qDebug().noquote() << QString("Checkpoint \"%1\" is for another "
+                "configuration; starting over.").arg(m_Filename);
+        }
+    } else if (m_Resume)
+    {
+        qDebug().noquote() << QString("No checkpoint \"%1\" to resume; "
+            "starting over.").arg(m_Filename);
+    }
+
+    // New file; it is sparse until tiles are written
+    if (!resumed)
+    {
+        if (m_Data)
+        {
+            m_File.unmap(m_Data);
+            m_Data = nullptr;
+        }
+        m_File.close();
+        if (!m_File.open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+            !m_File.resize(m_Size) ||
+            !(m_Data = m_File.map(0, m_Size)))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Checkpoint \"%1\" could not be created: %2")
+                    .arg(m_Filename, m_File.errorString()));
+            m_File.close();
+            m_Data = nullptr;
+            return false;
+        }
+        memcpy(m_Data, &header, sizeof(header));
+    }
+    m_TileFlags = m_Data + sizeof(header);
+    m_Planes = reinterpret_cast < double * >(m_Data + planes_offset);
+
+    // Finished tiles of the file
+    if (resumed)
+    {
+        for (int plane_idx = 0; plane_idx < NUM_PLANES; plane_idx++)
+        {
+            memcpy(mcPlanes[plane_idx] -> data(),
+                m_Planes + plane_idx * plane_size,
+                plane_size * sizeof(double));
+        }
+        for (int tile = 0; tile < mNumTiles; tile++)
+        {
+            mrTilesDone[tile] = (m_TileFlags[tile] != 0);
+            m_NumResumedTiles += (m_TileFlags[tile] != 0 ? 1 : 0);
+        }
+    }
+    m_Sources.clear();
+    for (const QList < double > * plane : mcPlanes)
+    {
+        m_Sources << plane -> constData();
+    }
+    m_PendingTiles.clear();
+    m_SyncTimer.start();
+    m_Nanoseconds = timer.nsecsElapsed();
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Copy the pixels of a finished tile
+void Checkpoint::SaveTile(int mTile, const QRect & mcPixels)
+{
+    if (!m_Data)
+    {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+
+    // Columns of a tile are contiguous in every plane; tiles don't overlap,
+    // so threads don't need the lock for copying
+    const qint64 plane_size = qint64(m_Width) * m_Height;
+    const qint64 column_bytes = mcPixels.height() * qint64(sizeof(double));
+    for (int plane_idx = 0; plane_idx < NUM_PLANES; plane_idx++)
+    {
+        const double * source = m_Sources[plane_idx];
+        double * destination = m_Planes + plane_idx * plane_size;
+        for (int ix = mcPixels.left(); ix <= mcPixels.right(); ix++)
+        {
+            const qint64 offset = qint64(ix) * m_Height + mcPixels.top();
+            memcpy(destination + offset, source + offset, column_bytes);
+        }
+    }
+
+    std::lock_guard < std::mutex > lock(m_Mutex);
+    m_PendingTiles << mTile;
+    if (m_SyncTimer.elapsed() >= SYNC_INTERVAL_MS)
+    {
+        SyncLocked();
+    }
+    m_Nanoseconds += timer.nsecsElapsed();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write the copied tiles to disk
+bool Checkpoint::Sync()
+{
+    std::lock_guard < std::mutex > lock(m_Mutex);
+    QElapsedTimer timer;
+    timer.start();
+    const bool success = SyncLocked();
+    m_Nanoseconds += timer.nsecsElapsed();
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write pending tiles to disk
+bool Checkpoint::SyncLocked()
+{
+    m_SyncTimer.start();
+    if (!m_Data ||
+        m_PendingTiles.isEmpty())
+    {
+        return true;
+    }
+
+    // Pixels first, then the flags saying they are there; a checkpoint
+    // never claims a tile whose pixels could be lost
+    const qint64 planes_offset =
+        reinterpret_cast < uchar * >(m_Planes) - m_Data;
+    bool success = FlushToDisk(m_Data + planes_offset, m_Size - planes_offset);
+    for (int tile : m_PendingTiles)
+    {
+        m_TileFlags[tile] = 1;
+    }
+    m_PendingTiles.clear();
+    success = FlushToDisk(m_Data, planes_offset) && success;
+    if (!success)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Checkpoint \"%1\" could not be written.")
+                .arg(m_Filename));
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Unmap the file
+void Checkpoint::Close(bool mRemove)
+{
+    if (m_Data)
+    {
+        Sync();
+        m_File.unmap(m_Data);
+        m_Data = nullptr;
+    }
+    m_File.close();
+    if (mRemove &&
+        IsEnabled())
+    {
+        QFile::remove(m_Filename);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Tiles that were finished in the file when it was opened
+int Checkpoint::GetNumResumedTiles() const
+{
+    return m_NumResumedTiles;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Time spent on copying and syncing
+double Checkpoint::GetSeconds() const
+{
+    return m_Nanoseconds * 1e-9;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Tile size of the image in a checkpoint file
+int Checkpoint::ReadTileSize(const QString mcFilename)
+{
+    QFile file(mcFilename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return 0;
+    }
+    CheckpointFileHeader header;
+    if (file.read(reinterpret_cast < char * >(&header), sizeof(header)) !=
+            qint64(sizeof(header)) ||
+        memcmp(header.magic, CHECKPOINT_FILE_MAGIC,
+            sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_FILE_VERSION)
+    {
+        return 0;
+    }
+    return qMax(0, int(header.tile_size));
+}
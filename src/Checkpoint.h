@@ -0,0 +1,100 @@
+// Checkpoint.h
+// Class definition
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Qt includes
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QRect>
+#include <QString>
+
+// System includes
+#include <mutex>
+
+
+
+// Define class
+class Checkpoint
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    Checkpoint();
+
+    // Destructor; writes what is pending
+    virtual ~Checkpoint();
+
+
+
+    // ========================================================== Configuration
+public:
+    // File finished tiles are kept in (empty: none), and whether its tiles
+    // are used when tracing starts
+    void SetFilename(const QString mcFilename, bool mResume);
+    bool IsEnabled() const;
+
+private:
+    QString m_Filename;
+    bool m_Resume;
+
+
+
+    // ========================================================== Functionality
+public:
+    // Map the file for a traced image of mWidth x mHeight pixels in
+    // mNumTiles tiles of mTileSize. If resuming and the file is for the
+    // same key, its planes are copied to mcPlanes and its finished tiles
+    // are set in mrTilesDone; otherwise the file is started over, with the
+    // tiles that are already set in mrTilesDone.
+    bool Open(const QString mcKey, int mWidth, int mHeight, int mNumTiles,
+        int mTileSize, const QList < QList < double > * > mcPlanes,
+        QList < bool > & mrTilesDone);
+
+    // Copy the pixels of a finished tile (may be called from any thread);
+    // they are written to disk with the next sync
+    void SaveTile(int mTile, const QRect & mcPixels);
+
+    // Write the copied tiles to disk and mark them finished
+    bool Sync();
+
+    // Unmap the file; it is removed if the image is complete
+    void Close(bool mRemove);
+
+    // Tiles that were finished in the file when it was opened
+    int GetNumResumedTiles() const;
+
+    // Time spent on copying and syncing since the file was opened
+    double GetSeconds() const;
+
+    // Tile size of the image in a checkpoint file (0: no such file), so a
+    // resumed run can use the same tiles
+    static int ReadTileSize(const QString mcFilename);
+
+private:
+    // Write pending tiles to disk (with m_Mutex held)
+    bool SyncLocked();
+
+    QFile m_File;
+    uchar * m_Data;
+    qint64 m_Size;
+    uchar * m_TileFlags;
+    double * m_Planes;
+    int m_Width;
+    int m_Height;
+    int m_NumResumedTiles;
+
+    // Planes being traced
+    QList < const double * > m_Sources;
+
+    // Copied, but not on disk yet
+    std::mutex m_Mutex;
+    QList < int > m_PendingTiles;
+    QElapsedTimer m_SyncTimer;
+    qint64 m_Nanoseconds;
+};
+
+#endif
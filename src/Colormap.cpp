@@ -0,0 +1,177 @@
+// Colormap.cpp
+// Class implementation
+
+// Project includes
+#include "Colormap.h"
+#include "Macros.h"
+
+// Qt includes
+#include <QDebug>
+#include <QHash>
+
+// System includes
+#include <cmath>
+
+
+
+// Control points of the available colormaps. Each control point consists of
+// four numbers: position in [0, 1], red, green, and blue.
+static const QHash < QString, QList < double > > colormap_control_points =
+{
+    { "gray",
+        { 0.00,  0.000, 0.000, 0.000,
+          1.00,  1.000, 1.000, 1.000 } },
+    { "red",
+        { 0.00,  1.000, 0.000, 0.000,
+          1.00,  1.000, 1.000, 1.000 } },
+    { "hot",
+        { 0.000,  0.000, 0.000, 0.000,
+          0.375,  1.000, 0.000, 0.000,
+          0.750,  1.000, 1.000, 0.000,
+          1.000,  1.000, 1.000, 1.000 } },
+    { "viridis",
+        { 0.00,  0.267, 0.005, 0.329,
+          0.25,  0.229, 0.322, 0.546,
+          0.50,  0.128, 0.567, 0.551,
+          0.75,  0.369, 0.789, 0.383,
+          1.00,  0.993, 0.906, 0.144 } },
+    { "rainbow",
+        { 0.00,  0.000, 0.000, 1.000,
+          0.25,  0.000, 1.000, 1.000,
+          0.50,  0.000, 1.000, 0.000,
+          0.75,  1.000, 1.000, 0.000,
+          1.00,  1.000, 0.000, 0.000 } },
+    { "coolwarm",
+        { 0.00,  0.230, 0.299, 0.754,
+          0.50,  0.865, 0.865, 0.865,
+          1.00,  0.706, 0.016, 0.150 } }
+};
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+Colormap::Colormap()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Create colormap by name
+Colormap * Colormap::CreateColormap(const QString mcName, double mGamma)
+{
+    if (!colormap_control_points.contains(mcName) ||
+        mGamma <= 0)
+    {
+        return nullptr;
+    }
+
+    Colormap * ret = new Colormap();
+    ret -> m_Name = mcName;
+    ret -> BuildLUT(colormap_control_points[mcName], mGamma);
+    return ret;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+Colormap::~Colormap()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Names of all available colormaps
+QStringList Colormap::GetColormapNames()
+{
+    QStringList names = colormap_control_points.keys();
+    names.sort();
+    return names;
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Name
+QString Colormap::GetName() const
+{
+    return m_Name;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Lookup tables
+const float * Colormap::GetLUT_R() const
+{
+    return m_LUT_R.constData();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Lookup tables
+const float * Colormap::GetLUT_G() const
+{
+    return m_LUT_G.constData();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Lookup tables
+const float * Colormap::GetLUT_B() const
+{
+    return m_LUT_B.constData();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Fill lookup tables from the control points of a colormap
+void Colormap::BuildLUT(const QList < double > mcControlPoints, double mGamma)
+{
+    m_LUT_R.resize(LUT_SIZE);
+    m_LUT_G.resize(LUT_SIZE);
+    m_LUT_B.resize(LUT_SIZE);
+
+    const int num_points = mcControlPoints.size() / 4;
+    int segment = 0;
+    for (int idx = 0; idx < LUT_SIZE; idx++)
+    {
+        // Gamma is applied to the position, so the output pass only needs
+        // a single table lookup
+        const double t = pow(idx / (LUT_SIZE - 1.), mGamma);
+
+        // Find control points enclosing t
+        while (segment < num_points - 2 &&
+            t > mcControlPoints[4 * (segment + 1)])
+        {
+            segment++;
+        }
+        const double t0 = mcControlPoints[4 * segment];
+        const double t1 = mcControlPoints[4 * (segment + 1)];
+        double weight = (t - t0) / (t1 - t0);
+        weight = qBound(0., weight, 1.);
+
+        // Interpolate linearly
+        const double * p0 = mcControlPoints.constData() + 4 * segment;
+        const double * p1 = p0 + 4;
+        m_LUT_R[idx] = float(p0[1] + weight * (p1[1] - p0[1]));
+        m_LUT_G[idx] = float(p0[2] + weight * (p1[2] - p0[2]));
+        m_LUT_B[idx] = float(p0[3] + weight * (p1[3] - p0[3]));
+    }
+}
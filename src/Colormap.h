@@ -0,0 +1,57 @@
+// Colormap.h
+// Class definition
+
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+// Qt includes
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+
+
+// Define class
+class Colormap
+{
+    // ============================================================== Lifecycle
+private:
+    // Constructor
+    Colormap();
+
+public:
+    // Create colormap by name; returns nullptr if the name is unknown
+    static Colormap * CreateColormap(const QString mcName, double mGamma);
+
+    // Destructor
+    virtual ~Colormap();
+
+    // Names of all available colormaps
+    static QStringList GetColormapNames();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Number of entries in the lookup tables
+    static const int LUT_SIZE = 1024;
+
+    // Name
+    QString GetName() const;
+
+    // Lookup tables; entries are in [0, 1] and already include gamma
+    const float * GetLUT_R() const;
+    const float * GetLUT_G() const;
+    const float * GetLUT_B() const;
+
+private:
+    // Fill lookup tables from the control points of a colormap
+    void BuildLUT(const QList < double > mcControlPoints, double mGamma);
+
+    QString m_Name;
+    QList < float > m_LUT_R;
+    QList < float > m_LUT_G;
+    QList < float > m_LUT_B;
+};
+
+#endif
@@ -0,0 +1,244 @@
+// ConfigWatcher.cpp
+// Class implementation
+
+// Project includes
+#include "ConfigWatcher.h"
+#include "LIC.h"
+
+// Qt includes
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+
+
+// Milliseconds without further changes before rendering
+static const int CHANGE_DELAY_MS = 200;
+
+// Previews have this fraction of the resolution (and of the steps, so
+// streaks look the same)...
+static const int PREVIEW_FACTOR = 4;
+
+// ...unless the image is small enough to be quick anyway
+static const int MIN_PREVIEW_SIZE = 64;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+ConfigWatcher::ConfigWatcher(const QString mcFilename)
+{
+    m_Filename = mcFilename;
+    m_LIC = new LIC();
+    m_Preview = new LIC();
+    m_Preview -> SetProgressMode(ProgressReporter::Mode_Quiet);
+
+    // Rendering an outdated configuration is pointless
+    auto file_changed = [this]()
+    {
+        return QFileInfo(m_Filename).lastModified() != m_RenderedModified;
+    };
+    m_LIC -> SetCancelCallback(file_changed);
+    m_Preview -> SetCancelCallback(file_changed);
+
+    m_ChangeTimer.setSingleShot(true);
+    m_ChangeTimer.setInterval(CHANGE_DELAY_MS);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+ConfigWatcher::~ConfigWatcher()
+{
+    delete m_LIC;
+    delete m_Preview;
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads used for tracing
+void ConfigWatcher::SetNumThreads(int mNumThreads)
+{
+    m_LIC -> SetNumThreads(mNumThreads);
+    m_Preview -> SetNumThreads(mNumThreads);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// How progress is shown while tracing
+void ConfigWatcher::SetProgressMode(ProgressReporter::Mode mMode)
+{
+    m_LIC -> SetProgressMode(mMode);
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render now and whenever the configuration changes
+int ConfigWatcher::Execute()
+{
+    m_FileWatcher.addPath(m_Filename);
+    QObject::connect(&m_FileWatcher, &QFileSystemWatcher::fileChanged,
+        &m_FileWatcher,
+        [this]()
+        {
+            FileChanged();
+        });
+    QObject::connect(&m_ChangeTimer, &QTimer::timeout, &m_ChangeTimer,
+        [this]()
+        {
+            Render();
+        });
+
+    Render();
+    qDebug().noquote() << QString("Watching \"%1\" for changes.")
+        .arg(m_Filename);
+    return QCoreApplication::exec();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration file has been written to
+void ConfigWatcher::FileChanged()
+{
+    // Editors that save by replacing the file take it out of the watcher
+    if (!m_FileWatcher.files().contains(m_Filename) &&
+        QFile::exists(m_Filename))
+    {
+        m_FileWatcher.addPath(m_Filename);
+    }
+    m_ChangeTimer.start();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render with whatever is still valid from the last time
+bool ConfigWatcher::Render()
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_RenderedModified = QFileInfo(m_Filename).lastModified();
+    m_LIC -> GetMutablePerformanceReport().Clear();
+    if (!m_LIC -> ReadXMLConfiguration(m_Filename))
+    {
+        // Already reported; the next change may fix it
+        return false;
+    }
+
+    // Sweeps render many images; nothing is kept for them
+    if (m_LIC -> HasSweep())
+    {
+        m_NoiseKey.clear();
+        m_TracingKey.clear();
+        return m_LIC -> Execute();
+    }
+
+    // Only stages with changed inputs run again. Coloring and outputs are
+    // not part of the tracing key, so changing them only redoes the image.
+    const QRect trace_rect = m_LIC -> GetTraceRect();
+    const QString noise_key = m_LIC -> GetNoiseKey();
+    const QString tracing_key = m_LIC -> GetTracingKey(trace_rect);
+    QStringList stages;
+    if (tracing_key != m_TracingKey)
+    {
+        RenderPreview();
+
+        if (noise_key != m_NoiseKey)
+        {
+            m_LIC -> RunStage("GenerateNoise",
+                [this]()
+                {
+                    m_LIC -> GenerateNoise();
+                    return true;
+                });
+            m_NoiseKey = noise_key;
+            stages << "noise";
+        }
+
+        // Whatever was traced before is gone even if this is cancelled
+        m_TracingKey.clear();
+        m_LIC -> ResetCancel();
+        const bool traced = m_LIC -> RunStage("GenerateLIC",
+            [this, trace_rect]()
+            {
+                return m_LIC -> GenerateLIC(trace_rect);
+            });
+        if (!traced)
+        {
+            // Changed while tracing; rendered again shortly
+            return false;
+        }
+        m_TracingKey = tracing_key;
+        stages << "tracing";
+    }
+
+    // Image
+    const bool success = m_LIC -> RunStage("GenerateImage",
+        [this, trace_rect]()
+        {
+            return m_LIC -> WriteOutputs(trace_rect);
+        });
+    m_LIC -> UpdateDerivedCounters();
+    stages << "image";
+
+    qDebug().noquote() << QString("Rendered in %1 s (%2).")
+        .arg(QString::number(timer.nsecsElapsed() * 1e-9, 'f', 2),
+             stages.join(", "));
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Quick image before the full one is traced
+void ConfigWatcher::RenderPreview()
+{
+    const int width = m_LIC -> GetImageWidth() / PREVIEW_FACTOR;
+    const int height = m_LIC -> GetImageHeight() / PREVIEW_FACTOR;
+
+    // A smaller resolution would change the frame a region is cut from
+    if (width < MIN_PREVIEW_SIZE ||
+        height < MIN_PREVIEW_SIZE ||
+        !m_LIC -> GetRegion().isEmpty() ||
+        !m_Preview -> ReadXMLConfiguration(m_Filename))
+    {
+        return;
+    }
+    m_Preview -> SetResolution(width, height);
+    m_Preview -> SetSteps(qMax(1, m_LIC -> GetSteps() / PREVIEW_FACTOR));
+
+    // The whole image in color, where the first output will be
+    LIC::Output output;
+    output.filename = m_LIC -> GetOutputs().first().filename;
+    m_Preview -> SetOutputs({ output });
+
+    QElapsedTimer timer;
+    timer.start();
+    if (m_Preview -> Execute())
+    {
+        qDebug().noquote() << QString("Preview %1x%2 in %3 s.")
+            .arg(QString::number(width),
+                 QString::number(height),
+                 QString::number(timer.nsecsElapsed() * 1e-9, 'f', 2));
+    }
+}
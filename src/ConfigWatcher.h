@@ -0,0 +1,83 @@
+// ConfigWatcher.h
+// Class definition
+
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+// Project includes
+#include "ProgressReporter.h"
+
+// Qt includes
+#include <QDateTime>
+#include <QFileSystemWatcher>
+#include <QString>
+#include <QTimer>
+
+// Forward declaration
+class LIC;
+
+
+
+// Define class
+class ConfigWatcher
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    ConfigWatcher(const QString mcFilename);
+
+    // Destructor
+    virtual ~ConfigWatcher();
+
+
+
+    // ========================================================== Configuration
+public:
+    // Number of threads used for tracing (0: one per core)
+    void SetNumThreads(int mNumThreads);
+
+    // How progress is shown while tracing
+    void SetProgressMode(ProgressReporter::Mode mMode);
+
+private:
+    QString m_Filename;
+
+
+
+    // ========================================================== Functionality
+public:
+    // Render now and again whenever the configuration changes; only returns
+    // when the application quits
+    int Execute();
+
+private:
+    // Configuration file has been written to
+    void FileChanged();
+
+    // Render with whatever is still valid from the last time; returns false
+    // if the configuration is invalid or it changed while rendering
+    bool Render();
+
+    // Quick image at a fraction of the resolution, written to the first
+    // output before the full image is traced
+    void RenderPreview();
+
+    // Noise and traced image stay in this renderer between changes; the
+    // keys say what they were computed for (empty: nothing valid)
+    LIC * m_LIC;
+    QString m_NoiseKey;
+    QString m_TracingKey;
+
+    // Renderer for previews
+    LIC * m_Preview;
+
+    // Editors often save in several steps (or replace the file), so changes
+    // are collected for a moment before rendering
+    QFileSystemWatcher m_FileWatcher;
+    QTimer m_ChangeTimer;
+
+    // Modification time of the file when rendering started
+    QDateTime m_RenderedModified;
+};
+
+#endif
@@ -0,0 +1,141 @@
+// CpuDispatch.cpp
+// Class implementation
+
+// Project includes
+#include "CpuDispatch.h"
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+CpuDispatch::CpuDispatch()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Newest instruction set this CPU supports
+CpuDispatch::ISA CpuDispatch::GetDetectedISA()
+{
+#if defined(LIC_SIMD_X86)
+    // Also checks that the operating system saves the wider registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512dq"))
+    {
+        return ISA_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        return ISA_SSE42;
+    }
+#endif
+    return ISA_Generic;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Instruction set whose kernels are used
+CpuDispatch::ISA CpuDispatch::GetISA()
+{
+    return SelectedISA();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Use the kernels of another instruction set
+bool CpuDispatch::SetISA(ISA mISA)
+{
+    if (mISA > GetDetectedISA())
+    {
+        return false;
+    }
+    SelectedISA() = mISA;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Instruction set from its command line name
+bool CpuDispatch::ISAFromString(const QString mcName, ISA & mrISA)
+{
+    for (ISA isa : { ISA_Generic, ISA_SSE42, ISA_AVX2, ISA_AVX512 })
+    {
+        if (mcName == ISAToString(isa))
+        {
+            mrISA = isa;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Command line name of an instruction set
+QString CpuDispatch::ISAToString(ISA mISA)
+{
+    if (mISA == ISA_SSE42)
+    {
+        return "sse4.2";
+    }
+    if (mISA == ISA_AVX2)
+    {
+        return "avx2";
+    }
+    if (mISA == ISA_AVX512)
+    {
+        return "avx512";
+    }
+    return "generic";
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels of the instruction set in use
+const SimdKernels & CpuDispatch::GetKernels()
+{
+    const ISA isa = SelectedISA();
+    if (isa == ISA_SSE42)
+    {
+        return SimdKernels::GetSSE42();
+    }
+    if (isa == ISA_AVX2)
+    {
+        return SimdKernels::GetAVX2();
+    }
+    if (isa == ISA_AVX512)
+    {
+        return SimdKernels::GetAVX512();
+    }
+    return SimdKernels::GetGeneric();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Instruction set in use; detected on first use
+CpuDispatch::ISA & CpuDispatch::SelectedISA()
+{
+    static ISA isa = GetDetectedISA();
+    return isa;
+}
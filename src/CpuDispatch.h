@@ -0,0 +1,59 @@
+// CpuDispatch.h
+// Class definition
+
+#ifndef CPUDISPATCH_H
+#define CPUDISPATCH_H
+
+// Project includes
+#include "SimdKernels.h"
+
+// Qt includes
+#include <QString>
+
+
+
+// Define class
+class CpuDispatch
+{
+    // ============================================================== Lifecycle
+private:
+    // Constructor; only static methods
+    CpuDispatch();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Instruction sets there are kernels for, from oldest to newest
+    enum ISA
+    {
+        ISA_Generic,
+        ISA_SSE42,
+        ISA_AVX2,
+        ISA_AVX512
+    };
+
+    // Newest instruction set this CPU supports
+    static ISA GetDetectedISA();
+
+    // Instruction set whose kernels are used (default: the detected one)
+    static ISA GetISA();
+
+    // Use the kernels of another instruction set; returns false if this CPU
+    // doesn't support it. Only to be called while nothing is rendered.
+    static bool SetISA(ISA mISA);
+
+    // Instruction set from its command line name ("generic", "sse4.2",
+    // "avx2", "avx512"), and back
+    static bool ISAFromString(const QString mcName, ISA & mrISA);
+    static QString ISAToString(ISA mISA);
+
+    // Kernels of the instruction set in use
+    static const SimdKernels & GetKernels();
+
+private:
+    // Instruction set in use
+    static ISA & SelectedISA();
+};
+
+#endif
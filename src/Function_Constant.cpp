@@ -84,10 +84,22 @@ QString Function_Constant::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Constant::Clone() const
+{
+    Function_Constant * copy = new Function_Constant();
+    copy -> m_ConstantText = m_ConstantText;
+    copy -> m_Constant = m_Constant;
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Constant::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     Q_UNUSED(mcVariables)
 
@@ -132,10 +132,21 @@ QString Function_Cos::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Cos::Clone() const
+{
+    Function_Cos * copy = new Function_Cos();
+    copy -> m_Argument = m_Argument -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Cos::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double argument = m_Argument -> Evaluate(mcVariables);
     return cos(argument);
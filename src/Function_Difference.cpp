@@ -154,10 +154,22 @@ QString Function_Difference::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Difference::Clone() const
+{
+    Function_Difference * copy = new Function_Difference();
+    copy -> m_LeftFunction = m_LeftFunction -> Clone();
+    copy -> m_RightFunction = m_RightFunction -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Difference::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double left = m_LeftFunction -> Evaluate(mcVariables);
     const double right = m_RightFunction -> Evaluate(mcVariables);
@@ -131,10 +131,21 @@ QString Function_Exp::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Exp::Clone() const
+{
+    Function_Exp * copy = new Function_Exp();
+    copy -> m_Argument = m_Argument -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Exp::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double argument = m_Argument -> Evaluate(mcVariables);
     return exp(argument);
@@ -152,10 +152,22 @@ QString Function_Exponent::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Exponent::Clone() const
+{
+    Function_Exponent * copy = new Function_Exponent();
+    copy -> m_LeftFunction = m_LeftFunction -> Clone();
+    copy -> m_RightFunction = m_RightFunction -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Exponent::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double left = m_LeftFunction -> Evaluate(mcVariables);
     const double right = m_RightFunction -> Evaluate(mcVariables);
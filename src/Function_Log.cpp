@@ -131,10 +131,21 @@ QString Function_Log::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Log::Clone() const
+{
+    Function_Log * copy = new Function_Log();
+    copy -> m_Argument = m_Argument -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Log::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double argument = m_Argument -> Evaluate(mcVariables);
     return log(argument);
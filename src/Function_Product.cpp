@@ -148,9 +148,21 @@ QString Function_Product::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Product::Clone() const
+{
+    Function_Product * copy = new Function_Product();
+    copy -> m_LeftFunction = m_LeftFunction -> Clone();
+    copy -> m_RightFunction = m_RightFunction -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
-double Function_Product::Evaluate(const QHash < QString, double > mcVariables
+double Function_Product::Evaluate(const QHash < QString, double > & mcVariables
     ) const
 {
     const double left = m_LeftFunction -> Evaluate(mcVariables);
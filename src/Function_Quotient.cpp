@@ -149,10 +149,22 @@ QString Function_Quotient::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Quotient::Clone() const
+{
+    Function_Quotient * copy = new Function_Quotient();
+    copy -> m_LeftFunction = m_LeftFunction -> Clone();
+    copy -> m_RightFunction = m_RightFunction -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
-double Function_Quotient::Evaluate(const QHash < QString, double > mcVariables
-    ) const
+double Function_Quotient::Evaluate(
+    const QHash < QString, double > & mcVariables) const
 {
     const double left = m_LeftFunction -> Evaluate(mcVariables);
     const double right = m_RightFunction -> Evaluate(mcVariables);
@@ -97,19 +97,32 @@ bool Function_Sign::IsSimple() const
 // Serialize to String
 QString Function_Sign::ToString() const
 {
+    // Parenthesized, so it's parsed as a sign wherever it ends up
     const QString argument = m_Argument -> ToString();
-    const QString sign = (m_Sign == "-" ? "-" : "");
-    return QString("%1sign(%2)")
+    const QString sign = (m_Sign == "-" ? "-" : "+");
+    return QString("(%1(%2))")
         .arg(sign,
              argument);
 }
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Sign::Clone() const
+{
+    Function_Sign * copy = new Function_Sign();
+    copy -> m_Sign = m_Sign;
+    copy -> m_Argument = m_Argument -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Sign::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double argument = m_Argument -> Evaluate(mcVariables);
     if (m_Sign == "-")
@@ -131,10 +131,21 @@ QString Function_Sin::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Sin::Clone() const
+{
+    Function_Sin * copy = new Function_Sin();
+    copy -> m_Argument = m_Argument -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
 double Function_Sin::Evaluate(
-    const QHash < QString, double > mcVariables) const
+    const QHash < QString, double > & mcVariables) const
 {
     const double argument = m_Argument -> Evaluate(mcVariables);
     return sin(argument);
@@ -154,9 +154,21 @@ QString Function_Sum::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Sum::Clone() const
+{
+    Function_Sum * copy = new Function_Sum();
+    copy -> m_LeftFunction = m_LeftFunction -> Clone();
+    copy -> m_RightFunction = m_RightFunction -> Clone();
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
-double Function_Sum::Evaluate(const QHash < QString, double > mcVariables
+double Function_Sum::Evaluate(const QHash < QString, double > & mcVariables
     ) const
 {
     const double left = m_LeftFunction -> Evaluate(mcVariables);
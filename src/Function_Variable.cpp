@@ -83,10 +83,21 @@ QString Function_Variable::ToString() const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Deep copy
+AbstractFunction * Function_Variable::Clone() const
+{
+    Function_Variable * copy = new Function_Variable();
+    copy -> m_VariableName = m_VariableName;
+    return copy;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Evaluate
-double Function_Variable::Evaluate(const QHash < QString, double > mcVariables
-    ) const
+double Function_Variable::Evaluate(
+    const QHash < QString, double > & mcVariables) const
 {
     // Check if variable is known
     if (mcVariables.contains(m_VariableName))
@@ -35,8 +35,12 @@ public:
     // Serialize to String
     virtual QString ToString() const;
 
+    // Deep copy
+    virtual AbstractFunction * Clone() const;
+
     // Evaluate
-    virtual double Evaluate(const QHash < QString, double > mcVariables) const;
+    virtual double Evaluate(
+        const QHash < QString, double > & mcVariables) const;
 
 private:
     QString m_VariableName;
@@ -3,21 +3,102 @@
 
 // Project includes
 #include <AbstractFunction.h>
+#include <Colormap.h>
+#include <CpuDispatch.h>
 #include <LIC.h>
 #include <Macros.h>
 #include <MessageLogger.h>
+#include <NumaTopology.h>
+#include <ProcessPool.h>
+#include <ProgressReporter.h>
+#include <PyramidRenderer.h>
 #include <QTextStream>
+#include <SimdKernels.h>
+#include <ThreadPool.h>
+#include <TileScheduler.h>
 
 // Qt includes
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QColor>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QImage>
-#include <QPixmap>
 #include <QRegularExpression>
+#include <QThread>
 
 // System includes
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <vector>
+
+
+
+// Size of the square tiles the image is traced in, unless tuned
+static const int DEFAULT_TILE_SIZE = 64;
+
+// Tiles are traced in this many interleaved passes (see TraceTargets()),
+// unless tuned
+static const int DEFAULT_TILE_INTERLEAVE = 16;
+
+// Names of the coordinates when evaluating the vector field. Creating a
+// QString from a literal allocates, which we don't want in the tracer.
+static const QString variable_x("x");
+static const QString variable_y("y");
+
+// How often tracing with worker processes collects finished tiles and
+// calls the callbacks
+static const int PROCESS_POLL_INTERVAL_MS = 20;
+
+// State of tracing with worker processes, in memory shared with them
+struct SharedTraceState
+{
+    std::atomic < int > next_item;
+    std::atomic < bool > cancel;
+    std::atomic < qint64 > pixels_done;
+    std::atomic < qint64 > steps_done;
+};
+struct SharedTraceCounters
+{
+    qint64 field_evaluations;
+    qint64 steps;
+    qint64 singularity_breaks;
+    double length;
+};
+
+// Memory the images of a parameter sweep may use while being traced
+static const qint64 SWEEP_MEMORY_BUDGET = qint64(1) << 30;
+
+// Valid names of parameters of the vector field
+static const QRegularExpression parameter_name_format(
+    "^[a-zA-Z_][a-zA-Z0-9_]*$");
+
+// Sequential noise: the same numbers as srand48() and drand48(), but with
+// its own state, so renderers generating noise on several threads (batch
+// jobs, server connections) don't take turns with one global generator
+class SequentialRandom
+{
+public:
+    explicit SequentialRandom(int mSeed)
+    {
+        m_State = (quint64(quint32(mSeed)) << 16) | 0x330E;
+    }
+    double Next()
+    {
+        m_State = (m_State * 0x5DEECE66DULL + 0xB) & ((1ULL << 48) - 1);
+        return double(m_State) / double(1ULL << 48);
+    }
+
+private:
+    quint64 m_State;
+};
 
 
 
@@ -36,8 +117,51 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 // Constructor
-LIC::LIC()
+LIC::LIC() :
+    m_CancelRequested(false)
 {
+    m_ProgressMode = ProgressReporter::GetDefaultMode();
+    m_NumThreads = 0;
+    m_Backend = Backend_Threads;
+    m_TileSize = DEFAULT_TILE_SIZE;
+    m_TileInterleave = DEFAULT_TILE_INTERLEAVE;
+    m_NUMAPlacement = true;
+    m_PinThreads = false;
+    m_DistributedPlane = nullptr;
+    m_ThreadPool = nullptr;
+    m_Scheduler = nullptr;
+    m_Priority = 0;
+    m_Deadline = QDeadlineTimer::Forever;
+    m_TilesDonePlane = nullptr;
+    m_Vectorfield_X = nullptr;
+    m_Vectorfield_Y = nullptr;
+    m_Vectorfield_Iterate = 1;
+    m_Sweep_From = 0.;
+    m_Sweep_To = 0.;
+    m_Sweep_Count = 0;
+    m_Sweep_ContactSheet = false;
+    m_Sweep_Columns = 1;
+    m_Pyramid_Layout = PyramidLayout_XYZ;
+    m_Pyramid_TileSize = 256;
+    m_BackgroundType = "white noise";
+    m_BackgroundSeed = 0;
+    m_Noise_ByPosition = false;
+    m_WhiteNoise_Cutoff = 0.5;
+    m_Checkerboard_Width = 1;
+    m_Gaussian_Sigma = 1.;
+    m_Gaussian_Low = 0.;
+    m_Gaussian_High = 1.;
+    m_Steps = 0;
+    m_Image_XMin = 0.;
+    m_Image_XMax = 0.;
+    m_Image_YMin = 0.;
+    m_Image_YMax = 0.;
+    m_Image_Width = 0;
+    m_Image_Height = 0;
+    m_Frame_Width = 0;
+    m_Frame_Height = 0;
+    m_Colormap = nullptr;
+    m_Coloring_LogScale = false;
     m_IsValid = false;
 }
 
@@ -48,12 +172,12 @@ LIC::LIC()
 LIC::~LIC()
 {
     // Delete functions
-    for (auto coordinate_iterator = m_Vectorfield.keyBegin();
-         coordinate_iterator != m_Vectorfield.keyEnd();
-         coordinate_iterator++)
+    ClearVectorfield();
+
+    // Delete colormap
+    if (m_Colormap)
     {
-        const QString coordinate = *coordinate_iterator;
-        delete m_Vectorfield[coordinate];
+        delete m_Colormap;
     }
 }
 
@@ -67,6 +191,10 @@ LIC::~LIC()
 // Read configuration
 bool LIC::ReadXMLConfiguration(const QString mcFilename)
 {
+    PerformanceReport::StageTimer timer(m_PerformanceReport,
+        "ReadXMLConfiguration");
+    m_PerformanceReport.SetInfo("configuration", mcFilename);
+
     QFile input_file(mcFilename);
     if (!input_file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
@@ -76,10 +204,20 @@ bool LIC::ReadXMLConfiguration(const QString mcFilename)
     }
     QTextStream stream(&input_file);
     const QString xml = stream.readAll();
+    return SetXMLConfiguration(xml);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration from XML text
+bool LIC::SetXMLConfiguration(const QString mcXML)
+{
+    m_IsValid = false;
 
     // Parse as XML
     QDomDocument dom("stuff");
-    QDomDocument::ParseResult parse_result = dom.setContent(xml);
+    QDomDocument::ParseResult parse_result = dom.setContent(mcXML);
     if (!parse_result.errorMessage.isEmpty())
     {
         const QString reason = tr("XML cannot be parsed - %1#%2#%3")
@@ -91,27 +229,72 @@ bool LIC::ReadXMLConfiguration(const QString mcFilename)
         return false;
     }
 
+    return SetConfiguration(dom.firstChildElement("lic"));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration from a parsed <lic> element
+bool LIC::SetConfiguration(const QDomElement & mcDomLIC)
+{
+    m_IsValid = false;
+
+    // Coloring is optional, so don't keep the one of a previous
+    // configuration
+    delete m_Colormap;
+    m_Colormap = nullptr;
+    m_Coloring_LogScale = false;
+
     // Parse everything
-    QDomElement dom_lic = dom.firstChildElement("lic");
-    QDomElement dom_vectorfield = dom_lic.firstChildElement("vectorfield");
+    QDomElement dom_vectorfield = mcDomLIC.firstChildElement("vectorfield");
+    m_PerformanceReport.StartStage("ParseVectorfield");
     bool success = ParseVectorfield(dom_vectorfield);
+    m_PerformanceReport.EndStage("ParseVectorfield");
     if (!success)
     {
         return false;
     }
-    QDomElement dom_background = dom_lic.firstChildElement("background");
+    QDomElement dom_background = mcDomLIC.firstChildElement("background");
     success = ParseBackground(dom_background);
     if (!success)
     {
         return false;
     }
-    QDomElement dom_image = dom_lic.firstChildElement("image");
+    QDomElement dom_image = mcDomLIC.firstChildElement("image");
     success = ParseImage(dom_image);
     if (!success)
     {
         return false;
     }
 
+    // Tiles of pyramids are rendered by renderers of their own
+    m_ConfigurationXML.clear();
+    if (HasPyramid())
+    {
+        QTextStream stream(&m_ConfigurationXML);
+        mcDomLIC.save(stream, 0);
+    }
+
+    // Describe what is being rendered
+    m_PerformanceReport.SetInfo("width", m_Image_Width);
+    m_PerformanceReport.SetInfo("height", m_Image_Height);
+    m_PerformanceReport.SetInfo("steps", m_Steps);
+    m_PerformanceReport.SetInfo("threads", GetNumThreads());
+    m_PerformanceReport.SetInfo("backend",
+        (m_Backend == Backend_Processes ? "processes" : "threads"));
+    m_PerformanceReport.SetInfo("numa_nodes", (m_NUMAPlacement ?
+        NumaTopology::GetHost().GetNumNodes() : 1));
+    m_PerformanceReport.SetInfo("pinned_threads", m_PinThreads);
+    m_PerformanceReport.SetInfo("isa",
+        CpuDispatch::ISAToString(CpuDispatch::GetISA()));
+    m_PerformanceReport.SetInfo("isa_detected",
+        CpuDispatch::ISAToString(CpuDispatch::GetDetectedISA()));
+    m_PerformanceReport.SetInfo("iterations", m_Vectorfield_Iterate);
+    m_PerformanceReport.SetInfo("background", m_BackgroundType);
+    m_PerformanceReport.SetInfo("formula_x", m_Vectorfield["x"] -> ToString());
+    m_PerformanceReport.SetInfo("formula_y", m_Vectorfield["y"] -> ToString());
+
     // Done
     m_IsValid = true;
     return true;
@@ -119,6 +302,304 @@ bool LIC::ReadXMLConfiguration(const QString mcFilename)
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Vector field from functions
+bool LIC::SetVectorfield(AbstractFunction * mpFunctionX,
+    AbstractFunction * mpFunctionY,
+    const QHash < QString, double > mcParameters, int mIterations)
+{
+    // Check
+    QString reason;
+    if (!mpFunctionX ||
+        !mpFunctionY)
+    {
+        reason = "Both x and y vector fields need to be specified.";
+    }
+    if (mIterations < 1)
+    {
+        reason = QString("Invalid number of iterations %1; needs to be at "
+            "least 1.").arg(mIterations);
+    }
+    for (auto parameter_iterator = mcParameters.keyBegin();
+         parameter_iterator != mcParameters.keyEnd();
+         parameter_iterator++)
+    {
+        const QString name = *parameter_iterator;
+        if (!parameter_name_format.match(name).hasMatch() ||
+            name == "x" ||
+            name == "y")
+        {
+            reason = QString("Parameter name \"%1\" cannot be used.")
+                .arg(name);
+        }
+    }
+    if (!reason.isEmpty())
+    {
+        MessageLogger::Error(METHOD_NAME, reason);
+        delete mpFunctionX;
+        delete mpFunctionY;
+        return false;
+    }
+
+    // Replace the vector field
+    ClearVectorfield();
+    m_Parameters = mcParameters;
+    m_Vectorfield["x"] = mpFunctionX;
+    m_Vectorfield["y"] = mpFunctionY;
+    m_Vectorfield_X = mpFunctionX;
+    m_Vectorfield_Y = mpFunctionY;
+    m_Vectorfield_Iterate = mIterations;
+    m_IsValid = IsComplete();
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Vector field from formulas
+bool LIC::SetVectorfield(const QString mcFormulaX, const QString mcFormulaY,
+    const QHash < QString, double > mcParameters, int mIterations)
+{
+    AbstractFunction * function_x =
+        AbstractFunction::CreateFunction(mcFormulaX);
+    if (!function_x)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Formula \"%1\" for x coordinate cannot be parsed.")
+                .arg(mcFormulaX));
+        return false;
+    }
+    AbstractFunction * function_y =
+        AbstractFunction::CreateFunction(mcFormulaY);
+    if (!function_y)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Formula \"%1\" for y coordinate cannot be parsed.")
+                .arg(mcFormulaY));
+        delete function_x;
+        return false;
+    }
+    return SetVectorfield(function_x, function_y, mcParameters,
+        mIterations);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Region of the plane shown in the image
+bool LIC::SetImageRange(double mXMin, double mXMax, double mYMin,
+    double mYMax)
+{
+    if (mXMin == mXMax ||
+        mYMin == mYMax)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Image range [%1, %2] x [%3, %4] is empty.")
+                .arg(QString::number(mXMin),
+                     QString::number(mXMax),
+                     QString::number(mYMin),
+                     QString::number(mYMax)));
+        return false;
+    }
+    m_Image_XMin = mXMin;
+    m_Image_XMax = mXMax;
+    m_Image_YMin = mYMin;
+    m_Image_YMax = mYMax;
+    m_IsValid = IsComplete();
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the image
+bool LIC::SetResolution(int mWidth, int mHeight)
+{
+    // Same limits as in <lic><image><resolution>
+    if (mWidth < 10 ||
+        mHeight < 10)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid resolution %1x%2; needs to be at least 10x10.")
+                .arg(QString::number(mWidth),
+                     QString::number(mHeight)));
+        return false;
+    }
+    m_Image_Width = mWidth;
+    m_Image_Height = mHeight;
+    m_ROI = QRect();
+    m_IsValid = IsComplete();
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of steps in each direction
+bool LIC::SetSteps(int mSteps)
+{
+    if (mSteps < 1)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid number of steps %1; needs to be at least 1.")
+                .arg(mSteps));
+        return false;
+    }
+    m_Steps = mSteps;
+    m_IsValid = IsComplete();
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// White noise background
+bool LIC::SetWhiteNoiseBackground(double mCutoff, int mSeed)
+{
+    if (mCutoff < 0. ||
+        mCutoff > 1.)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid background cutoff %1. Must be a value between "
+                "0.0 and 1.0.").arg(mCutoff));
+        return false;
+    }
+    m_BackgroundType = "white noise";
+    m_WhiteNoise_Cutoff = mCutoff;
+    m_BackgroundSeed = mSeed;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Coloring by strength of the vector field (empty colormap: grayscale)
+bool LIC::SetColoring(const QString mcColormap, double mGamma,
+    bool mLogScale)
+{
+    Colormap * colormap = nullptr;
+    if (!mcColormap.isEmpty())
+    {
+        colormap = Colormap::CreateColormap(mcColormap, mGamma);
+        if (!colormap)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Unknown colormap \"%1\" or invalid gamma %2.")
+                    .arg(mcColormap,
+                         QString::number(mGamma)));
+            return false;
+        }
+    }
+    delete m_Colormap;
+    m_Colormap = colormap;
+    m_Coloring_LogScale = mLogScale;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the image
+int LIC::GetImageWidth() const
+{
+    return m_Image_Width;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the image
+int LIC::GetImageHeight() const
+{
+    return m_Image_Height;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Formulas of the vector field
+QPair < QString, QString > LIC::GetVectorfieldFormulas() const
+{
+    return QPair < QString, QString >(
+        (m_Vectorfield_X ? m_Vectorfield_X -> ToString() : QString()),
+        (m_Vectorfield_Y ? m_Vectorfield_Y -> ToString() : QString()));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// How often the vector field is iterated
+int LIC::GetVectorfieldIterations() const
+{
+    return m_Vectorfield_Iterate;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Steps of a streamline in each direction
+int LIC::GetSteps() const
+{
+    return m_Steps;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Part of the plane the image shows
+void LIC::GetImageRange(double & mrXMin, double & mrXMax, double & mrYMin,
+    double & mrYMax) const
+{
+    mrXMin = m_Image_XMin;
+    mrXMax = m_Image_XMax;
+    mrYMin = m_Image_YMin;
+    mrYMax = m_Image_YMax;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// The configuration has been read without errors
+bool LIC::IsValid() const
+{
+    return m_IsValid;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// A parameter is swept
+bool LIC::HasSweep() const
+{
+    return !m_Sweep_Parameter.isEmpty();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Execute() renders a tile pyramid
+bool LIC::HasPyramid() const
+{
+    return !m_Pyramid_Directory.isEmpty();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Everything needed for rendering has been set
+bool LIC::IsComplete() const
+{
+    return m_Vectorfield_X &&
+        m_Vectorfield_Y &&
+        m_Steps >= 1 &&
+        m_Image_Width >= 10 &&
+        m_Image_Height >= 10 &&
+        m_Image_XMin != m_Image_XMax &&
+        m_Image_YMin != m_Image_YMax;
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Vectorfield
 bool LIC::ParseVectorfield(QDomElement & mrDomVectorfield)
@@ -131,8 +612,10 @@ bool LIC::ParseVectorfield(QDomElement & mrDomVectorfield)
         return false;
     }
 
+    // Start from scratch if a configuration is set again
+    ClearVectorfield();
+
     // Read parameters
-    static const QRegularExpression format_name("^[a-zA-Z_][a-zA-Z0-9_]*$");
     static const QRegularExpression format_value("^[0-9]+(\\.[0-9]*)?$");
     QDomElement dom_parameters =
         mrDomVectorfield.firstChildElement("parameters");
@@ -144,7 +627,8 @@ bool LIC::ParseVectorfield(QDomElement & mrDomVectorfield)
              dom_parameter = dom_parameter.nextSiblingElement("parameter"))
         {
             const QString name = dom_parameter.attribute("name");
-            const QRegularExpressionMatch match_name = format_name.match(name);
+            const QRegularExpressionMatch match_name =
+                parameter_name_format.match(name);
             if (!match_name.hasMatch())
             {
                 MessageLogger::Error(METHOD_NAME,
@@ -240,12 +724,125 @@ bool LIC::ParseVectorfield(QDomElement & mrDomVectorfield)
         return false;
     }
 
+    // Direct access while tracing
+    m_Vectorfield_X = m_Vectorfield["x"];
+    m_Vectorfield_Y = m_Vectorfield["y"];
+
+    // Parameter sweep (optional)
+    QDomElement dom_sweep = mrDomVectorfield.firstChildElement("sweep");
+    if (!dom_sweep.isNull())
+    {
+        const bool success = ParseSweep(dom_sweep);
+        if (!success)
+        {
+            return false;
+        }
+    }
+
+    // Done
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Parameter sweep
+bool LIC::ParseSweep(QDomElement & mrDomSweep)
+{
+    // Parameter
+    const QString name = mrDomSweep.attribute("parameter");
+    if (!parameter_name_format.match(name).hasMatch() ||
+        name == "x" ||
+        name == "y")
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Parameter name \"%1\" in <lic><vectorfield><sweep> "
+                "cannot be swept.").arg(name));
+        return false;
+    }
+
+    // Range of values
+    bool from_ok = false;
+    bool to_ok = false;
+    bool count_ok = false;
+    const double from = mrDomSweep.attribute("from").toDouble(&from_ok);
+    const double to = mrDomSweep.attribute("to").toDouble(&to_ok);
+    const int count = mrDomSweep.attribute("count").toInt(&count_ok);
+    if (!from_ok ||
+        !to_ok ||
+        !count_ok ||
+        count < 1)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("<lic><vectorfield><sweep> needs numbers \"from\" and "
+                "\"to\", and a \"count\" of at least 1."));
+        return false;
+    }
+
+    // Output
+    const QString layout = mrDomSweep.attribute("layout", "frames");
+    if (layout != "frames" &&
+        layout != "sheet")
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid layout \"%1\" in <lic><vectorfield><sweep>. "
+                "Must be \"frames\" or \"sheet\".").arg(layout));
+        return false;
+    }
+    int columns = int(ceil(sqrt(double(count))));
+    if (mrDomSweep.hasAttribute("columns"))
+    {
+        columns = mrDomSweep.attribute("columns").toInt();
+        if (columns < 1)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Invalid number of columns \"%1\" in "
+                    "<lic><vectorfield><sweep>.")
+                    .arg(mrDomSweep.attribute("columns")));
+            return false;
+        }
+    }
+
+    m_Sweep_Parameter = name;
+    m_Sweep_From = from;
+    m_Sweep_To = to;
+    m_Sweep_Count = count;
+    m_Sweep_ContactSheet = (layout == "sheet");
+    m_Sweep_Columns = columns;
+
+    // The swept parameter is a variable like any other, so the formulas
+    // don't change between frames
+    if (!m_Parameters.contains(name))
+    {
+        m_Parameters[name] = from;
+    }
+
     // Done
     return true;
 }
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Delete vector field and its parameters
+void LIC::ClearVectorfield()
+{
+    for (auto coordinate_iterator = m_Vectorfield.keyBegin();
+         coordinate_iterator != m_Vectorfield.keyEnd();
+         coordinate_iterator++)
+    {
+        const QString coordinate = *coordinate_iterator;
+        delete m_Vectorfield[coordinate];
+    }
+    m_Vectorfield.clear();
+    m_Vectorfield_X = nullptr;
+    m_Vectorfield_Y = nullptr;
+    m_Parameters.clear();
+    m_Sweep_Parameter.clear();
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Background
 bool LIC::ParseBackground(QDomElement & mrDomBackground)
@@ -331,6 +928,19 @@ bool LIC::ParseBackground(QDomElement & mrDomBackground)
     }
     m_BackgroundSeed = mrDomBackground.attribute("seed", "0").toInt();
 
+    // How random values are generated; "sequence" keeps the images of
+    // existing configurations as they are
+    const QString noise = mrDomBackground.attribute("noise", "sequence");
+    if (noise != "sequence" &&
+        noise != "position")
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid noise \"%1\" in <lic><background>. Must be "
+                "\"sequence\" or \"position\".").arg(noise));
+        return false;
+    }
+    m_Noise_ByPosition = (noise == "position");
+
     // Done
     return true;
 }
@@ -429,22 +1039,61 @@ bool LIC::ParseImage(QDomElement & mrDomImage)
         return false;
     }
 
-    // Output
-    QDomElement dom_output = mrDomImage.firstChildElement("output");
-    if (dom_output.isNull())
+    // Region of interest (optional)
+    m_ROI = QRect();
+    QDomElement dom_roi = mrDomImage.firstChildElement("roi");
+    if (!dom_roi.isNull())
     {
-        MessageLogger::Error(METHOD_NAME,
-            QString("<lic><image> does not appear to have a <output> tag."));
-        return false;
+        const bool success = ParseROI(dom_roi);
+        if (!success)
+        {
+            return false;
+        }
+    }
+
+    // Tile pyramid (optional)
+    m_Pyramid_Directory.clear();
+    QDomElement dom_pyramid = mrDomImage.firstChildElement("pyramid");
+    if (!dom_pyramid.isNull())
+    {
+        const bool success = ParsePyramid(dom_pyramid);
+        if (!success)
+        {
+            return false;
+        }
+    }
+
+    // Outputs; a pyramid doesn't need any
+    m_Outputs.clear();
+    for (QDomElement dom_output = mrDomImage.firstChildElement("output");
+         !dom_output.isNull();
+         dom_output = dom_output.nextSiblingElement("output"))
+    {
+        const bool success = ParseOutput(dom_output);
+        if (!success)
+        {
+            return false;
+        }
     }
-    m_OutputFilename = dom_output.attribute("filename");
-    if (m_OutputFilename.isEmpty())
+    if (m_Outputs.isEmpty() &&
+        !HasPyramid())
     {
         MessageLogger::Error(METHOD_NAME,
-            QString("<lic><image><output> specifies an empty file name."));
+            QString("<lic><image> does not appear to have a <output> tag."));
         return false;
     }
 
+    // Coloring (optional)
+    QDomElement dom_coloring = mrDomImage.firstChildElement("coloring");
+    if (!dom_coloring.isNull())
+    {
+        const bool success = ParseColoring(dom_coloring);
+        if (!success)
+        {
+            return false;
+        }
+    }
+
     // Done
     return true;
 }
@@ -452,352 +1101,2468 @@ bool LIC::ParseImage(QDomElement & mrDomImage)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Create the LIC image
-void LIC::Execute()
+// Region of interest
+bool LIC::ParseROI(QDomElement & mrDomROI)
 {
-    // Check if parameters are valid
-    if (!m_IsValid)
+    // The noise of a sequence depends on everything generated before, so
+    // only the whole frame would match
+    if (!m_Noise_ByPosition)
     {
         MessageLogger::Error(METHOD_NAME,
-            QString("Set of parameters isn't valid; can't execute."));
-        return;
+            QString("<lic><image><roi> needs noise that matches the full "
+                "frame; use noise=\"position\" in <lic><background>."));
+        return false;
     }
 
-    // Generate underlying noise patters
-    GenerateNoise();
+    // Pixels of the frame given in <resolution>
+    const QRect roi(mrDomROI.attribute("x", "0").toInt(),
+        mrDomROI.attribute("y", "0").toInt(),
+        mrDomROI.attribute("width", "0").toInt(),
+        mrDomROI.attribute("height", "0").toInt());
+    if (roi.width() < 10 ||
+        roi.height() < 10 ||
+        !QRect(0, 0, m_Image_Width, m_Image_Height).contains(roi))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("<lic><image><roi> needs to be at least 10x10 pixels "
+                "inside of the %1x%2 frame.")
+                .arg(QString::number(m_Image_Width),
+                     QString::number(m_Image_Height)));
+        return false;
+    }
+
+    // From here on, the image is the region
+    SetROI(roi);
+    m_PerformanceReport.SetInfo("frame_width", m_Frame_Width);
+    m_PerformanceReport.SetInfo("frame_height", m_Frame_Height);
+    return true;
+}
 
-    // Generate LIC
-    GenerateLIC();
 
-    // Generate Image
-    GenerateImage();
+
+///////////////////////////////////////////////////////////////////////////////
+// Only render a part of the frame
+void LIC::SetROI(const QRect & mcROI)
+{
+    const QSize frame = GetFrameSize();
+    m_ROI = mcROI;
+    m_Frame_Width = frame.width();
+    m_Frame_Height = frame.height();
+    m_Image_Width = mcROI.width();
+    m_Image_Height = mcROI.height();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Generate underlying noise patterm
-void LIC::GenerateNoise()
+// Size of the virtual frame
+QSize LIC::GetFrameSize() const
 {
-    // Background noise
-    m_Noise_R.reserve(m_Image_Width * m_Image_Height);
-    m_Noise_G.reserve(m_Image_Width * m_Image_Height);
-    m_Noise_B.reserve(m_Image_Width * m_Image_Height);
+    return (m_ROI.isEmpty() ?
+        QSize(m_Image_Width, m_Image_Height) :
+        QSize(m_Frame_Width, m_Frame_Height));
+}
 
-    // Apply random seed
-    srand48(m_BackgroundSeed);
 
-    // This could be generated in a more efficient way, but we like to keep
-    // it this way so we can implement other ways more easily.
-    for (int ix = 0; ix < m_Image_Width; ix++)
+
+///////////////////////////////////////////////////////////////////////////////
+// Tile pyramid
+bool LIC::ParsePyramid(QDomElement & mrDomPyramid)
+{
+    // Tiles are regions of interest of their level
+    if (!m_Noise_ByPosition ||
+        !m_ROI.isEmpty() ||
+        HasSweep())
     {
-        for (int iy = 0; iy < m_Image_Height; iy++)
-        {
-            const int idx = ix * m_Image_Height + iy;
-            bool is_white = false;
+        MessageLogger::Error(METHOD_NAME,
+            QString("<lic><image><pyramid> needs noise=\"position\" in "
+                "<lic><background>, and can't be combined with <roi> or a "
+                "sweep."));
+        return false;
+    }
 
-            // Check type of noise
-            if (m_BackgroundType == "white noise")
-            {
-                is_white = (drand48() > m_WhiteNoise_Cutoff);
-            }
-            if (m_BackgroundType == "checkerboard")
-            {
-                is_white = (((ix + iy) / m_Checkerboard_Width) % 2 == 0);
-            }
-            if (m_BackgroundType == "gaussian")
-            {
-                double x = ix * 1. / (m_Image_Width - 1.);
-                x = m_Image_XMin + (m_Image_XMax - m_Image_XMin) * x;
-                x = x - 0.5 * (m_Image_XMax + m_Image_XMin);
-                double y = iy * 1. / (m_Image_Height - 1.);
-                y = m_Image_YMin + (m_Image_YMax - m_Image_YMin) * y;
-                y = y - 0.5 * (m_Image_YMax + m_Image_YMin);
-                double threshold =
-                    exp(-0.5*(x*x+y*y)/pow(m_Gaussian_Sigma,2));
-                threshold = m_Gaussian_Low +
-                    (m_Gaussian_High-m_Gaussian_Low) * threshold;
-                is_white = (drand48() < threshold);
-            }
+    // Directory
+    const QString directory = mrDomPyramid.attribute("directory");
+    if (directory.isEmpty())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("<lic><image><pyramid> specifies an empty directory."));
+        return false;
+    }
 
-            // Actually pick the color
-            if (is_white)
-            {
-                m_Noise_R[idx] = 255;
-                m_Noise_G[idx] = 255;
-                m_Noise_B[idx] = 255;
-            } else
+    // Layout
+    const QString layout = mrDomPyramid.attribute("layout", "xyz");
+    if (layout == "xyz")
+    {
+        m_Pyramid_Layout = PyramidLayout_XYZ;
+    } else if (layout == "deepzoom")
+    {
+        m_Pyramid_Layout = PyramidLayout_DeepZoom;
+    } else
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid layout \"%1\" in <lic><image><pyramid>. Must "
+                "be \"xyz\" or \"deepzoom\".").arg(layout));
+        return false;
+    }
+
+    // Tile size
+    m_Pyramid_TileSize = mrDomPyramid.attribute("tile_size", "256").toInt();
+    if (m_Pyramid_TileSize < 16)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid tile size %1 in <lic><image><pyramid>; needs "
+                "to be at least 16.").arg(m_Pyramid_TileSize));
+        return false;
+    }
+
+    // Done
+    m_Pyramid_Directory = directory;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// One image written by Execute()
+bool LIC::ParseOutput(QDomElement & mrDomOutput)
+{
+    Output output;
+
+    // File name
+    output.filename = mrDomOutput.attribute("filename");
+    if (output.filename.isEmpty())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("<lic><image><output> specifies an empty file name."));
+        return false;
+    }
+    for (const Output & other : m_Outputs)
+    {
+        if (other.filename == output.filename)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("File name \"%1\" is used by more than one "
+                    "<lic><image><output>.").arg(output.filename));
+            return false;
+        }
+    }
+
+    // Crop (optional): "x,y,width,height" in pixels of the traced image
+    const QString crop_text = mrDomOutput.attribute("crop");
+    if (!crop_text.isEmpty())
+    {
+        const QStringList parts = crop_text.split(",");
+        QList < int > values;
+        for (const QString & part : parts)
+        {
+            bool is_number = false;
+            values << part.trimmed().toInt(&is_number);
+            if (!is_number)
             {
-                m_Noise_R[idx] = 0;
-                m_Noise_G[idx] = 0;
-                m_Noise_B[idx] = 0;
+                values.clear();
+                break;
             }
         }
+        if (values.size() == 4)
+        {
+            output.crop = QRect(values[0], values[1], values[2], values[3]);
+        }
+        if (output.crop.isEmpty() ||
+            !QRect(0, 0, m_Image_Width, m_Image_Height).contains(output.crop))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Invalid crop \"%1\" in <lic><image><output>. Must "
+                    "be \"x,y,width,height\" inside of the %2x%3 image.")
+                    .arg(crop_text,
+                         QString::number(m_Image_Width),
+                         QString::number(m_Image_Height)));
+            return false;
+        }
+    }
+
+    // Size (optional); outputs are filtered down from the traced image, so
+    // they can't be larger than the part they show
+    const QSize source_size = (output.crop.isEmpty() ?
+        QSize(m_Image_Width, m_Image_Height) : output.crop.size());
+    output.width = mrDomOutput.attribute("width", "0").toInt();
+    output.height = mrDomOutput.attribute("height", "0").toInt();
+    if (output.width < 0 ||
+        output.height < 0 ||
+        output.width > source_size.width() ||
+        output.height > source_size.height())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid size %1x%2 of <lic><image><output> \"%3\". "
+                "Must be at most %4x%5; increase <resolution> for larger "
+                "images.")
+                .arg(QString::number(output.width),
+                     QString::number(output.height),
+                     output.filename,
+                     QString::number(source_size.width()),
+                     QString::number(source_size.height())));
+        return false;
+    }
+
+    // Channel
+    const QString channel = mrDomOutput.attribute("channel", "color");
+    if (channel == "color")
+    {
+        output.channel = Channel_Color;
+    } else if (channel == "intensity")
+    {
+        output.channel = Channel_Intensity;
+    } else if (channel == "strength")
+    {
+        output.channel = Channel_Strength;
+    } else
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid channel \"%1\" in <lic><image><output>. Must "
+                "be \"color\", \"intensity\", or \"strength\".")
+                .arg(channel));
+        return false;
     }
 
     // Done
+    m_Outputs << output;
+    return true;
 }
 
-#include <QTime>
+
 
 ///////////////////////////////////////////////////////////////////////////////
-// Generate LIC
-void LIC::GenerateLIC()
+// Coloring by strength of the vector field
+bool LIC::ParseColoring(QDomElement & mrDomColoring)
 {
-    // Elapsed/to go time
-    QElapsedTimer ti;
-    ti.start();
+    // Type; only coloring by strength is available for now
+    const QString type = mrDomColoring.attribute("type", "strength");
+    if (type != "strength")
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid coloring type \"%1\" in <lic><image><coloring>. "
+                "Must be \"strength\".").arg(type));
+        return false;
+    }
 
-    // Initialize LIC colors
-    m_LIC_R.reserve(m_Image_Width * m_Image_Height);
-    m_LIC_G.reserve(m_Image_Width * m_Image_Height);
-    m_LIC_B.reserve(m_Image_Width * m_Image_Height);
-    m_LIC_Strength.reserve(m_Image_Width * m_Image_Height);
-
-    // For conversion from grid to actual x/y values
-    const double dx = (m_Image_XMax - m_Image_XMin) / (m_Image_Width - 1.);
-    const double dy = (m_Image_YMax - m_Image_YMin) / (m_Image_Height - 1.);
-
-    for (int ix = 0; ix < m_Image_Width; ix++)
-    {
-        const double elapsed = ti.elapsed() * 0.001;
-        const QString elapsed_text = QString("%1:%2:%3")
-                .arg(int(elapsed)/3600, 2, 10, QChar('0'))
-                .arg(int(elapsed)%3600/60, 2, 10, QChar('0'))
-                .arg(int(elapsed)%60, 2, 10, QChar('0'));
-        const double remaining = elapsed * (m_Image_Width - 1 - ix)/ ix;
-        QString remaining_text = "---";
-        if (ix > 1)
-        {
-            remaining_text = QString("%1:%2:%3")
-                .arg(int(remaining)/3600, 2, 10, QChar('0'))
-                .arg(int(remaining)%3600/60, 2, 10, QChar('0'))
-                .arg(int(remaining)%60, 2, 10, QChar('0'));
-        }
-        qDebug().noquote() << tr("Step %1/%2 - elapsed %3, remaining %4")
-            .arg(QString::number(ix),
-                 QString::number(m_Image_Width-1),
-                 elapsed_text,
-                 remaining_text);
-        for (int iy = 0; iy < m_Image_Height; iy++)
-        {
-            double color_r = 0.;
-            double color_g = 0.;
-            double color_b = 0.;
-
-            double lic_length = 0;
-            for (int direction : {-1, 1})
-            {
-                // Grid coordinate system
-                // We have to remember that the origin of our coordinate system
-                // is at the top left corner, not at the bottom left corner
-                int grid_x = ix;
-                double grid_dx = 0;
-                int grid_y = (m_Image_Height - 1) - iy;
-                double grid_dy = 0;
-
-                for (int step = 0; step < m_Steps; step++)
-                {
-                    // Evaluate vector field
-                    double x = m_Image_XMin + (grid_x + grid_dx) * dx;
-                    double y = m_Image_YMin + (grid_y + grid_dy) * dy;
-                    QPair < double, double > v = EvaluateVectorfield(x,y);
-                    double vx = direction * v.first;
-                    double vy = direction * v.second;
-
-                    // Normalize
-                    double r = sqrt(vx*vx + vy*vy);
-                    if (r <= 1e-14)
-                    {
-                        // Avoid singularities; we're not escaping a vanishing
-                        // vector field anyway.
-                        break;
-                    }
-                    vx /= r;
-                    vy /= r;
+    // Scaling of the strength
+    const QString scaling = mrDomColoring.attribute("scaling", "linear");
+    if (scaling != "linear" &&
+        scaling != "log")
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid scaling \"%1\" in <lic><image><coloring>. Must "
+                "be \"linear\" or \"log\".").arg(scaling));
+        return false;
+    }
+    m_Coloring_LogScale = (scaling == "log");
 
-                    // Calculate step size in this grid box
-                    double sx = 1e10;
-                    if (vx > 0)
-                    {
-                        sx = (1. - grid_dx)/vx;
-                    } else if (vx < 0)
-                    {
-                        if (abs(grid_dx) <= 1e-13)
-                        {
-                            sx = -1/vx;
-                        } else
-                        {
-                            sx = -grid_dx/vx;
-                        }
-                    }
-                    double sy = 1e10;
-                    if (vy > 0)
-                    {
-                        sy = (1. - grid_dy)/vy;
-                    } else if (vy < 0)
-                    {
-                        if (abs(grid_dy) <= 1e-13)
-                        {
-                            sy = -1/vy;
-                        } else
-                        {
-                            sy = -grid_dy/vy;
-                        }
-                    }
-                    double s = qMin(sx, sy);
+    // Gamma
+    const QString gamma_text = mrDomColoring.attribute("gamma", "1.0");
+    const double gamma = gamma_text.toDouble();
+    if (gamma <= 0)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid gamma \"%1\" in <lic><image><coloring>. Must "
+                "be > 0.").arg(gamma_text));
+        return false;
+    }
 
-                    // Integrate color
-                    int color_grid_x = grid_x % m_Image_Width;
-                    if (color_grid_x < 0)
-                    {
-                        color_grid_x += m_Image_Width;
-                    }
-                    int color_grid_y = grid_y % m_Image_Height;
-                    if (color_grid_y < 0)
-                    {
-                        color_grid_y += m_Image_Height;
-                    }
-                    const int idx =
-                        (color_grid_x * m_Image_Height + color_grid_y)
-                            % (m_Image_Width * m_Image_Height);
-                    //if (r > 0.1)
-                    double sink_capture = 1/(1/r+1);
-                    color_r += sink_capture * s * m_Noise_R[idx];
-                    color_g += sink_capture * s * m_Noise_G[idx];
-                    color_b += sink_capture * s * m_Noise_B[idx];
-
-                    // Update coordinates
-                    grid_dx += s * vx;
-                    if (grid_dx < 0)
-                    {
-                        grid_x -= 1;
-                        grid_dx += 1;
-                    }
-                    if (grid_dx >= 1)
-                    {
-                        grid_x += 1;
-                        grid_dx -= 1;
-                    }
-                    grid_dy += s * vy;
-                    if (grid_dy < 0)
-                    {
-                        grid_y -= 1;
-                        grid_dy += 1;
-                    }
-                    if (grid_dy >= 1)
-                    {
-                        grid_y += 1;
-                        grid_dy -= 1;
-                    }
+    // Colormap
+    const QString colormap = mrDomColoring.attribute("colormap", "viridis");
+    m_Colormap = Colormap::CreateColormap(colormap, gamma);
+    if (!m_Colormap)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Unknown colormap \"%1\" in <lic><image><coloring>. "
+                "Available colormaps are: %2.")
+                .arg(colormap,
+                     Colormap::GetColormapNames().join(", ")));
+        return false;
+    }
 
-                    // Add up color
-                    lic_length += s;
-                }
-            }
+    // Done
+    return true;
+}
 
-            // Set point
-            color_r /= lic_length;
-            color_g /= lic_length;
-            color_b /= lic_length;
 
-            // Save information
-            const int idx = ix * m_Image_Height + iy;
-            m_LIC_R[idx] = color_r;
-            m_LIC_G[idx] = color_g;
-            m_LIC_B[idx] = color_b;
 
-            // Strength
-            double x = m_Image_XMin + ix * dx;
-            double y = m_Image_YMin + iy * dy;
-            QPair < double, double > v = EvaluateVectorfield(x,y);
-            double vx = v.first;
-            double vy = v.second;
-            const double strength = sqrt(vx*vx + vy*vy);
-            m_LIC_Strength[ix * m_Image_Height + iy] = strength;
-        }
+///////////////////////////////////////////////////////////////////////////////
+// Create the LIC image and save it to the output file
+bool LIC::Execute()
+{
+    // Check if parameters are valid
+    if (!m_IsValid ||
+        (m_Outputs.isEmpty() && !HasPyramid()))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Set of parameters isn't valid; can't execute."));
+        return false;
+    }
+
+    // Several images
+    if (HasSweep())
+    {
+        return ExecuteSweep();
+    }
+    if (HasPyramid())
+    {
+        return ExecutePyramid();
+    }
+
+    // Generate noise and LIC, for the pixels some output needs
+    const QRect trace_rect = GetTraceRect();
+    if (!RunTracingStages(trace_rect))
+    {
+        return false;
     }
 
-    // Show strength of the vector field
-    // qDebug() << QString("Strength: min=%1, max=%2").arg(min_strength)
-    //      .arg(max_strength);
+    // Generate Images
+    m_PerformanceReport.StartStage("GenerateImage");
+    const bool success = WriteOutputs(trace_rect);
+    m_PerformanceReport.EndStage("GenerateImage");
+
+    // Nothing left to resume
+    if (success)
+    {
+        m_Checkpoint.Close(true);
+    }
+
+    UpdateDerivedCounters();
+    return success;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Evaluate vector field
-QPair < double, double > LIC::EvaluateVectorfield(double mX, double mY)
+// Create the LIC image in a caller-owned buffer
+bool LIC::Render(void * mpBuffer, qsizetype mStride, PixelFormat mFormat)
 {
-    QHash < QString, double > values = m_Parameters;
-    for (int iteration = 0;
-         iteration < m_Vectorfield_Iterate;
-         iteration++)
+    // Check if parameters are valid
+    if (!m_IsValid)
     {
-        values["x"] = mX;
-        values["y"] = mY;
-        mX = m_Vectorfield["x"] -> Evaluate(values);
-        mY = m_Vectorfield["y"] -> Evaluate(values);
+        MessageLogger::Error(METHOD_NAME,
+            QString("Set of parameters isn't valid; can't render."));
+        return false;
     }
-    return QPair < double, double >(mX, mY);
+    const qsizetype min_stride = (mFormat == PixelFormat_RGBX8 ?
+        4 : 3 * qsizetype(sizeof(float))) * m_Image_Width;
+    if (!mpBuffer ||
+        mStride < min_stride)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid buffer or stride %1; a line needs at least %2 "
+                "bytes.").arg(QString::number(mStride),
+                    QString::number(min_stride)));
+        return false;
+    }
+
+    // Generate noise and LIC
+    if (!RunTracingStages())
+    {
+        return false;
+    }
+
+    // Pixels go straight into the buffer
+    m_PerformanceReport.StartStage("GenerateImage");
+    GenerateImage(mpBuffer, mStride, mFormat);
+    m_PerformanceReport.EndStage("GenerateImage");
+    m_Checkpoint.Close(true);
+
+    UpdateDerivedCounters();
+    return true;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Generate image
-void LIC::GenerateImage()
+// Noise and LIC stages shared by Execute() and Render()
+bool LIC::RunTracingStages(const QRect & mcRect)
 {
-    // === Renormalize
+    m_CancelRequested = false;
 
-    // Generate output picture
-    double min_intensity = 1e10;
-    double max_intensity = -1e10;
-    for (int idx = 0; idx < m_Image_Width * m_Image_Height; idx++)
+    // An unchanged traced image makes both stages unnecessary
+    const qsizetype num_pixels = qsizetype(m_Image_Width) * m_Image_Height;
+    QString tracing_key;
+    if (m_Cache.IsEnabled())
     {
-        min_intensity = qMin(min_intensity, m_LIC_R[idx]);
-        min_intensity = qMin(min_intensity, m_LIC_G[idx]);
-        min_intensity = qMin(min_intensity, m_LIC_B[idx]);
-        max_intensity = qMax(max_intensity, m_LIC_R[idx]);
-        max_intensity = qMax(max_intensity, m_LIC_G[idx]);
-        max_intensity = qMax(max_intensity, m_LIC_B[idx]);
+        tracing_key = GetTracingKey(mcRect);
+        m_PerformanceReport.StartStage("LoadCache");
+        const bool cached = m_Cache.Load("lic", tracing_key,
+            { &m_LIC_R, &m_LIC_G, &m_LIC_B, &m_LIC_Strength }, num_pixels);
+        m_PerformanceReport.EndStage("LoadCache");
+        m_PerformanceReport.SetCounter("tracing_cached", cached);
+        if (cached)
+        {
+            return true;
+        }
     }
-    for (int idx = 0; idx < m_Image_Width * m_Image_Height; idx++)
+
+    // Generate underlying noise patters
+    m_PerformanceReport.StartStage("GenerateNoise");
+    const QString noise_key = GetNoiseKey();
+    const QRect noise_window = GetNoiseWindow();
+    const bool noise_cached = m_Cache.Load("noise", noise_key,
+        { &m_Noise_R, &m_Noise_G, &m_Noise_B },
+        qsizetype(noise_window.width()) * noise_window.height());
+    if (!noise_cached)
     {
-        m_LIC_R[idx] = (m_LIC_R[idx] - min_intensity) /
-            (max_intensity - min_intensity) * 255;
-        m_LIC_G[idx] = (m_LIC_G[idx] - min_intensity) /
-            (max_intensity - min_intensity) * 255;
-        m_LIC_B[idx] = (m_LIC_B[idx] - min_intensity) /
-            (max_intensity - min_intensity) * 255;
+        GenerateNoise();
+        m_Cache.Store("noise", noise_key,
+            { &m_Noise_R, &m_Noise_G, &m_Noise_B });
     }
-
-    // === Apply color
-    double min_strength = 1e10;
-    double max_strength = -1e10;
-    for (int idx = 0; idx < m_Image_Width * m_Image_Height; idx++)
+    m_PerformanceReport.EndStage("GenerateNoise");
+    if (m_Cache.IsEnabled())
     {
-        min_strength = qMin(min_strength, m_LIC_Strength[idx]);
-        max_strength = qMax(max_strength, m_LIC_Strength[idx]);
+        m_PerformanceReport.SetCounter("noise_cached", noise_cached);
     }
-    for (int idx = 0; idx < m_Image_Width * m_Image_Height; idx++)
+
+    // Generate LIC
+    m_PerformanceReport.StartStage("GenerateLIC");
+    const bool success = GenerateLIC(mcRect);
+    m_PerformanceReport.EndStage("GenerateLIC");
+    if (!success)
     {
-        const double weight = (m_LIC_Strength[idx] - min_strength) /
-            (max_strength - min_strength);
-        // m_LIC_G[idx] *= pow(weight,.2);
-        // m_LIC_B[idx] *= pow(weight,.2);
+        MessageLogger::Error(METHOD_NAME, "Rendering has been cancelled.");
+        return false;
     }
+    m_Cache.Store("lic", tracing_key,
+        { &m_LIC_R, &m_LIC_G, &m_LIC_B, &m_LIC_Strength });
+    return true;
+}
+
 
-    // Generate and save image
-    QImage lic_image = QPixmap(m_Image_Width, m_Image_Height).toImage();
-    for (int ix = 0; ix < m_Image_Width; ix++)
+
+///////////////////////////////////////////////////////////////////////////////
+// Smallest part of the image all outputs are cut from
+QRect LIC::GetTraceRect() const
+{
+    // Resolution may have changed since the crops were parsed
+    const QRect image_rect(0, 0, m_Image_Width, m_Image_Height);
+    QRect trace_rect;
+    for (const Output & output : m_Outputs)
     {
-        for (int iy = 0; iy < m_Image_Height; iy++)
+        if (output.crop.isEmpty())
         {
-            const int idx = ix * m_Image_Height + iy;
-            lic_image.setPixelColor(ix, iy,
-                QColor(m_LIC_R[idx], m_LIC_G[idx], m_LIC_B[idx]));
+            return image_rect;
         }
+        trace_rect = trace_rect.united(output.crop.intersected(image_rect));
     }
-    lic_image.save(m_OutputFilename, "png");
+    return (trace_rect.isEmpty() ? image_rect : trace_rect);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write all outputs
+bool LIC::WriteOutputs(const QRect & mcTracedRect,
+    const Normalization * mpNormalization)
+{
+    // Outputs showing the same channel share one normalized image of the
+    // traced part; crops and smaller sizes are derived from it
+    QHash < int, QImage > channel_images;
+    bool success = true;
+    for (const Output & output : m_Outputs)
+    {
+        if (!channel_images.contains(output.channel))
+        {
+            // Pixels are written into the image without a copy
+            QImage image(mcTracedRect.width(), mcTracedRect.height(),
+                QImage::Format_RGBX8888);
+            GenerateImage(image.bits(), image.bytesPerLine(),
+                PixelFormat_RGBX8, mcTracedRect, output.channel,
+                mpNormalization);
+            channel_images[output.channel] = image;
+        }
+        QImage image = channel_images[output.channel];
+
+        // Crop
+        const QRect crop = (output.crop.isEmpty() ?
+            mcTracedRect : output.crop.intersected(mcTracedRect));
+        if (crop != mcTracedRect)
+        {
+            image = image.copy(
+                crop.translated(-mcTracedRect.x(), -mcTracedRect.y()));
+        }
+
+        // Size; a missing dimension keeps the aspect ratio. Smooth scaling
+        // averages all pixels that end up in one, so thin streaks don't
+        // alias.
+        int width = qMin(output.width, crop.width());
+        int height = qMin(output.height, crop.height());
+        if (width == 0 &&
+            height == 0)
+        {
+            width = crop.width();
+            height = crop.height();
+        } else if (width == 0)
+        {
+            width = qMax(1, qRound(double(height) * crop.width() /
+                crop.height()));
+        } else if (height == 0)
+        {
+            height = qMax(1, qRound(double(width) * crop.height() /
+                crop.width()));
+        }
+        if (width != image.width() ||
+            height != image.height())
+        {
+            image = image.scaled(width, height, Qt::IgnoreAspectRatio,
+                Qt::SmoothTransformation);
+        }
+
+        if (!image.save(output.filename, "png"))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Image \"%1\" could not be saved.")
+                    .arg(output.filename));
+            success = false;
+        }
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render every value of the parameter sweep
+bool LIC::ExecuteSweep()
+{
+    m_CancelRequested = false;
+    m_PerformanceReport.SetInfo("sweep_parameter", m_Sweep_Parameter);
+    m_PerformanceReport.SetInfo("sweep_count", m_Sweep_Count);
+
+    // Noise is the same for all frames
+    m_PerformanceReport.StartStage("GenerateNoise");
+    GenerateNoise();
+    m_PerformanceReport.EndStage("GenerateNoise");
+
+    // Contact sheet with one cell per frame
+    QImage sheet;
+    if (m_Sweep_ContactSheet)
+    {
+        sheet = QImage(GetContactSheetSize(), QImage::Format_RGBX8888);
+        sheet.fill(QColor(0, 0, 0));
+    }
+
+    // Frames are traced together (all threads work on all frames of a
+    // group), in groups that fit into memory
+    const int group_size = GetSweepGroupSize();
+    QList < QList < double > > planes(4 * group_size);
+    for (QList < double > & plane : planes)
+    {
+        plane.resize(qsizetype(m_Image_Width) * m_Image_Height);
+    }
+
+    bool success = true;
+    for (int group_start = 0;
+         group_start < m_Sweep_Count;
+         group_start += group_size)
+    {
+        const int num_frames = qMin(group_size, m_Sweep_Count - group_start);
+        QList < TraceTarget > targets;
+        for (int frame_idx = 0; frame_idx < num_frames; frame_idx++)
+        {
+            TraceTarget target;
+            target.lic_r = planes[4 * frame_idx].data();
+            target.lic_g = planes[4 * frame_idx + 1].data();
+            target.lic_b = planes[4 * frame_idx + 2].data();
+            target.lic_strength = planes[4 * frame_idx + 3].data();
+            target.sweep_value = GetSweepValue(group_start + frame_idx);
+            targets << target;
+        }
+        m_PerformanceReport.StartStage("GenerateLIC");
+        const bool traced = TraceTargets(targets);
+        m_PerformanceReport.EndStage("GenerateLIC");
+        if (!traced)
+        {
+            MessageLogger::Error(METHOD_NAME, "Rendering has been cancelled.");
+            return false;
+        }
+
+        // Images; the planes of a frame are swapped in (no copy), so
+        // GenerateImage() works as for a single image
+        m_PerformanceReport.StartStage("GenerateImage");
+        for (int frame_idx = 0; frame_idx < num_frames; frame_idx++)
+        {
+            const int frame = group_start + frame_idx;
+            m_LIC_R.swap(planes[4 * frame_idx]);
+            m_LIC_G.swap(planes[4 * frame_idx + 1]);
+            m_LIC_B.swap(planes[4 * frame_idx + 2]);
+            m_LIC_Strength.swap(planes[4 * frame_idx + 3]);
+            if (m_Sweep_ContactSheet)
+            {
+                const int column = frame % m_Sweep_Columns;
+                const int row = frame / m_Sweep_Columns;
+                uchar * cell = sheet.bits() +
+                    qsizetype(row) * m_Image_Height * sheet.bytesPerLine() +
+                    qsizetype(column) * m_Image_Width * 4;
+                GenerateImage(cell, sheet.bytesPerLine(), PixelFormat_RGBX8);
+            } else
+            {
+                success = SaveImage(GetFrameFilename(frame)) && success;
+            }
+            m_LIC_R.swap(planes[4 * frame_idx]);
+            m_LIC_G.swap(planes[4 * frame_idx + 1]);
+            m_LIC_B.swap(planes[4 * frame_idx + 2]);
+            m_LIC_Strength.swap(planes[4 * frame_idx + 3]);
+        }
+        m_PerformanceReport.EndStage("GenerateImage");
+    }
+
+    // Save contact sheet
+    if (m_Sweep_ContactSheet)
+    {
+        m_PerformanceReport.StartStage("GenerateImage");
+        if (!sheet.save(m_Outputs.first().filename, "png"))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Image \"%1\" could not be saved.")
+                    .arg(m_Outputs.first().filename));
+            success = false;
+        }
+        m_PerformanceReport.EndStage("GenerateImage");
+    }
+
+    UpdateDerivedCounters(m_Sweep_Count);
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render all tiles of the pyramid
+bool LIC::ExecutePyramid()
+{
+    PyramidRenderer pyramid(this);
+    return pyramid.Execute();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of frames of a sweep traced together
+int LIC::GetSweepGroupSize() const
+{
+    const qint64 bytes_per_frame =
+        4 * qint64(sizeof(double)) * m_Image_Width * m_Image_Height;
+    return int(qBound(qint64(1), SWEEP_MEMORY_BUDGET / bytes_per_frame,
+        qint64(m_Sweep_Count)));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Value of the swept parameter in a frame
+double LIC::GetSweepValue(int mFrame) const
+{
+    if (m_Sweep_Count < 2)
+    {
+        return m_Sweep_From;
+    }
+    return m_Sweep_From +
+        (m_Sweep_To - m_Sweep_From) * mFrame / (m_Sweep_Count - 1.);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output file of a frame
+QString LIC::GetFrameFilename(int mFrame) const
+{
+    const QFileInfo output_info(m_Outputs.first().filename);
+    return output_info.dir().filePath(QString("%1-%2.%3")
+        .arg(output_info.completeBaseName(),
+             QString("%1").arg(mFrame, 4, 10, QChar('0')),
+             output_info.suffix()));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Derived figures of the performance report
+void LIC::UpdateDerivedCounters(int mNumImages)
+{
+    const double num_pixels =
+        double(m_Image_Width) * m_Image_Height * mNumImages;
+    const double num_steps =
+        m_PerformanceReport.GetCounter("streamline_steps");
+    const double lic_seconds = m_PerformanceReport.GetWallTime("GenerateLIC");
+    m_PerformanceReport.SetCounter("pixels", num_pixels);
+    if (lic_seconds > 0.)
+    {
+        // Not traced at all if the image has been reused in a batch
+        m_PerformanceReport.SetCounter("pixels_per_second",
+            num_pixels / lic_seconds);
+    }
+    m_PerformanceReport.SetCounter("field_evaluations_per_pixel",
+        m_PerformanceReport.GetCounter("field_evaluations") / num_pixels);
+    m_PerformanceReport.SetCounter("streamline_steps_per_pixel",
+        num_steps / num_pixels);
+    m_PerformanceReport.SetCounter("average_step_length",
+        num_steps > 0 ?
+            m_PerformanceReport.GetCounter("streamline_length") / num_steps :
+            0.);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Called with the finished fraction while tracing
+void LIC::SetProgressCallback(std::function < void(double) > mCallback)
+{
+    m_ProgressCallback = mCallback;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Asked regularly while tracing whether to cancel
+void LIC::SetCancelCallback(std::function < bool() > mCallback)
+{
+    m_CancelCallback = mCallback;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Cancel rendering
+void LIC::Cancel()
+{
+    m_CancelRequested = true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Rendering has been cancelled
+bool LIC::IsCancelled() const
+{
+    return m_CancelRequested;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Generate underlying noise patterm
+void LIC::GenerateNoise()
+{
+    // Background noise, for the part of the frame the tracer reads
+    const QSize frame = GetFrameSize();
+    const QRect window = GetNoiseWindow();
+    const qsizetype num_values = qsizetype(window.width()) * window.height();
+    m_Noise_R.resize(num_values);
+    m_Noise_G.resize(num_values);
+    m_Noise_B.resize(num_values);
+
+    // Apply random seed
+    SequentialRandom sequential_random(m_BackgroundSeed);
+
+    // Noise by position is computed a column at a time, in runs of rows
+    // that don't wrap around the frame
+    const bool column_noise = (m_Noise_ByPosition &&
+        (m_BackgroundType == "white noise" ||
+            m_BackgroundType == "gaussian"));
+    const SimdKernels & kernels = CpuDispatch::GetKernels();
+    std::vector < double > position_noise(window.height());
+
+    // This could be generated in a more efficient way, but we like to keep
+    // it this way so we can implement other ways more easily.
+    for (int window_x = 0; window_x < window.width(); window_x++)
+    {
+        const int ix = (window.x() + window_x) % frame.width();
+        for (int first = 0; column_noise && first < window.height(); )
+        {
+            const int first_iy = (window.y() + first) % frame.height();
+            int num_rows = 1;
+            while (first + num_rows < window.height() &&
+                (window.y() + first + num_rows) % frame.height() ==
+                    first_iy + num_rows)
+            {
+                num_rows++;
+            }
+            kernels.position_noise(m_BackgroundSeed, ix, first_iy, num_rows,
+                position_noise.data() + first);
+            first += num_rows;
+        }
+        for (int window_y = 0; window_y < window.height(); window_y++)
+        {
+            // Position in the frame
+            const qsizetype idx =
+                qsizetype(window_x) * window.height() + window_y;
+            const int iy = (window.y() + window_y) % frame.height();
+            auto random =
+                [this, &position_noise, window_y, &sequential_random]()
+                {
+                    return (m_Noise_ByPosition ?
+                        position_noise[window_y] : sequential_random.Next());
+                };
+            bool is_white = false;
+
+            // Check type of noise
+            if (m_BackgroundType == "white noise")
+            {
+                is_white = (random() > m_WhiteNoise_Cutoff);
+            }
+            if (m_BackgroundType == "checkerboard")
+            {
+                is_white = (((ix + iy) / m_Checkerboard_Width) % 2 == 0);
+            }
+            if (m_BackgroundType == "gaussian")
+            {
+                double x = ix * 1. / (frame.width() - 1.);
+                x = m_Image_XMin + (m_Image_XMax - m_Image_XMin) * x;
+                x = x - 0.5 * (m_Image_XMax + m_Image_XMin);
+                double y = iy * 1. / (frame.height() - 1.);
+                y = m_Image_YMin + (m_Image_YMax - m_Image_YMin) * y;
+                y = y - 0.5 * (m_Image_YMax + m_Image_YMin);
+                double threshold =
+                    exp(-0.5*(x*x+y*y)/pow(m_Gaussian_Sigma,2));
+                threshold = m_Gaussian_Low +
+                    (m_Gaussian_High-m_Gaussian_Low) * threshold;
+                is_white = (random() < threshold);
+            }
+
+            // Actually pick the color
+            if (is_white)
+            {
+                m_Noise_R[idx] = 255;
+                m_Noise_G[idx] = 255;
+                m_Noise_B[idx] = 255;
+            } else
+            {
+                m_Noise_R[idx] = 0;
+                m_Noise_G[idx] = 0;
+                m_Noise_B[idx] = 0;
+            }
+        }
+    }
+
+    // Noise is generated in sequence by this thread, so all of it is on
+    // this thread's node until it is moved
+    DistributeNoise();
+
+    // Done
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Move the pages of the noise to the nodes reading them
+void LIC::DistributeNoise()
+{
+    // The noise window is a bit wider than the image; its strips are close
+    // enough to those of the image for almost all reads to be local
+    if (m_NUMAPlacement)
+    {
+        const QRect window = GetNoiseWindow();
+        NumaTopology::GetHost().DistributeColumns({ m_Noise_R.data(),
+            m_Noise_G.data(), m_Noise_B.data() }, window.height(),
+            window.width());
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Move the pages of the traced planes to the nodes writing them
+void LIC::DistributePlanes()
+{
+    // Only once per allocation of the planes
+    if (m_NUMAPlacement &&
+        m_LIC_R.constData() != m_DistributedPlane)
+    {
+        NumaTopology::GetHost().DistributeColumns({ m_LIC_R.data(),
+            m_LIC_G.data(), m_LIC_B.data(), m_LIC_Strength.data() },
+            m_Image_Height, m_Image_Width);
+        m_DistributedPlane = m_LIC_R.constData();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Everything the noise depends on
+QString LIC::GetNoiseKey() const
+{
+    QStringList key;
+    key << m_BackgroundType
+        << QString::number(m_BackgroundSeed)
+        << QString::number(m_Image_Width)
+        << QString::number(m_Image_Height)
+        << (m_Noise_ByPosition ? "position" : "sequence");
+    if (!m_ROI.isEmpty())
+    {
+        // Same region of the same frame; the window depends on steps, too
+        const QRect window = GetNoiseWindow();
+        key << QString("%1x%2").arg(QString::number(m_Frame_Width),
+                QString::number(m_Frame_Height))
+            << QString("%1,%2,%3,%4").arg(QString::number(window.x()),
+                QString::number(window.y()), QString::number(window.width()),
+                QString::number(window.height()));
+    }
+    if (m_BackgroundType == "white noise")
+    {
+        key << QString::number(m_WhiteNoise_Cutoff, 'g', 17);
+    }
+    if (m_BackgroundType == "checkerboard")
+    {
+        key << QString::number(m_Checkerboard_Width);
+    }
+    if (m_BackgroundType == "gaussian")
+    {
+        key << QString::number(m_Gaussian_Sigma, 'g', 17)
+            << QString::number(m_Gaussian_Low, 'g', 17)
+            << QString::number(m_Gaussian_High, 'g', 17)
+            << QString::number(m_Image_XMin, 'g', 17)
+            << QString::number(m_Image_XMax, 'g', 17)
+            << QString::number(m_Image_YMin, 'g', 17)
+            << QString::number(m_Image_YMax, 'g', 17);
+    }
+    return key.join("|");
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Part of the frame the noise planes cover
+QRect LIC::GetNoiseWindow() const
+{
+    const QSize frame = GetFrameSize();
+    if (m_ROI.isEmpty())
+    {
+        return QRect(0, 0, frame.width(), frame.height());
+    }
+
+    // Image and halo, with y upwards; all of the frame if that's larger
+    const int halo = m_Steps;
+    int x = m_ROI.x() - halo;
+    int y = (frame.height() - 1 - m_ROI.bottom()) - halo;
+    int width = m_ROI.width() + 2 * halo;
+    int height = m_ROI.height() + 2 * halo;
+    if (width >= frame.width())
+    {
+        x = 0;
+        width = frame.width();
+    }
+    if (height >= frame.height())
+    {
+        y = 0;
+        height = frame.height();
+    }
+    x = (x % frame.width() + frame.width()) % frame.width();
+    y = (y % frame.height() + frame.height()) % frame.height();
+    return QRect(x, y, width, height);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Everything the traced image depends on
+QString LIC::GetTracingKey(const QRect & mcRect) const
+{
+    QStringList key;
+    key << GetNoiseKey()
+        << m_Vectorfield_X -> ToString()
+        << m_Vectorfield_Y -> ToString()
+        << QString::number(m_Vectorfield_Iterate)
+        << QString::number(m_Steps)
+        << QString::number(m_Image_XMin, 'g', 17)
+        << QString::number(m_Image_XMax, 'g', 17)
+        << QString::number(m_Image_YMin, 'g', 17)
+        << QString::number(m_Image_YMax, 'g', 17);
+
+    // Parameters in a fixed order
+    QStringList parameter_names = m_Parameters.keys();
+    parameter_names.sort();
+    for (const QString & name : parameter_names)
+    {
+        key << QString("%1=%2").arg(name,
+            QString::number(m_Parameters[name], 'g', 17));
+    }
+
+    // Region of interest in the frame
+    if (!m_ROI.isEmpty())
+    {
+        key << QString("roi %1,%2").arg(QString::number(m_ROI.x()),
+            QString::number(m_ROI.y()));
+    }
+
+    // Part of the image, unless it's all of it
+    if (!mcRect.isEmpty() &&
+        mcRect != QRect(0, 0, m_Image_Width, m_Image_Height))
+    {
+        key << QString("%1,%2,%3,%4").arg(QString::number(mcRect.x()),
+            QString::number(mcRect.y()), QString::number(mcRect.width()),
+            QString::number(mcRect.height()));
+    }
+    return key.join("|");
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Generate LIC
+bool LIC::GenerateLIC(const QRect & mcRect)
+{
+    // Initialize LIC colors
+    AllocateTracedPlanes();
+    DistributePlanes();
+
+    // Tiles finished before a cancellation are kept; they are only the
+    // same tiles with the same size
+    const int num_tiles = GetNumTiles();
+    const QString tracing_key = GetTracingKey(mcRect) +
+        QString("|tiles %1").arg(QString::number(m_TileSize));
+    if (tracing_key != m_TilesDoneKey ||
+        m_LIC_R.constData() != m_TilesDonePlane ||
+        m_TilesDone.size() != num_tiles)
+    {
+        m_TilesDone.fill(false, num_tiles);
+    }
+
+    // Finished tiles also go to a file, so a run that is killed can resume
+    std::function < void(int) > tile_finished;
+    if (m_Checkpoint.IsEnabled() &&
+        m_Checkpoint.Open(tracing_key, m_Image_Width, m_Image_Height,
+            num_tiles, m_TileSize,
+            { &m_LIC_R, &m_LIC_G, &m_LIC_B, &m_LIC_Strength }, m_TilesDone))
+    {
+        const int num_resumed = m_Checkpoint.GetNumResumedTiles();
+        if (num_resumed == 0)
+        {
+            for (int tile = 0; tile < num_tiles; tile++)
+            {
+                if (m_TilesDone[tile])
+                {
+                    m_Checkpoint.SaveTile(tile,
+                        GetTilePixels(tile, mcRect));
+                }
+            }
+        }
+        m_PerformanceReport.SetCounter("tiles_resumed", num_resumed);
+        tile_finished = [this, mcRect](int mTile)
+        {
+            m_Checkpoint.SaveTile(mTile, GetTilePixels(mTile, mcRect));
+        };
+    }
+    const bool success = TraceTargets({ GetImageTarget() }, mcRect,
+        &m_TilesDone, tile_finished);
+    if (tile_finished)
+    {
+        m_Checkpoint.Sync();
+        m_PerformanceReport.SetCounter("checkpoint_seconds",
+            m_Checkpoint.GetSeconds());
+    }
+
+    // A complete image is traced from scratch the next time
+    m_TilesDoneKey = (success ? QString() : tracing_key);
+    m_TilesDonePlane = (success ? nullptr : m_LIC_R.constData());
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Tiles of the image
+int LIC::GetNumTiles() const
+{
+    return ((m_Image_Width + m_TileSize - 1) / m_TileSize) *
+        ((m_Image_Height + m_TileSize - 1) / m_TileSize);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pixels of a tile that are in a rectangle
+QRect LIC::GetTilePixels(int mTile, const QRect & mcRect) const
+{
+    const int num_tiles_x = (m_Image_Width + m_TileSize - 1) / m_TileSize;
+    const QRect rect = (mcRect.isEmpty() ?
+        QRect(0, 0, m_Image_Width, m_Image_Height) : mcRect);
+    return QRect((mTile % num_tiles_x) * m_TileSize,
+        (mTile / num_tiles_x) * m_TileSize, m_TileSize, m_TileSize)
+            .intersected(rect);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Share of the tiles for one of several processes
+QList < int > LIC::GetShardTiles(int mShard, int mNumShards,
+    const QRect & mcRect) const
+{
+    // Tiles overlapping the rectangle in a pseudo-random order that only
+    // depends on their position, dealt out like cards; shares differ by at
+    // most one tile, and expensive regions are split between all of them
+    const int num_tiles_x = (m_Image_Width + m_TileSize - 1) / m_TileSize;
+    QList < QPair < double, int > > order;
+    for (int tile = 0; tile < GetNumTiles(); tile++)
+    {
+        if (!GetTilePixels(tile, mcRect).isEmpty())
+        {
+            order << QPair < double, int >(
+                SimdKernels::GetPositionNoise(0, tile % num_tiles_x,
+                    tile / num_tiles_x), tile);
+        }
+    }
+    std::sort(order.begin(), order.end());
+    QList < int > tiles;
+    for (int order_idx = mShard; order_idx < order.size();
+         order_idx += mNumShards)
+    {
+        tiles << order[order_idx].second;
+    }
+    return tiles;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace one image per target
+bool LIC::TraceTargets(const QList < TraceTarget > mcTargets,
+    const QRect & mcRect, QList < bool > * mpTilesDone,
+    std::function < void(int) > mTileFinished)
+{
+    const QRect rect = (mcRect.isEmpty() ?
+        QRect(0, 0, m_Image_Width, m_Image_Height) : mcRect);
+
+    // Tiles; only those overlapping the rectangle are traced
+    const int num_tiles_x = (m_Image_Width + m_TileSize - 1) / m_TileSize;
+    const int num_tiles_y = (m_Image_Height + m_TileSize - 1) / m_TileSize;
+    const int tile_x_min = rect.left() / m_TileSize;
+    const int tile_x_max = rect.right() / m_TileSize;
+    const int tile_y_min = rect.top() / m_TileSize;
+    const int tile_y_max = rect.bottom() / m_TileSize;
+
+    // Finished tiles are marked from several threads, so the list must not
+    // detach while tracing
+    bool * tiles_done = (mcTargets.size() == 1 && mpTilesDone ?
+        mpTilesDone -> data() : nullptr);
+
+    // Tiles are traced in an interleaved order (with 16 passes: 0, 16, 32,
+    // ..., 1, 17, ...) so that the finished part is spread over the whole
+    // image. The cost of
+    // a tile depends a lot on the region it's in; this way, the progress
+    // seen so far is a good predictor for the remaining time.
+    QList < int > tile_order;
+    qint64 tile_pixels = 0;
+    for (int phase = 0; phase < m_TileInterleave; phase++)
+    {
+        for (int tile = phase;
+             tile < num_tiles_x * num_tiles_y;
+             tile += m_TileInterleave)
+        {
+            const int tile_x = tile % num_tiles_x;
+            const int tile_y = tile / num_tiles_x;
+            if (tile_x >= tile_x_min &&
+                tile_x <= tile_x_max &&
+                tile_y >= tile_y_min &&
+                tile_y <= tile_y_max &&
+                !(tiles_done && tiles_done[tile]))
+            {
+                tile_order << tile;
+                const QRect tile_rect(tile_x * m_TileSize,
+                    tile_y * m_TileSize, m_TileSize, m_TileSize);
+                const QRect traced = tile_rect.intersected(rect);
+                tile_pixels += qint64(traced.width()) * traced.height();
+            }
+        }
+    }
+    const int num_tiles = tile_order.size();
+
+    // Every target is traced tile by tile
+    const int num_targets = mcTargets.size();
+    const int num_items = num_targets * num_tiles;
+    const double total_pixels = double(tile_pixels) * num_targets;
+    if (num_items == 0)
+    {
+        return !m_CancelRequested;
+    }
+
+    // Progress is sampled by a separate thread
+    ProgressReporter progress(m_ProgressMode, "GenerateLIC",
+        qint64(total_pixels));
+    progress.Start();
+
+    // One item is one tile of one target. Pixels don't depend on each
+    // other, so the result is the same for any number of threads and any
+    // order of items.
+    std::atomic < qint64 > pixels_done(0);
+    auto trace_item = [&](int mItem, TraceWorkspace & mrWorkspace,
+        int & mrCurrentTarget)
+    {
+        // Switch to the planes and parameter value of another target
+        const int target_idx = mItem / num_tiles;
+        if (target_idx != mrCurrentTarget)
+        {
+            SetWorkspaceTarget(mrWorkspace, mcTargets[target_idx]);
+            mrCurrentTarget = target_idx;
+        }
+
+        const int tile = tile_order[mItem % num_tiles];
+        const qint64 steps_before = mrWorkspace.steps;
+        const int num_pixels = TraceTile(tile, num_tiles_x, rect,
+            mrWorkspace);
+        progress.AddWork(num_pixels, mrWorkspace.steps - steps_before);
+        pixels_done.fetch_add(num_pixels);
+
+        // A tile cut short by cancelling isn't finished
+        if (tiles_done &&
+            !m_CancelRequested.load(std::memory_order_relaxed))
+        {
+            tiles_done[tile] = true;
+            if (mTileFinished)
+            {
+                mTileFinished(tile);
+            }
+        }
+    };
+
+    // Callbacks are only called by the calling thread, so callers don't
+    // have to be thread-safe
+    auto call_callbacks = [&]()
+    {
+        if (m_ProgressCallback)
+        {
+            m_ProgressCallback(pixels_done / total_pixels);
+        }
+        if (m_CancelCallback &&
+            m_CancelCallback())
+        {
+            Cancel();
+        }
+    };
+
+    std::mutex counters_mutex;
+    TraceWorkspace counters;
+    auto merge_counters = [&](const TraceWorkspace & mcWorkspace)
+    {
+        std::lock_guard < std::mutex > lock(counters_mutex);
+        counters.field_evaluations += mcWorkspace.field_evaluations;
+        counters.steps += mcWorkspace.steps;
+        counters.singularity_breaks += mcWorkspace.singularity_breaks;
+        counters.length += mcWorkspace.length;
+    };
+
+    if (m_Scheduler)
+    {
+        // Threads of the scheduler take items of this job whenever there is
+        // nothing more urgent; every one of them has its own workspace
+        const int num_workers = m_Scheduler -> GetNumThreads();
+        QList < TraceWorkspace > workspaces(num_workers);
+        QList < int > current_targets(num_workers, -1);
+        QList < bool > initialized(num_workers, false);
+        TraceWorkspace * workspace_data = workspaces.data();
+        int * current_target_data = current_targets.data();
+        bool * initialized_data = initialized.data();
+        m_Scheduler -> RunJob(num_items, m_Priority, m_Deadline,
+            m_CancelRequested,
+            [&](int mItem, int mWorker)
+            {
+                if (!initialized_data[mWorker])
+                {
+                    InitializeWorkspace(workspace_data[mWorker]);
+                    initialized_data[mWorker] = true;
+                }
+                trace_item(mItem, workspace_data[mWorker],
+                    current_target_data[mWorker]);
+            },
+            call_callbacks);
+        for (const TraceWorkspace & workspace : workspaces)
+        {
+            merge_counters(workspace);
+        }
+    } else if (UsesWorkerProcesses())
+    {
+        // Workers see the noise, the field grids, and the rest of this
+        // object as they were when forked; those pages are only read, so
+        // they stay shared. Pixels go to planes in shared memory and are
+        // copied to the targets here once their tile is finished, so
+        // finished tiles and callbacks are handled as with threads.
+        const int num_processes = qBound(1, GetNumThreads(), num_items);
+        ProcessPool processes(num_processes);
+        const qint64 plane_size = qint64(m_Image_Width) * m_Image_Height;
+        void * state_memory =
+            processes.AllocateShared(sizeof(SharedTraceState));
+        SharedTraceCounters * worker_counters =
+            static_cast < SharedTraceCounters * >(processes.AllocateShared(
+                num_processes * qint64(sizeof(SharedTraceCounters))));
+        std::atomic < int > * items_done =
+            static_cast < std::atomic < int > * >(processes.AllocateShared(
+                num_items * qint64(sizeof(std::atomic < int >))));
+        double * shared_planes =
+            static_cast < double * >(processes.AllocateShared(
+                num_targets * 4 * plane_size * qint64(sizeof(double))));
+        bool started = state_memory &&
+            worker_counters &&
+            items_done &&
+            shared_planes;
+        SharedTraceState * state = nullptr;
+        QList < TraceTarget > shared_targets;
+        if (started)
+        {
+            state = new (state_memory) SharedTraceState();
+            for (int item = 0; item < num_items; item++)
+            {
+                new (items_done + item) std::atomic < int >(0);
+            }
+            for (int target_idx = 0; target_idx < num_targets; target_idx++)
+            {
+                double * planes = shared_planes + 4 * plane_size * target_idx;
+                TraceTarget target = mcTargets[target_idx];
+                target.lic_r = planes;
+                target.lic_g = planes + plane_size;
+                target.lic_b = planes + 2 * plane_size;
+                target.lic_strength = planes + 3 * plane_size;
+                shared_targets << target;
+            }
+        }
+
+        // Every worker takes the next item until none are left. Its own
+        // cancel flag is never set, so its tiles are always complete.
+        started = started && processes.Start(
+            [&](int mWorker)
+            {
+                TraceWorkspace workspace;
+                InitializeWorkspace(workspace);
+                int current_target = -1;
+                while (!state -> cancel.load(std::memory_order_relaxed))
+                {
+                    const int item = state -> next_item.fetch_add(1);
+                    if (item >= num_items)
+                    {
+                        break;
+                    }
+                    const int target_idx = item / num_tiles;
+                    if (target_idx != current_target)
+                    {
+                        SetWorkspaceTarget(workspace,
+                            shared_targets[target_idx]);
+                        current_target = target_idx;
+                    }
+                    const qint64 steps_before = workspace.steps;
+                    const int num_pixels = TraceTile(
+                        tile_order[item % num_tiles], num_tiles_x, rect,
+                        workspace);
+                    state -> pixels_done.fetch_add(num_pixels);
+                    state -> steps_done.fetch_add(
+                        workspace.steps - steps_before);
+                    items_done[item].store(1, std::memory_order_release);
+                }
+                SharedTraceCounters & counters = worker_counters[mWorker];
+                counters.field_evaluations = workspace.field_evaluations;
+                counters.steps = workspace.steps;
+                counters.singularity_breaks = workspace.singularity_breaks;
+                counters.length = workspace.length;
+            });
+
+        // Copy finished tiles to the targets
+        QList < bool > collected(num_items, false);
+        qint64 pixels_collected = 0;
+        qint64 steps_collected = 0;
+        auto collect = [&]()
+        {
+            const qint64 pixels = state -> pixels_done.load();
+            const qint64 steps = state -> steps_done.load();
+            progress.AddWork(pixels - pixels_collected,
+                steps - steps_collected);
+            pixels_done.fetch_add(pixels - pixels_collected);
+            pixels_collected = pixels;
+            steps_collected = steps;
+            for (int item = 0; item < num_items; item++)
+            {
+                if (collected[item] ||
+                    !items_done[item].load(std::memory_order_acquire))
+                {
+                    continue;
+                }
+                const int target_idx = item / num_tiles;
+                const int tile = tile_order[item % num_tiles];
+                const TraceTarget & source = shared_targets[target_idx];
+                const TraceTarget & destination = mcTargets[target_idx];
+                const QRect pixels_rect = GetTilePixels(tile, rect);
+                const qint64 column_bytes =
+                    pixels_rect.height() * qint64(sizeof(double));
+                for (int ix = pixels_rect.left(); ix <= pixels_rect.right();
+                     ix++)
+                {
+                    const qint64 offset =
+                        qint64(ix) * m_Image_Height + pixels_rect.top();
+                    memcpy(destination.lic_r + offset, source.lic_r + offset,
+                        column_bytes);
+                    memcpy(destination.lic_g + offset, source.lic_g + offset,
+                        column_bytes);
+                    memcpy(destination.lic_b + offset, source.lic_b + offset,
+                        column_bytes);
+                    memcpy(destination.lic_strength + offset,
+                        source.lic_strength + offset, column_bytes);
+                }
+                collected[item] = true;
+                if (tiles_done)
+                {
+                    tiles_done[tile] = true;
+                    if (mTileFinished)
+                    {
+                        mTileFinished(tile);
+                    }
+                }
+            }
+        };
+        while (started &&
+            processes.Wait(PROCESS_POLL_INTERVAL_MS) > 0)
+        {
+            collect();
+            call_callbacks();
+            if (m_CancelRequested)
+            {
+                state -> cancel = true;
+            }
+        }
+        if (started)
+        {
+            collect();
+            for (int worker = 0; worker < num_processes; worker++)
+            {
+                TraceWorkspace workspace;
+                workspace.field_evaluations =
+                    worker_counters[worker].field_evaluations;
+                workspace.steps = worker_counters[worker].steps;
+                workspace.singularity_breaks =
+                    worker_counters[worker].singularity_breaks;
+                workspace.length = worker_counters[worker].length;
+                merge_counters(workspace);
+            }
+        }
+
+        // Items of workers that crashed, or all of them if there are no
+        // workers, are traced here
+        if (!started ||
+            processes.GetNumFailed() > 0)
+        {
+            qDebug().noquote() << QString("%1 of %2 worker processes "
+                "failed; tracing their tiles in this process.")
+                .arg(QString::number(started ?
+                        processes.GetNumFailed() : num_processes),
+                     QString::number(num_processes));
+        }
+        TraceWorkspace workspace;
+        InitializeWorkspace(workspace);
+        int current_target = -1;
+        for (int item = 0;
+             item < num_items &&
+                 !m_CancelRequested.load(std::memory_order_relaxed);
+             item++)
+        {
+            if (!collected[item])
+            {
+                trace_item(item, workspace, current_target);
+                call_callbacks();
+            }
+        }
+        merge_counters(workspace);
+    } else
+    {
+        // Every thread picks the next item until none are left. The calling
+        // thread traces as well.
+        const int num_threads = qBound(1, GetNumThreads(), num_items);
+
+        // On hosts with several memory nodes, every node has a queue with
+        // the tiles in its strip of columns, where its pages of the planes
+        // and noise are (see DistributePlanes()). Threads take items from
+        // the queue of their own node first, then help the others.
+        const NumaTopology & topology = NumaTopology::GetHost();
+        const int num_nodes = (m_NUMAPlacement ? topology.GetNumNodes() : 1);
+        QList < QList < int > > node_items(num_nodes);
+        for (int item = 0; item < num_items; item++)
+        {
+            const int tile_x = tile_order[item % num_tiles] % num_tiles_x;
+            node_items[NumaTopology::GetNodeOfColumn(tile_x * m_TileSize,
+                m_Image_Width, num_nodes)] << item;
+        }
+        std::vector < std::atomic < int > > next_items(num_nodes);
+        for (std::atomic < int > & next_item : next_items)
+        {
+            next_item = 0;
+        }
+        auto take_item = [&](int mNode)
+        {
+            for (int node_offset = 0; node_offset < num_nodes; node_offset++)
+            {
+                const int node = (mNode + node_offset) % num_nodes;
+                const int position = next_items[node].fetch_add(1);
+                if (position < node_items[node].size())
+                {
+                    return node_items[node][position];
+                }
+            }
+            return -1;
+        };
+
+        // Pinned threads share a copy of the formulas with the threads of
+        // their node only; it is made by the first of them, so its memory
+        // is on that node
+        const bool pin_threads = m_PinThreads && !m_ThreadPool;
+        const bool replicate = pin_threads && num_nodes > 1;
+        std::vector < std::once_flag > replica_flags(num_nodes);
+        std::vector < QPair < AbstractFunction *, AbstractFunction * > >
+            replicas(num_nodes,
+                QPair < AbstractFunction *, AbstractFunction * >(nullptr,
+                    nullptr));
+
+        auto trace_items = [&](bool mIsCallingThread, int mThreadIdx)
+        {
+            TraceWorkspace workspace;
+            InitializeWorkspace(workspace);
+            int node = 0;
+            if (pin_threads &&
+                !mIsCallingThread &&
+                topology.PinThread(mThreadIdx))
+            {
+                node = topology.GetNodeOfThread(mThreadIdx) % num_nodes;
+            } else if (num_nodes > 1)
+            {
+                node = topology.GetCurrentNode() % num_nodes;
+            }
+            if (replicate &&
+                !mIsCallingThread)
+            {
+                std::call_once(replica_flags[node],
+                    [&]()
+                    {
+                        replicas[node].first = m_Vectorfield_X -> Clone();
+                        replicas[node].second = m_Vectorfield_Y -> Clone();
+                    });
+                if (replicas[node].first &&
+                    replicas[node].second)
+                {
+                    workspace.vectorfield_x = replicas[node].first;
+                    workspace.vectorfield_y = replicas[node].second;
+                }
+            }
+            int current_target = -1;
+            while (!m_CancelRequested.load(std::memory_order_relaxed))
+            {
+                const int item = take_item(node);
+                if (item < 0)
+                {
+                    break;
+                }
+                trace_item(item, workspace, current_target);
+                if (mIsCallingThread)
+                {
+                    call_callbacks();
+                }
+            }
+            merge_counters(workspace);
+        };
+
+        // Helpers come from the shared pool, or from a pool of our own
+        ThreadPool own_pool(m_ThreadPool ? 0 : num_threads - 1);
+        ThreadPool & pool = (m_ThreadPool ? *m_ThreadPool : own_pool);
+        const int num_helpers = qMin(num_threads - 1, pool.GetNumThreads());
+        std::mutex helpers_mutex;
+        std::condition_variable helpers_condition;
+        int num_helpers_running = num_helpers;
+        for (int helper_idx = 0; helper_idx < num_helpers; helper_idx++)
+        {
+            pool.Submit(
+                [&, helper_idx]()
+                {
+                    trace_items(false, helper_idx);
+
+                    // Notify while holding the lock; the condition is gone
+                    // as soon as the calling thread sees zero
+                    std::lock_guard < std::mutex > lock(helpers_mutex);
+                    num_helpers_running--;
+                    helpers_condition.notify_all();
+                });
+        }
+        trace_items(true, num_helpers);
+        {
+            std::unique_lock < std::mutex > lock(helpers_mutex);
+            helpers_condition.wait(lock,
+                [&]()
+                {
+                    return num_helpers_running == 0;
+                });
+        }
+        int num_replicas = 0;
+        for (const QPair < AbstractFunction *, AbstractFunction * > & replica :
+            replicas)
+        {
+            num_replicas += (replica.first && replica.second ? 1 : 0);
+            delete replica.first;
+            delete replica.second;
+        }
+        m_PerformanceReport.AddToCounter("formula_replicas", num_replicas);
+    }
+    progress.Stop();
+
+    // Save counters
+    m_PerformanceReport.AddToCounter("field_evaluations",
+        counters.field_evaluations);
+    m_PerformanceReport.AddToCounter("streamline_steps", counters.steps);
+    m_PerformanceReport.AddToCounter("singularity_breaks",
+        counters.singularity_breaks);
+    m_PerformanceReport.AddToCounter("streamline_length", counters.length);
+
+    return !m_CancelRequested;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Prepare per-thread state for tracing
+void LIC::InitializeWorkspace(TraceWorkspace & mrWorkspace) const
+{
+    // Own copy of the parameters that already contains the coordinates, so
+    // evaluating the vector field only overwrites values
+    mrWorkspace.variables = m_Parameters;
+    mrWorkspace.variables[variable_x] = 0.;
+    mrWorkspace.variables[variable_y] = 0.;
+    mrWorkspace.vectorfield_x = m_Vectorfield_X;
+    mrWorkspace.vectorfield_y = m_Vectorfield_Y;
+
+    // Where things are in the frame
+    const QSize frame = GetFrameSize();
+    const QRect window = GetNoiseWindow();
+    mrWorkspace.frame_width = frame.width();
+    mrWorkspace.frame_height = frame.height();
+    mrWorkspace.image_x = (m_ROI.isEmpty() ? 0 : m_ROI.x());
+    mrWorkspace.image_y = (m_ROI.isEmpty() ? 0 : m_ROI.y());
+    mrWorkspace.noise_x = window.x();
+    mrWorkspace.noise_y = window.y();
+    mrWorkspace.noise_height = window.height();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Planes of this object as a target
+LIC::TraceTarget LIC::GetImageTarget()
+{
+    TraceTarget target;
+    target.lic_r = m_LIC_R.data();
+    target.lic_g = m_LIC_G.data();
+    target.lic_b = m_LIC_B.data();
+    target.lic_strength = m_LIC_Strength.data();
+    target.sweep_value = m_Parameters.value(m_Sweep_Parameter, 0.);
+    return target;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Let a workspace write to a target
+void LIC::SetWorkspaceTarget(TraceWorkspace & mrWorkspace,
+    const TraceTarget & mcTarget) const
+{
+    mrWorkspace.lic_r = mcTarget.lic_r;
+    mrWorkspace.lic_g = mcTarget.lic_g;
+    mrWorkspace.lic_b = mcTarget.lic_b;
+    mrWorkspace.lic_strength = mcTarget.lic_strength;
+
+    // The swept parameter is the only variable that changes between
+    // targets; it's already in the hash, so this doesn't allocate
+    if (!m_Sweep_Parameter.isEmpty())
+    {
+        mrWorkspace.variables[m_Sweep_Parameter] = mcTarget.sweep_value;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace the pixels of a tile that are in a rectangle
+int LIC::TraceTile(int mTile, int mNumTilesX, const QRect & mcRect,
+    TraceWorkspace & mrWorkspace)
+{
+    const int tile_x = (mTile % mNumTilesX) * m_TileSize;
+    const int tile_y = (mTile / mNumTilesX) * m_TileSize;
+    const int ix_min = qMax(tile_x, mcRect.left());
+    const int iy_min = qMax(tile_y, mcRect.top());
+    const int ix_max = qMin(tile_x + m_TileSize, mcRect.right() + 1);
+    const int iy_max = qMin(tile_y + m_TileSize, mcRect.bottom() + 1);
+    for (int ix = ix_min; ix < ix_max; ix++)
+    {
+        // A tile takes long with many steps; this releases the thread
+        // within a column of pixels
+        if (m_CancelRequested.load(std::memory_order_relaxed))
+        {
+            return (ix - ix_min) * (iy_max - iy_min);
+        }
+        for (int iy = iy_min; iy < iy_max; iy++)
+        {
+            TracePixel(ix, iy, mrWorkspace);
+        }
+    }
+    return (ix_max - ix_min) * (iy_max - iy_min);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace streamlines through one pixel and save its color
+void LIC::TracePixel(int mIX, int mIY, TraceWorkspace & mrWorkspace)
+{
+    // For conversion from grid to actual x/y values; the grid is the
+    // whole frame
+    const int frame_width = mrWorkspace.frame_width;
+    const int frame_height = mrWorkspace.frame_height;
+    const double dx = (m_Image_XMax - m_Image_XMin) / (frame_width - 1.);
+    const double dy = (m_Image_YMax - m_Image_YMin) / (frame_height - 1.);
+
+    // Noise may be shared with other renderers, so it's only read through
+    // const pointers (no detaching of the lists while tracing)
+    const double * noise_r = m_Noise_R.constData();
+    const double * noise_g = m_Noise_G.constData();
+    const double * noise_b = m_Noise_B.constData();
+
+    double color_r = 0.;
+    double color_g = 0.;
+    double color_b = 0.;
+
+    double lic_length = 0;
+    double strength = 0.;
+    for (int direction : {-1, 1})
+    {
+        // Grid coordinate system
+        // We have to remember that the origin of our coordinate system
+        // is at the top left corner, not at the bottom left corner
+        int grid_x = mIX + mrWorkspace.image_x;
+        double grid_dx = 0;
+        int grid_y = (frame_height - 1) - (mIY + mrWorkspace.image_y);
+        double grid_dy = 0;
+
+        for (int step = 0; step < m_Steps; step++)
+        {
+            // Evaluate vector field
+            double x = m_Image_XMin + (grid_x + grid_dx) * dx;
+            double y = m_Image_YMin + (grid_y + grid_dy) * dy;
+            QPair < double, double > v =
+                EvaluateVectorfield(x, y, mrWorkspace);
+            mrWorkspace.field_evaluations++;
+            double vx = direction * v.first;
+            double vy = direction * v.second;
+
+            // Normalize
+            double r = sqrt(vx*vx + vy*vy);
+
+            // The very first sample is taken at the pixel itself, so
+            // it is the strength of the vector field there
+            if (direction == -1 &&
+                step == 0)
+            {
+                strength = r;
+            }
+
+            if (r <= 1e-14)
+            {
+                // Avoid singularities; we're not escaping a vanishing
+                // vector field anyway.
+                mrWorkspace.singularity_breaks++;
+                break;
+            }
+            vx /= r;
+            vy /= r;
+
+            // Calculate step size in this grid box
+            double sx = 1e10;
+            if (vx > 0)
+            {
+                sx = (1. - grid_dx)/vx;
+            } else if (vx < 0)
+            {
+                if (abs(grid_dx) <= 1e-13)
+                {
+                    sx = -1/vx;
+                } else
+                {
+                    sx = -grid_dx/vx;
+                }
+            }
+            double sy = 1e10;
+            if (vy > 0)
+            {
+                sy = (1. - grid_dy)/vy;
+            } else if (vy < 0)
+            {
+                if (abs(grid_dy) <= 1e-13)
+                {
+                    sy = -1/vy;
+                } else
+                {
+                    sy = -grid_dy/vy;
+                }
+            }
+            double s = qMin(sx, sy);
+
+            // Integrate color; the frame wraps around, and the noise
+            // window starts at noise_x/noise_y
+            int color_grid_x = (grid_x - mrWorkspace.noise_x) % frame_width;
+            if (color_grid_x < 0)
+            {
+                color_grid_x += frame_width;
+            }
+            int color_grid_y = (grid_y - mrWorkspace.noise_y) % frame_height;
+            if (color_grid_y < 0)
+            {
+                color_grid_y += frame_height;
+            }
+            const qsizetype idx = qsizetype(color_grid_x) *
+                mrWorkspace.noise_height + color_grid_y;
+            //if (r > 0.1)
+            double sink_capture = 1/(1/r+1);
+            color_r += sink_capture * s * noise_r[idx];
+            color_g += sink_capture * s * noise_g[idx];
+            color_b += sink_capture * s * noise_b[idx];
+
+            // Update coordinates
+            grid_dx += s * vx;
+            if (grid_dx < 0)
+            {
+                grid_x -= 1;
+                grid_dx += 1;
+            }
+            if (grid_dx >= 1)
+            {
+                grid_x += 1;
+                grid_dx -= 1;
+            }
+            grid_dy += s * vy;
+            if (grid_dy < 0)
+            {
+                grid_y -= 1;
+                grid_dy += 1;
+            }
+            if (grid_dy >= 1)
+            {
+                grid_y += 1;
+                grid_dy -= 1;
+            }
+
+            // Add up color
+            lic_length += s;
+            mrWorkspace.steps++;
+        }
+    }
+    mrWorkspace.length += lic_length;
+
+    // Set point
+    color_r /= lic_length;
+    color_g /= lic_length;
+    color_b /= lic_length;
+
+    // Save information
+    const qsizetype idx = qsizetype(mIX) * m_Image_Height + mIY;
+    mrWorkspace.lic_r[idx] = color_r;
+    mrWorkspace.lic_g[idx] = color_g;
+    mrWorkspace.lic_b[idx] = color_b;
+    mrWorkspace.lic_strength[idx] = strength;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Evaluate vector field
+QPair < double, double > LIC::EvaluateVectorfield(double mX, double mY,
+    QHash < QString, double > & mrVariables) const
+{
+    for (int iteration = 0;
+         iteration < m_Vectorfield_Iterate;
+         iteration++)
+    {
+        mrVariables[variable_x] = mX;
+        mrVariables[variable_y] = mY;
+        mX = m_Vectorfield_X -> Evaluate(mrVariables);
+        mY = m_Vectorfield_Y -> Evaluate(mrVariables);
+    }
+    return QPair < double, double >(mX, mY);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Evaluate vector field with the formulas of a workspace
+QPair < double, double > LIC::EvaluateVectorfield(double mX, double mY,
+    TraceWorkspace & mrWorkspace) const
+{
+    for (int iteration = 0;
+         iteration < m_Vectorfield_Iterate;
+         iteration++)
+    {
+        mrWorkspace.variables[variable_x] = mX;
+        mrWorkspace.variables[variable_y] = mY;
+        mX = mrWorkspace.vectorfield_x -> Evaluate(mrWorkspace.variables);
+        mY = mrWorkspace.vectorfield_y -> Evaluate(mrWorkspace.variables);
+    }
+    return QPair < double, double >(mX, mY);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Values mapped to black and white, and to the ends of the colormap
+LIC::Normalization LIC::GetNormalization(const QRect & mcRect) const
+{
+    const QRect rect = (mcRect.isEmpty() ?
+        QRect(0, 0, m_Image_Width, m_Image_Height) : mcRect);
+    const double * lic_r = m_LIC_R.constData();
+    const double * lic_g = m_LIC_G.constData();
+    const double * lic_b = m_LIC_B.constData();
+    const double * lic_strength = m_LIC_Strength.constData();
+    Normalization normalization;
+
+    // Ranges of the columns of the rect. The log scale is monotonic, so
+    // only the ends of the range of strength need to be scaled.
+    const SimdKernels & kernels = CpuDispatch::GetKernels();
+    const double infinity = std::numeric_limits < double >::infinity();
+    double range[4] = { infinity, -infinity, infinity, -infinity };
+    bool has_nan = false;
+    for (int ix = rect.left(); ix <= rect.right() && !has_nan; ix++)
+    {
+        const qsizetype idx = qsizetype(ix) * m_Image_Height + rect.top();
+        has_nan = !kernels.min_max(lic_r + idx, lic_g + idx, lic_b + idx,
+            lic_strength + idx, rect.height(), range);
+    }
+    if (!has_nan)
+    {
+        normalization.min_intensity =
+            qMin(normalization.min_intensity, range[0]);
+        normalization.max_intensity =
+            qMax(normalization.max_intensity, range[1]);
+        if (m_Coloring_LogScale)
+        {
+            range[2] = log10(qMax(range[2], 1e-14));
+            range[3] = log10(qMax(range[3], 1e-14));
+        }
+        normalization.min_strength =
+            qMin(normalization.min_strength, range[2]);
+        normalization.max_strength =
+            qMax(normalization.max_strength, range[3]);
+        return normalization;
+    }
+
+    // With NaNs, the range depends on the order of the values
+    for (int ix = rect.left(); ix <= rect.right(); ix++)
+    {
+        for (int iy = rect.top(); iy <= rect.bottom(); iy++)
+        {
+            const qsizetype idx = qsizetype(ix) * m_Image_Height + iy;
+            normalization.min_intensity = qMin(normalization.min_intensity,
+                qMin(lic_r[idx], qMin(lic_g[idx], lic_b[idx])));
+            normalization.max_intensity = qMax(normalization.max_intensity,
+                qMax(lic_r[idx], qMax(lic_g[idx], lic_b[idx])));
+
+            // The threshold of the log scale is the same as for
+            // singularities in the tracer
+            const double strength = (m_Coloring_LogScale ?
+                log10(qMax(lic_strength[idx], 1e-14)) : lic_strength[idx]);
+            normalization.min_strength =
+                qMin(normalization.min_strength, strength);
+            normalization.max_strength =
+                qMax(normalization.max_strength, strength);
+        }
+    }
+    return normalization;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Normalize, color, and write pixels to a buffer
+void LIC::GenerateImage(void * mpBuffer, qsizetype mStride,
+    PixelFormat mFormat, const QRect & mcRect, Channel mChannel,
+    const Normalization * mpNormalization) const
+{
+    const QRect rect = (mcRect.isEmpty() ?
+        QRect(0, 0, m_Image_Width, m_Image_Height) : mcRect);
+    const double * lic_r = m_LIC_R.constData();
+    const double * lic_g = m_LIC_G.constData();
+    const double * lic_b = m_LIC_B.constData();
+    const double * lic_strength = m_LIC_Strength.constData();
+
+    // What goes into a pixel. Strength without a colormap is shown in gray.
+    const bool use_intensity = (mChannel != Channel_Strength);
+    Colormap * gray = nullptr;
+    if (mChannel == Channel_Strength &&
+        !m_Colormap)
+    {
+        gray = Colormap::CreateColormap("gray", 1.);
+    }
+    const Colormap * colormap = (mChannel == Channel_Intensity ?
+        nullptr : (gray ? gray : m_Colormap));
+
+    // === Ranges of intensity and strength
+    const Normalization normalization = (mpNormalization ?
+        *mpNormalization : GetNormalization(rect));
+    const double min_intensity = normalization.min_intensity;
+    const double min_strength = normalization.min_strength;
+    const double intensity_scale =
+        (normalization.max_intensity > min_intensity ?
+            255. / (normalization.max_intensity - min_intensity) : 0.);
+    const double strength_scale =
+        (normalization.max_strength > min_strength ?
+            (Colormap::LUT_SIZE - 1.) /
+                (normalization.max_strength - min_strength) : 0.);
+
+    // === Renormalize, apply color, and write pixels in one pass. Colors
+    // are computed for segments of columns, which are contiguous.
+    SimdKernels::ColorParameters parameters;
+    parameters.use_intensity = use_intensity;
+    parameters.min_intensity = min_intensity;
+    parameters.intensity_scale = intensity_scale;
+    parameters.lut_r = (colormap ? colormap -> GetLUT_R() : nullptr);
+    parameters.lut_g = (colormap ? colormap -> GetLUT_G() : nullptr);
+    parameters.lut_b = (colormap ? colormap -> GetLUT_B() : nullptr);
+    parameters.lut_size = Colormap::LUT_SIZE;
+    parameters.log_scale = m_Coloring_LogScale;
+    parameters.min_strength = min_strength;
+    parameters.strength_scale = strength_scale;
+    const SimdKernels & kernels = CpuDispatch::GetKernels();
+    double red[SimdKernels::MAX_SEGMENT];
+    double green[SimdKernels::MAX_SEGMENT];
+    double blue[SimdKernels::MAX_SEGMENT];
+    for (int first_row = rect.top(); first_row <= rect.bottom();
+        first_row += SimdKernels::MAX_SEGMENT)
+    {
+        const int num_rows =
+            qMin(SimdKernels::MAX_SEGMENT, rect.bottom() + 1 - first_row);
+        for (int ix = rect.left(); ix <= rect.right(); ix++)
+        {
+            // Colors in [0, 255]
+            const qsizetype idx = qsizetype(ix) * m_Image_Height + first_row;
+            parameters.lic_r = lic_r + idx;
+            parameters.lic_g = lic_g + idx;
+            parameters.lic_b = lic_b + idx;
+            parameters.lic_strength = lic_strength + idx;
+            kernels.color(parameters, num_rows, red, green, blue);
+
+            // Write in the requested format
+            const int column = ix - rect.left();
+            for (int row = 0; row < num_rows; row++)
+            {
+                uchar * line = static_cast < uchar * >(mpBuffer) +
+                    (first_row + row - rect.top()) * mStride;
+                if (mFormat == PixelFormat_RGBX8)
+                {
+                    uchar * pixel = line + 4 * column;
+                    pixel[0] = uchar(red[row]);
+                    pixel[1] = uchar(green[row]);
+                    pixel[2] = uchar(blue[row]);
+                    pixel[3] = 255;
+                } else
+                {
+                    float * pixel =
+                        reinterpret_cast < float * >(line) + 3 * column;
+                    pixel[0] = float(red[row] / 255.);
+                    pixel[1] = float(green[row] / 255.);
+                    pixel[2] = float(blue[row] / 255.);
+                }
+            }
+        }
+    }
+    delete gray;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Generate image and save it to the output file
+bool LIC::SaveImage(const QString mcFilename)
+{
+    // The image has the layout of PixelFormat_RGBX8, so pixels are written
+    // into it without a copy
+    QImage lic_image(m_Image_Width, m_Image_Height,
+        QImage::Format_RGBX8888);
+    GenerateImage(lic_image.bits(), lic_image.bytesPerLine(),
+        PixelFormat_RGBX8);
+    if (!lic_image.save(mcFilename, "png"))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Image \"%1\" could not be saved.").arg(mcFilename));
+        return false;
+    }
+    return true;
+}
+
+
+
+// =========================================================== Helper renderers
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Start a run
+void LIC::ResetCancel()
+{
+    m_CancelRequested = false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Run a timed stage of a render
+bool LIC::RunStage(const QString mcName, std::function < bool() > mStage)
+{
+    PerformanceReport::StageTimer timer(m_PerformanceReport, mcName);
+    return mStage();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Report of the current run
+PerformanceReport & LIC::GetMutablePerformanceReport()
+{
+    return m_PerformanceReport;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Shared copies of the noise planes
+QList < QList < double > > LIC::GetNoisePlanes() const
+{
+    return QList < QList < double > >({ m_Noise_R, m_Noise_G, m_Noise_B });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Noise planes, leaving this renderer without them
+QList < QList < double > > LIC::TakeNoisePlanes()
+{
+    QList < QList < double > > planes(3);
+    planes[0].swap(m_Noise_R);
+    planes[1].swap(m_Noise_G);
+    planes[2].swap(m_Noise_B);
+    return planes;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Replace the noise planes
+void LIC::AdoptNoisePlanes(const QList < QList < double > > & mcPlanes)
+{
+    m_Noise_R = mcPlanes.value(0);
+    m_Noise_G = mcPlanes.value(1);
+    m_Noise_B = mcPlanes.value(2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Shared copies of the traced planes
+QList < QList < double > > LIC::GetTracedPlanes() const
+{
+    return QList < QList < double > >(
+        { m_LIC_R, m_LIC_G, m_LIC_B, m_LIC_Strength });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Traced planes, leaving this renderer without them
+QList < QList < double > > LIC::TakeTracedPlanes()
+{
+    QList < QList < double > > planes(4);
+    planes[0].swap(m_LIC_R);
+    planes[1].swap(m_LIC_G);
+    planes[2].swap(m_LIC_B);
+    planes[3].swap(m_LIC_Strength);
+    return planes;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Replace the traced planes
+void LIC::AdoptTracedPlanes(const QList < QList < double > > & mcPlanes)
+{
+    m_LIC_R = mcPlanes.value(0);
+    m_LIC_G = mcPlanes.value(1);
+    m_LIC_B = mcPlanes.value(2);
+    m_LIC_Strength = mcPlanes.value(3);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Traced planes of the size of the image
+void LIC::AllocateTracedPlanes()
+{
+    const qsizetype num_pixels = qsizetype(m_Image_Width) * m_Image_Height;
+    m_LIC_R.resize(num_pixels);
+    m_LIC_G.resize(num_pixels);
+    m_LIC_B.resize(num_pixels);
+    m_LIC_Strength.resize(num_pixels);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Region of interest of the frame
+QRect LIC::GetRegion() const
+{
+    return m_ROI;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Switch to another region of interest, or back to the whole frame
+void LIC::SetRegion(const QRect & mcROI)
+{
+    if (!mcROI.isEmpty())
+    {
+        SetROI(mcROI);
+        return;
+    }
+    const QSize frame = GetFrameSize();
+    m_ROI = QRect();
+    m_Image_Width = frame.width();
+    m_Image_Height = frame.height();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Images written by Execute()
+QList < LIC::Output > LIC::GetOutputs() const
+{
+    return m_Outputs;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Replace the images written by Execute()
+void LIC::SetOutputs(const QList < Output > & mcOutputs)
+{
+    m_Outputs = mcOutputs;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Images of a sweep
+int LIC::GetSweepCount() const
+{
+    return (HasSweep() ? m_Sweep_Count : 0);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the contact sheet of a sweep
+QSize LIC::GetContactSheetSize() const
+{
+    if (!HasSweep() ||
+        !m_Sweep_ContactSheet)
+    {
+        return QSize();
+    }
+    const int num_rows = (m_Sweep_Count + m_Sweep_Columns - 1) /
+        m_Sweep_Columns;
+    return QSize(m_Sweep_Columns * m_Image_Width,
+        num_rows * m_Image_Height);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Tiles are traced by worker processes
+bool LIC::UsesWorkerProcesses() const
+{
+    return !m_Scheduler &&
+        m_Backend == Backend_Processes &&
+        !m_ThreadPool &&
+        ProcessPool::IsAvailable();
+}
+
+
+
+// ================================================================ Performance
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Timings and counters of the last run
+const PerformanceReport & LIC::GetPerformanceReport() const
+{
+    return m_PerformanceReport;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads used for tracing (0: one per core)
+void LIC::SetNumThreads(int mNumThreads)
+{
+    m_NumThreads = mNumThreads;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads actually used for tracing
+int LIC::GetNumThreads() const
+{
+    return (m_NumThreads > 0 ? m_NumThreads : QThread::idealThreadCount());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace with threads or worker processes
+void LIC::SetBackend(Backend mBackend)
+{
+    m_Backend = mBackend;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Backend selected for tracing
+LIC::Backend LIC::GetBackend() const
+{
+    return m_Backend;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Backend from its command line name
+bool LIC::BackendFromString(const QString mcName, Backend & mrBackend)
+{
+    if (mcName == "threads")
+    {
+        mrBackend = Backend_Threads;
+        return true;
+    }
+    if (mcName == "processes")
+    {
+        mrBackend = Backend_Processes;
+        return true;
+    }
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the tiles the image is traced in
+void LIC::SetTileSize(int mTileSize)
+{
+    m_TileSize = qMax(mTileSize, 1);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the tiles the image is traced in
+int LIC::GetTileSize() const
+{
+    return m_TileSize;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of interleaved passes over the tiles
+void LIC::SetTileInterleave(int mTileInterleave)
+{
+    m_TileInterleave = qMax(mTileInterleave, 1);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of interleaved passes over the tiles
+int LIC::GetTileInterleave() const
+{
+    return m_TileInterleave;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Place buffers on the nodes of the threads using them
+void LIC::SetNUMAPlacement(bool mPlacement)
+{
+    m_NUMAPlacement = mPlacement;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pin tracing threads to CPUs
+void LIC::SetPinThreads(bool mPinThreads)
+{
+    m_PinThreads = mPinThreads;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace with the threads of a shared pool
+void LIC::SetThreadPool(ThreadPool * mpThreadPool)
+{
+    m_ThreadPool = mpThreadPool;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace with the threads of a shared scheduler
+void LIC::SetScheduler(TileScheduler * mpScheduler)
+{
+    m_Scheduler = mpScheduler;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Priority and deadline of tracing with a scheduler
+void LIC::SetPriority(int mPriority, const QDeadlineTimer & mcDeadline)
+{
+    m_Priority = mPriority;
+    m_Deadline = mcDeadline;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Keep noise and traced images in a directory
+void LIC::SetCacheDirectory(const QString mcDirectory)
+{
+    m_Cache.SetDirectory(mcDirectory);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Keep finished tiles in a file while tracing
+void LIC::SetCheckpoint(const QString mcFilename, bool mResume)
+{
+    m_Checkpoint.SetFilename(mcFilename, mResume);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// How progress is shown while tracing
+void LIC::SetProgressMode(ProgressReporter::Mode mMode)
+{
+    m_ProgressMode = mMode;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// How progress is shown while tracing
+ProgressReporter::Mode LIC::GetProgressMode() const
+{
+    return m_ProgressMode;
 }
@@ -4,13 +4,29 @@
 #ifndef LIC_H
 #define LIC_H
 
+// Project includes
+#include "Checkpoint.h"
+#include "PerformanceReport.h"
+#include "ProgressReporter.h"
+#include "StageCache.h"
+
 // Qt includes
+#include <QDeadlineTimer>
 #include <QDomElement>
 #include <QHash>
 #include <QObject>
+#include <QRect>
+#include <QSize>
+
+// System includes
+#include <atomic>
+#include <functional>
 
 // Forward declaration
 class AbstractFunction;
+class Colormap;
+class ThreadPool;
+class TileScheduler;
 
 
 
@@ -18,6 +34,35 @@ class AbstractFunction;
 class LIC
     : public QObject
 {
+    // Benchmarks measure the individual stages and their buffers
+    friend class Benchmark;
+
+    // The helper renderers below run the private stages, but only reach
+    // the state of a renderer through the "Helper renderers" section and
+    // the public accessors
+
+    // Batches share the results of stages between jobs
+    friend class BatchRenderer;
+
+    // Watch mode keeps the results of stages between changes
+    friend class ConfigWatcher;
+
+    // Shards trace a share of the tiles each, and are merged into outputs
+    friend class ShardRenderer;
+
+    // The server keeps renderers between requests
+    friend class RenderServer;
+
+    // The autotuner traces samples of tiles with different settings
+    friend class Autotuner;
+
+    // The estimator traces single pixels as regions of interest
+    friend class RenderEstimator;
+
+    // Pyramids render their tiles as regions of interest; the pyramid is
+    // part of the configuration, so its settings are read directly
+    friend class PyramidRenderer;
+
     // ============================================================== Lifecycle
 public:
     // Constructor
@@ -33,19 +78,80 @@ public:
     // Read configuration
     bool ReadXMLConfiguration(const QString mcFilename);
 
+    // Configuration from XML text or from an already parsed <lic> element
+    bool SetXMLConfiguration(const QString mcXML);
+    bool SetConfiguration(const QDomElement & mcDomLIC);
+
+    // Configuration without XML. The functions are owned by this object
+    // afterwards (also if they are rejected).
+    bool SetVectorfield(AbstractFunction * mpFunctionX,
+        AbstractFunction * mpFunctionY,
+        const QHash < QString, double > mcParameters, int mIterations = 1);
+    bool SetVectorfield(const QString mcFormulaX, const QString mcFormulaY,
+        const QHash < QString, double > mcParameters, int mIterations = 1);
+    bool SetImageRange(double mXMin, double mXMax, double mYMin,
+        double mYMax);
+    bool SetResolution(int mWidth, int mHeight);
+    bool SetSteps(int mSteps);
+    bool SetWhiteNoiseBackground(double mCutoff, int mSeed);
+    bool SetColoring(const QString mcColormap, double mGamma,
+        bool mLogScale);
+
+    // Size of the image
+    int GetImageWidth() const;
+    int GetImageHeight() const;
+
+    // Formulas of the vector field and how often it's iterated, the steps
+    // of a streamline in each direction, and the part of the plane the
+    // image shows
+    QPair < QString, QString > GetVectorfieldFormulas() const;
+    int GetVectorfieldIterations() const;
+    int GetSteps() const;
+    void GetImageRange(double & mrXMin, double & mrXMax, double & mrYMin,
+        double & mrYMax) const;
+
+    // The configuration has been read without errors
+    bool IsValid() const;
+
+    // A parameter is swept, so Execute() renders several images
+    bool HasSweep() const;
+
+    // Execute() renders a tile pyramid instead of outputs
+    bool HasPyramid() const;
+
 private:
+    // Everything needed for rendering has been set
+    bool IsComplete() const;
+
     // Vectorfield
     bool ParseVectorfield(QDomElement & mrDomVectorfield);
+    void ClearVectorfield();
 
     QHash < QString, double > m_Parameters;
     QHash < QString, AbstractFunction * > m_Vectorfield;
+    AbstractFunction * m_Vectorfield_X;
+    AbstractFunction * m_Vectorfield_Y;
     int m_Vectorfield_Iterate;
 
+    // Parameter sweep (optional)
+    bool ParseSweep(QDomElement & mrDomSweep);
+
+    QString m_Sweep_Parameter;
+    double m_Sweep_From;
+    double m_Sweep_To;
+    int m_Sweep_Count;
+    bool m_Sweep_ContactSheet;
+    int m_Sweep_Columns;
+
     // Background
     bool ParseBackground(QDomElement & mrDomBackground);
 
     QString m_BackgroundType;
     int m_BackgroundSeed;
+
+    // Random values depend on the position only, not on the order they are
+    // generated in, so any part of the frame can be generated on its own
+    bool m_Noise_ByPosition;
     double m_WhiteNoise_Cutoff;
     int m_Checkerboard_Width;
     double m_Gaussian_Sigma;
@@ -62,33 +168,427 @@ private:
     double m_Image_YMax;
     int m_Image_Width;
     int m_Image_Height;
-    QString m_OutputFilename;
+
+    // Region of interest (optional): the image is this part of a virtual
+    // frame of m_Frame_Width x m_Frame_Height pixels, which is never
+    // rendered as a whole. Without one, the frame is the image.
+    bool ParseROI(QDomElement & mrDomROI);
+    void SetROI(const QRect & mcROI);
+    QSize GetFrameSize() const;
+
+    QRect m_ROI;
+    int m_Frame_Width;
+    int m_Frame_Height;
+
+    // Images written by Execute(). All of them are derived from one traced
+    // image at the resolution above: crops are cut out of it, and smaller
+    // sizes are filtered down from it.
+    enum Channel
+    {
+        // Intensity colored by strength (if there is a colormap)
+        Channel_Color,
+
+        // Intensity only, in gray
+        Channel_Intensity,
+
+        // Strength only, through the colormap (gray without one)
+        Channel_Strength
+    };
+    struct Output
+    {
+        QString filename;
+
+        // Part of the traced image, in its pixels (empty: all of it)
+        QRect crop;
+
+        // Size of the file (0: size of the crop)
+        int width = 0;
+        int height = 0;
+
+        Channel channel = Channel_Color;
+    };
+    bool ParseOutput(QDomElement & mrDomOutput);
+
+    QList < Output > m_Outputs;
+
+    // Tile pyramid for pan/zoom viewers (optional)
+    enum PyramidLayout
+    {
+        // <directory>/<z>/<x>/<y>.png; all tiles have the full size
+        PyramidLayout_XYZ,
+
+        // <directory>.dzi and <directory>_files/<level>/<x>_<y>.png; tiles
+        // at the right and bottom edges are smaller
+        PyramidLayout_DeepZoom
+    };
+    bool ParsePyramid(QDomElement & mrDomPyramid);
+
+    QString m_Pyramid_Directory;
+    PyramidLayout m_Pyramid_Layout;
+    int m_Pyramid_TileSize;
+
+    // Configuration as XML, so renderers of tiles can be set up the same
+    // way (only kept for pyramids)
+    QString m_ConfigurationXML;
+
+    // Coloring by strength of the vector field
+    bool ParseColoring(QDomElement & mrDomColoring);
+
+    Colormap * m_Colormap;
+    bool m_Coloring_LogScale;
 
     bool m_IsValid;
 
 public:
-    // Create the LIC image
-    void Execute();
+    // Create the LIC image and save it to the output file
+    bool Execute();
+
+    // Layout of pixels in a caller-owned buffer
+    enum PixelFormat
+    {
+        // Four bytes per pixel: red, green, blue, and 255
+        PixelFormat_RGBX8,
+
+        // Three floats per pixel in [0, 1]: red, green, blue
+        PixelFormat_RGB_Float
+    };
+
+    // Create the LIC image directly in a caller-owned buffer of
+    // GetImageHeight() lines with mStride bytes each. Returns false if
+    // the configuration is incomplete or rendering has been cancelled.
+    bool Render(void * mpBuffer, qsizetype mStride, PixelFormat mFormat);
+
+    // Called with the finished fraction while tracing. Callbacks are called
+    // on the thread that runs Execute() or Render().
+    void SetProgressCallback(std::function < void(double) > mCallback);
+
+    // Asked regularly while tracing; returning true cancels rendering
+    void SetCancelCallback(std::function < bool() > mCallback);
+
+    // Cancel rendering; may be called from any thread
+    void Cancel();
+    bool IsCancelled() const;
 
 private:
+    // Noise and LIC stages shared by Execute() and Render(); only pixels in
+    // mcRect are traced (empty: all of them). Returns false if cancelled.
+    bool RunTracingStages(const QRect & mcRect = QRect());
+
+    // Smallest part of the image all outputs are cut from
+    QRect GetTraceRect() const;
+
+    // Write all outputs from the traced part of the image, normalized over
+    // all of it unless a normalization is given
+    struct Normalization;
+    bool WriteOutputs(const QRect & mcTracedRect,
+        const Normalization * mpNormalization = nullptr);
+
+    // Render every value of the parameter sweep as numbered frames or as
+    // one contact sheet
+    bool ExecuteSweep();
+
+    // Frames of a sweep that are traced together, in groups that fit into
+    // memory
+    int GetSweepGroupSize() const;
+
+    // Render all tiles of the pyramid
+    bool ExecutePyramid();
+
+    // Value of the swept parameter in a frame
+    double GetSweepValue(int mFrame) const;
+
+    // Output file of a frame ("name-0003.png")
+    QString GetFrameFilename(int mFrame) const;
+
+    // Derived figures of the performance report
+    void UpdateDerivedCounters(int mNumImages = 1);
+
+    std::function < void(double) > m_ProgressCallback;
+    std::function < bool() > m_CancelCallback;
+    std::atomic < bool > m_CancelRequested;
+
     // Noise Generator
     void GenerateNoise();
 
+    // Everything the noise and the traced image (of the pixels in mcRect;
+    // empty: all of them) depend on; equal keys mean equal results
+    QString GetNoiseKey() const;
+    QString GetTracingKey(const QRect & mcRect = QRect()) const;
+
+    // Part of the frame the noise planes cover, in the coordinates of the
+    // tracer (y upwards); it may wrap around the edges. Streamlines move by
+    // at most one pixel per step, so a halo of m_Steps pixels around the
+    // image is all the tracer ever reads.
+    QRect GetNoiseWindow() const;
+
     QList < double > m_Noise_R;
     QList < double > m_Noise_G;
     QList < double > m_Noise_B;
 
-    // Generate LIC
-    void GenerateLIC();
-    QPair < double, double > EvaluateVectorfield(double mX, double mY);
+    // Results of earlier runs, if a cache directory is set
+    StageCache m_Cache;
+
+    // Generate LIC for the pixels in mcRect (empty: all of them); returns
+    // false if cancelled
+    bool GenerateLIC(const QRect & mcRect = QRect());
+
+    // Tiles finished by a cancelled GenerateLIC(), so running it again with
+    // the same tracing key only traces the others. The planes they are in
+    // identify them; any other planes invalidate them.
+    QList < bool > m_TilesDone;
+    QString m_TilesDoneKey;
+    const double * m_TilesDonePlane;
+
+    // Finished tiles on disk
+    Checkpoint m_Checkpoint;
+
+    // Planes a traced image is written to, and the value of the swept
+    // parameter for it
+    struct TraceTarget
+    {
+        double * lic_r;
+        double * lic_g;
+        double * lic_b;
+        double * lic_strength;
+        double sweep_value;
+    };
+
+    // Trace the pixels in mcRect (empty: all of them) of one image per
+    // target; every thread works on all of them. Tiles that are true in
+    // mpTilesDone are skipped, and the ones finished are set (single
+    // target only), and mTileFinished is called with them on the thread
+    // that traced them. Returns false if cancelled.
+    bool TraceTargets(const QList < TraceTarget > mcTargets,
+        const QRect & mcRect = QRect(),
+        QList < bool > * mpTilesDone = nullptr,
+        std::function < void(int) > mTileFinished = nullptr);
+
+    // Per-thread state while tracing
+    struct TraceWorkspace
+    {
+        // Variables for evaluating the vector field
+        QHash < QString, double > variables;
+
+        // Formulas of the vector field; a copy on the node of the thread
+        // when threads are pinned
+        const AbstractFunction * vectorfield_x = nullptr;
+        const AbstractFunction * vectorfield_y = nullptr;
+
+        // Where results go
+        double * lic_r = nullptr;
+        double * lic_g = nullptr;
+        double * lic_b = nullptr;
+        double * lic_strength = nullptr;
+
+        // Size of the frame, position of the image in it, and position and
+        // height of the noise window
+        int frame_width = 0;
+        int frame_height = 0;
+        int image_x = 0;
+        int image_y = 0;
+        int noise_x = 0;
+        int noise_y = 0;
+        int noise_height = 0;
+
+        // Counters
+        qint64 field_evaluations = 0;
+        qint64 steps = 0;
+        qint64 singularity_breaks = 0;
+        double length = 0.;
+    };
+    void InitializeWorkspace(TraceWorkspace & mrWorkspace) const;
+
+    // Planes of this object as a target, and how a workspace writes to one
+    TraceTarget GetImageTarget();
+    void SetWorkspaceTarget(TraceWorkspace & mrWorkspace,
+        const TraceTarget & mcTarget) const;
+
+    // Tiles of the image, and the pixels of one that are in mcRect (empty:
+    // the image)
+    int GetNumTiles() const;
+    QRect GetTilePixels(int mTile, const QRect & mcRect) const;
+
+    // Deterministic share of the tiles overlapping mcRect for one of
+    // mNumShards processes
+    QList < int > GetShardTiles(int mShard, int mNumShards,
+        const QRect & mcRect) const;
+
+    // Trace the pixels of a tile that are in mcRect; returns their number.
+    // Stops after the current column if rendering is cancelled.
+    int TraceTile(int mTile, int mNumTilesX, const QRect & mcRect,
+        TraceWorkspace & mrWorkspace);
+
+    // Trace streamlines through one pixel and save its color
+    void TracePixel(int mIX, int mIY, TraceWorkspace & mrWorkspace);
+    QPair < double, double > EvaluateVectorfield(double mX, double mY,
+        QHash < QString, double > & mrVariables) const;
+    QPair < double, double > EvaluateVectorfield(double mX, double mY,
+        TraceWorkspace & mrWorkspace) const;
+
+    // Move the pages of the noise and of the traced planes to the memory
+    // nodes of the threads tracing their columns (multi-socket hosts only)
+    void DistributeNoise();
+    void DistributePlanes();
+    const double * m_DistributedPlane;
 
     QList < double > m_LIC_R;
     QList < double > m_LIC_G;
     QList < double > m_LIC_B;
     QList < double > m_LIC_Strength;
 
-    // Generate Image
-    void GenerateImage();
+    // Values mapped to black and white, and to the ends of the colormap
+    // (after the log scale, if any)
+    struct Normalization
+    {
+        double min_intensity = 1e10;
+        double max_intensity = -1e10;
+        double min_strength = 1e10;
+        double max_strength = -1e10;
+    };
+    Normalization GetNormalization(const QRect & mcRect) const;
+
+    // Normalize, color, and write the pixels in mcRect (empty: all of
+    // them) to a buffer that starts at its top left corner. Normalization
+    // only looks at the pixels in mcRect, unless it is given; values
+    // outside of a given normalization are clamped.
+    void GenerateImage(void * mpBuffer, qsizetype mStride,
+        PixelFormat mFormat, const QRect & mcRect = QRect(),
+        Channel mChannel = Channel_Color,
+        const Normalization * mpNormalization = nullptr) const;
+
+    // Generate image and save it to a file
+    bool SaveImage(const QString mcFilename);
+
+
+
+    // ======================================================= Helper renderers
+private:
+    // What the renderers of batches, the server, watch mode, shards,
+    // pyramids, the autotuner, and the estimator use instead of the
+    // members above.
+
+    // Start a run; clears a cancellation left over from the last one
+    void ResetCancel();
+
+    // Run a stage of a render, timed in the performance report; returns
+    // what the stage returns
+    bool RunStage(const QString mcName, std::function < bool() > mStage);
+
+    // Report of the current run, for stages and counters of their own
+    PerformanceReport & GetMutablePerformanceReport();
+
+    // Noise planes (r, g, b) and traced planes (r, g, b, strength). Get
+    // returns shared copies, so renderers with the same noise or tracing
+    // key can use them without copying; take leaves this renderer without
+    // them, and adopt replaces its own.
+    QList < QList < double > > GetNoisePlanes() const;
+    QList < QList < double > > TakeNoisePlanes();
+    void AdoptNoisePlanes(const QList < QList < double > > & mcPlanes);
+    QList < QList < double > > GetTracedPlanes() const;
+    QList < QList < double > > TakeTracedPlanes();
+    void AdoptTracedPlanes(const QList < QList < double > > & mcPlanes);
+
+    // Traced planes of the size of the image
+    void AllocateTracedPlanes();
+
+    // Region of interest of the frame (empty: none). Setting an empty one
+    // makes the whole frame the image again.
+    QRect GetRegion() const;
+    void SetRegion(const QRect & mcROI);
+
+    // Images written by Execute()
+    QList < Output > GetOutputs() const;
+    void SetOutputs(const QList < Output > & mcOutputs);
+
+    // Images of a sweep, and the size of its contact sheet (empty: frames
+    // are written one by one)
+    int GetSweepCount() const;
+    QSize GetContactSheetSize() const;
+
+    // Tiles are traced by worker processes: that backend is selected, no
+    // pool or scheduler takes precedence, and the host can fork
+    bool UsesWorkerProcesses() const;
+
+
+
+    // ============================================================ Performance
+public:
+    // Timings and counters of the last run
+    const PerformanceReport & GetPerformanceReport() const;
+
+    // How progress is shown while tracing
+    void SetProgressMode(ProgressReporter::Mode mMode);
+    ProgressReporter::Mode GetProgressMode() const;
+
+    // Number of threads used for tracing (0: one per core)
+    void SetNumThreads(int mNumThreads);
+    int GetNumThreads() const;
+
+    // Where tiles are traced: threads of this process, or as many forked
+    // worker processes, for hosts where threads scale badly because they
+    // contend for the allocator or libm. Both give the same pixels; a pool
+    // or scheduler takes precedence over processes.
+    enum Backend
+    {
+        Backend_Threads,
+        Backend_Processes
+    };
+    void SetBackend(Backend mBackend);
+    Backend GetBackend() const;
+
+    // Backend from its command line name ("threads", "processes")
+    static bool BackendFromString(const QString mcName, Backend & mrBackend);
+
+    // Size of the square tiles the image is traced in (default: 64), and
+    // the number of interleaved passes they are traced in (default: 16;
+    // 1: row by row). Neither changes the pixels. All shards of an image
+    // need the same tile size.
+    void SetTileSize(int mTileSize);
+    int GetTileSize() const;
+    void SetTileInterleave(int mTileInterleave);
+    int GetTileInterleave() const;
+
+    // On hosts with several memory nodes (sockets), noise and traced planes
+    // are split into strips of columns, one per node, whose pages are placed
+    // on that node, and threads trace the tiles of their own node first
+    // (default: on). Threads can also be pinned to CPUs (default: off);
+    // then every node has its own copy of the formulas as well.
+    void SetNUMAPlacement(bool mPlacement);
+    void SetPinThreads(bool mPinThreads);
+
+    // Trace with the threads of a pool shared with other renderers instead
+    // of starting threads for every image (nullptr: own threads)
+    void SetThreadPool(ThreadPool * mpThreadPool);
+
+    // Trace tiles with the threads of a scheduler shared with renderers on
+    // other threads, which go to the job with the highest priority (then
+    // the earliest deadline) at every tile; takes precedence over a pool
+    void SetScheduler(TileScheduler * mpScheduler);
+    void SetPriority(int mPriority,
+        const QDeadlineTimer & mcDeadline = QDeadlineTimer::Forever);
+
+    // Keep noise and traced images in this directory and reuse them when
+    // their inputs haven't changed (empty: don't)
+    void SetCacheDirectory(const QString mcDirectory);
+
+    // Keep finished tiles in a file while tracing, so a run that is killed
+    // can be resumed with the same file (empty: don't). The file is removed
+    // when the image is complete.
+    void SetCheckpoint(const QString mcFilename, bool mResume);
+
+private:
+    PerformanceReport m_PerformanceReport;
+    ProgressReporter::Mode m_ProgressMode;
+    int m_NumThreads;
+    Backend m_Backend;
+    int m_TileSize;
+    int m_TileInterleave;
+    bool m_NUMAPlacement;
+    bool m_PinThreads;
+    ThreadPool * m_ThreadPool;
+    TileScheduler * m_Scheduler;
+    int m_Priority;
+    QDeadlineTimer m_Deadline;
 };
 
 #endif
@@ -0,0 +1,296 @@
+// NumaTopology.cpp
+// Class implementation
+
+// Project includes
+#include "NumaTopology.h"
+
+// Qt includes
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+
+// System includes
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+
+// Pages are touched again in pieces of this size, so the copy they are kept
+// in meanwhile stays small
+static const qint64 TOUCH_CHUNK_BYTES = qint64(2) << 20;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+NumaTopology::NumaTopology()
+{
+#if defined(__linux__)
+    // One directory per node; nodes without CPUs only have memory
+    const QDir directory("/sys/devices/system/node");
+    const QRegularExpression node_format("^node([0-9]+)$");
+    QList < QPair < int, QList < int > > > nodes;
+    for (const QString & entry : directory.entryList(QDir::Dirs))
+    {
+        const QRegularExpressionMatch match = node_format.match(entry);
+        if (!match.hasMatch())
+        {
+            continue;
+        }
+        QFile file(directory.filePath(entry + "/cpulist"));
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            continue;
+        }
+
+        // Ranges of CPUs ("0-15,32-47")
+        QList < int > cpus;
+        const QString cpu_list = QString::fromLatin1(file.readAll()).trimmed();
+        for (const QString & range : cpu_list.split(',', Qt::SkipEmptyParts))
+        {
+            const QStringList ends = range.split('-');
+            const int first = ends.first().toInt();
+            const int last = ends.last().toInt();
+            for (int cpu = first; cpu <= last; cpu++)
+            {
+                cpus << cpu;
+            }
+        }
+        if (!cpus.isEmpty())
+        {
+            nodes << QPair < int, QList < int > >(match.captured(1).toInt(),
+                cpus);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end(),
+        [](const QPair < int, QList < int > > & mcA,
+            const QPair < int, QList < int > > & mcB)
+        {
+            return mcA.first < mcB.first;
+        });
+    for (const QPair < int, QList < int > > & node : nodes)
+    {
+        for (int cpu : node.second)
+        {
+            m_NodeOfCPU[cpu] = m_NodeCPUs.size();
+        }
+        m_NodeCPUs << node.second;
+    }
+#endif
+
+    // Unknown: one node
+    if (m_NodeCPUs.isEmpty())
+    {
+        QList < int > cpus;
+        for (int cpu = 0; cpu < QThread::idealThreadCount(); cpu++)
+        {
+            cpus << cpu;
+            m_NodeOfCPU[cpu] = 0;
+        }
+        m_NodeCPUs << cpus;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+NumaTopology::~NumaTopology()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Nodes of this host
+const NumaTopology & NumaTopology::GetHost()
+{
+    static const NumaTopology host;
+    return host;
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of nodes
+int NumaTopology::GetNumNodes() const
+{
+    return m_NodeCPUs.size();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Node of the CPU the calling thread runs on
+int NumaTopology::GetCurrentNode() const
+{
+#if defined(__linux__)
+    return m_NodeOfCPU.value(sched_getcpu(), 0);
+#else
+    return 0;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Node of a pinned thread
+int NumaTopology::GetNodeOfThread(int mThreadIdx) const
+{
+    return mThreadIdx % m_NodeCPUs.size();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CPU of a pinned thread
+int NumaTopology::GetCPUOfThread(int mThreadIdx) const
+{
+    const QList < int > & cpus = m_NodeCPUs[GetNodeOfThread(mThreadIdx)];
+    return cpus[(mThreadIdx / m_NodeCPUs.size()) % cpus.size()];
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pin the calling thread to one CPU
+bool NumaTopology::PinThread(int mThreadIdx) const
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(GetCPUOfThread(mThreadIdx), &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    Q_UNUSED(mThreadIdx);
+    return false;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pin the calling thread to the CPUs of a node
+bool NumaTopology::PinToNode(int mNode) const
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : m_NodeCPUs[mNode])
+    {
+        CPU_SET(cpu, &cpus);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+#else
+    Q_UNUSED(mNode);
+    return false;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Node owning a column
+int NumaTopology::GetNodeOfColumn(int mColumn, int mNumColumns,
+    int mNumNodes)
+{
+    return int(qint64(mColumn) * mNumNodes / mNumColumns);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Move the pages of buffers to the nodes owning their columns
+void NumaTopology::DistributeColumns(const QList < double * > & mcBuffers,
+    qint64 mColumnSize, int mNumColumns) const
+{
+    const int num_nodes = GetNumNodes();
+    if (num_nodes < 2 ||
+        mNumColumns < 1)
+    {
+        return;
+    }
+
+    // One thread per node touches the strip of columns of its node
+    std::vector < std::thread > threads;
+    for (int node = 0; node < num_nodes; node++)
+    {
+        threads.emplace_back(
+            [this, &mcBuffers, mColumnSize, mNumColumns, num_nodes, node]()
+            {
+                if (!PinToNode(node))
+                {
+                    return;
+                }
+                const qint64 first_column =
+                    (qint64(node) * mNumColumns + num_nodes - 1) / num_nodes;
+                const qint64 end_column =
+                    (qint64(node + 1) * mNumColumns + num_nodes - 1) /
+                        num_nodes;
+                for (double * buffer : mcBuffers)
+                {
+                    TouchAgain(buffer + first_column * mColumnSize,
+                        (end_column - first_column) * mColumnSize);
+                }
+            });
+    }
+    for (std::thread & thread : threads)
+    {
+        thread.join();
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Touch whole pages in a range again for the first time
+void NumaTopology::TouchAgain(double * mpData, qint64 mSize)
+{
+#if defined(__linux__)
+    // Only whole pages; pages at the ends of a strip are shared with the
+    // next node and stay where they are
+    const quintptr page_size = quintptr(sysconf(_SC_PAGESIZE));
+    const quintptr begin = (reinterpret_cast < quintptr >(mpData) +
+        page_size - 1) / page_size * page_size;
+    const quintptr end = reinterpret_cast < quintptr >(mpData + mSize) /
+        page_size * page_size;
+    if (end <= begin)
+    {
+        return;
+    }
+
+    // Released pages come back zeroed on the next touch, from the node of
+    // the touching thread; the values are put back from a copy
+    std::vector < char > copy(size_t(qMin(qint64(end - begin),
+        TOUCH_CHUNK_BYTES)));
+    for (quintptr chunk = begin; chunk < end; chunk += copy.size())
+    {
+        char * data = reinterpret_cast < char * >(chunk);
+        const size_t size = size_t(qMin(quintptr(copy.size()), end - chunk));
+        memcpy(copy.data(), data, size);
+        madvise(data, size, MADV_DONTNEED);
+        memcpy(data, copy.data(), size);
+    }
+#else
+    Q_UNUSED(mpData);
+    Q_UNUSED(mSize);
+#endif
+}
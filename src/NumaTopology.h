@@ -0,0 +1,68 @@
+// NumaTopology.h
+// Class definition
+
+#ifndef NUMATOPOLOGY_H
+#define NUMATOPOLOGY_H
+
+// Qt includes
+#include <QHash>
+#include <QList>
+
+
+
+// Define class
+class NumaTopology
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; reads the memory nodes of this host and their CPUs. Where
+    // that isn't possible, there is one node with all CPUs.
+    NumaTopology();
+
+    // Destructor
+    virtual ~NumaTopology();
+
+    // Nodes of this host, read once
+    static const NumaTopology & GetHost();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Number of nodes
+    int GetNumNodes() const;
+
+    // Node of the CPU the calling thread runs on right now
+    int GetCurrentNode() const;
+
+    // Node and CPU of thread mThreadIdx when threads are pinned; consecutive
+    // threads go to different nodes, so a few threads use all of them
+    int GetNodeOfThread(int mThreadIdx) const;
+    int GetCPUOfThread(int mThreadIdx) const;
+
+    // Pin the calling thread to the CPU of thread mThreadIdx, or to all
+    // CPUs of a node
+    bool PinThread(int mThreadIdx) const;
+    bool PinToNode(int mNode) const;
+
+    // Node that owns a column of a column-major buffer; the columns are
+    // split into one strip per node
+    static int GetNodeOfColumn(int mColumn, int mNumColumns, int mNumNodes);
+
+    // Move the pages of column-major buffers (mColumnSize values per
+    // column) to the nodes owning their columns. Every page is touched
+    // again for the first time by a thread on its node; the values are
+    // kept. Nothing else may use the buffers meanwhile.
+    void DistributeColumns(const QList < double * > & mcBuffers,
+        qint64 mColumnSize, int mNumColumns) const;
+
+private:
+    // Let the calling thread touch the whole pages in a range again for the
+    // first time
+    static void TouchAgain(double * mpData, qint64 mSize);
+
+    QList < QList < int > > m_NodeCPUs;
+    QHash < int, int > m_NodeOfCPU;
+};
+
+#endif
@@ -0,0 +1,307 @@
+// PerformanceReport.cpp
+// Class implementation
+
+// Project includes
+#include "AllocationCounter.h"
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "PerformanceReport.h"
+
+// Qt includes
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+// System includes
+#include <sys/resource.h>
+
+
+
+// Version of the JSON layout; increase when fields change meaning
+static const int REPORT_SCHEMA_VERSION = 2;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+PerformanceReport::PerformanceReport()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+PerformanceReport::~PerformanceReport()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Forget all stages, counters, and information
+void PerformanceReport::Clear()
+{
+    m_Stages.clear();
+    m_Counters.clear();
+    m_Info = QJsonObject();
+}
+
+
+
+// ===================================================================== Stages
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Start timing a stage of the pipeline
+void PerformanceReport::StartStage(const QString mcName)
+{
+    Stage stage;
+    stage.name = mcName;
+    stage.wall_seconds = 0.;
+    stage.cpu_seconds = 0.;
+    stage.peak_rss_bytes = 0;
+    stage.allocations = 0;
+    stage.depth = 0;
+    for (const Stage & other_stage : m_Stages)
+    {
+        if (other_stage.running)
+        {
+            stage.depth++;
+        }
+    }
+    stage.running = true;
+    stage.allocations_start = AllocationCounter::GetTotalAllocations();
+    stage.cpu_start = GetProcessCPUTime();
+    stage.wall_timer.start();
+    m_Stages << stage;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// End timing a stage of the pipeline
+void PerformanceReport::EndStage(const QString mcName)
+{
+    // Most recent running stage of that name (stages may be run more than
+    // once)
+    for (int idx = m_Stages.size() - 1; idx >= 0; idx--)
+    {
+        Stage & stage = m_Stages[idx];
+        if (stage.name != mcName ||
+            !stage.running)
+        {
+            continue;
+        }
+        stage.running = false;
+        stage.wall_seconds = stage.wall_timer.nsecsElapsed() * 1e-9;
+        stage.cpu_seconds = GetProcessCPUTime() - stage.cpu_start;
+        stage.peak_rss_bytes = GetPeakRSS();
+        stage.allocations =
+            AllocationCounter::GetTotalAllocations() - stage.allocations_start;
+        return;
+    }
+
+    MessageLogger::Error(METHOD_NAME,
+        QString("Stage \"%1\" is not running.").arg(mcName));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Measures a stage for as long as it exists
+PerformanceReport::StageTimer::StageTimer(PerformanceReport & mrReport,
+    const QString mcName) :
+    m_Report(mrReport),
+    m_Name(mcName)
+{
+    m_Report.StartStage(m_Name);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Measures a stage for as long as it exists
+PerformanceReport::StageTimer::~StageTimer()
+{
+    m_Report.EndStage(m_Name);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Wall clock time of a stage
+double PerformanceReport::GetWallTime(const QString mcName) const
+{
+    double wall_seconds = -1.;
+    for (const Stage & stage : m_Stages)
+    {
+        if (stage.name == mcName)
+        {
+            wall_seconds = qMax(wall_seconds, 0.) + stage.wall_seconds;
+        }
+    }
+    return wall_seconds;
+}
+
+
+
+// =================================================================== Counters
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Set a counter
+void PerformanceReport::SetCounter(const QString mcName, double mValue)
+{
+    m_Counters[mcName] = mValue;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Increase a counter
+void PerformanceReport::AddToCounter(const QString mcName, double mValue)
+{
+    m_Counters[mcName] += mValue;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Get a counter
+double PerformanceReport::GetCounter(const QString mcName) const
+{
+    return m_Counters.value(mcName, 0.);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Descriptive information
+void PerformanceReport::SetInfo(const QString mcName,
+    const QJsonValue mcValue)
+{
+    m_Info[mcName] = mcValue;
+}
+
+
+
+// ============================================================== Serialization
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Complete report as JSON
+QJsonObject PerformanceReport::ToJSON() const
+{
+    QJsonObject json;
+    json["schema"] = "lic-performance-report";
+    json["schema_version"] = REPORT_SCHEMA_VERSION;
+    json["timestamp"] =
+        QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["info"] = m_Info;
+
+    // Stages in the order they have been started; nested stages are part
+    // of the time of the stages they are in, so only the outermost ones
+    // count towards the totals
+    QJsonArray stages;
+    double total_wall_seconds = 0.;
+    double total_cpu_seconds = 0.;
+    for (const Stage & stage : m_Stages)
+    {
+        QJsonObject json_stage;
+        json_stage["name"] = stage.name;
+        json_stage["wall_seconds"] = stage.wall_seconds;
+        json_stage["cpu_seconds"] = stage.cpu_seconds;
+        json_stage["depth"] = stage.depth;
+        json_stage["peak_rss_bytes"] = stage.peak_rss_bytes;
+        if (AllocationCounter::IsEnabled())
+        {
+            json_stage["allocations"] = stage.allocations;
+        }
+        stages.append(json_stage);
+        if (stage.depth == 0)
+        {
+            total_wall_seconds += stage.wall_seconds;
+            total_cpu_seconds += stage.cpu_seconds;
+        }
+    }
+    json["stages"] = stages;
+    json["total_wall_seconds"] = total_wall_seconds;
+    json["total_cpu_seconds"] = total_cpu_seconds;
+    json["peak_rss_bytes"] = GetPeakRSS();
+
+    // Counters
+    QJsonObject counters;
+    for (auto counter_iterator = m_Counters.constBegin();
+         counter_iterator != m_Counters.constEnd();
+         counter_iterator++)
+    {
+        counters[counter_iterator.key()] = counter_iterator.value();
+    }
+    json["counters"] = counters;
+
+    return json;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write report to file
+bool PerformanceReport::WriteJSON(const QString mcFilename) const
+{
+    QFile output_file(mcFilename);
+    if (!output_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Report file \"%1\" could not be written.")
+                .arg(mcFilename));
+        return false;
+    }
+    output_file.write(QJsonDocument(ToJSON()).toJson(QJsonDocument::Indented));
+    output_file.close();
+    return true;
+}
+
+
+
+// ============================================================ Process metrics
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CPU time (user + system) of the whole process
+double PerformanceReport::GetProcessCPUTime()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Peak resident set size of the process
+qint64 PerformanceReport::GetPeakRSS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    // macOS reports bytes...
+    return qint64(usage.ru_maxrss);
+#else
+    // ...everybody else kilobytes
+    return qint64(usage.ru_maxrss) * 1024;
+#endif
+}
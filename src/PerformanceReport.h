@@ -0,0 +1,113 @@
+// PerformanceReport.h
+// Class definition
+
+#ifndef PERFORMANCEREPORT_H
+#define PERFORMANCEREPORT_H
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QString>
+
+
+
+// Define class
+class PerformanceReport
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    PerformanceReport();
+
+    // Destructor
+    virtual ~PerformanceReport();
+
+    // Forget all stages, counters, and information
+    void Clear();
+
+
+
+    // ================================================================= Stages
+public:
+    // Start/end timing a stage of the pipeline; stages started while
+    // another one is running are nested in it
+    void StartStage(const QString mcName);
+    void EndStage(const QString mcName);
+
+    // Measures a stage for as long as it exists
+    class StageTimer
+    {
+    public:
+        StageTimer(PerformanceReport & mrReport, const QString mcName);
+        ~StageTimer();
+
+    private:
+        PerformanceReport & m_Report;
+        QString m_Name;
+    };
+
+    // Wall clock time of a stage (seconds); -1 if stage is unknown
+    double GetWallTime(const QString mcName) const;
+
+private:
+    struct Stage
+    {
+        QString name;
+        double wall_seconds;
+        double cpu_seconds;
+        qint64 peak_rss_bytes;
+        qint64 allocations;
+
+        // Number of stages it is nested in; totals only add up the
+        // outermost ones, which contain the others
+        int depth;
+
+        // While the stage is running
+        bool running;
+        QElapsedTimer wall_timer;
+        double cpu_start;
+        qint64 allocations_start;
+    };
+    QList < Stage > m_Stages;
+
+
+
+    // =============================================================== Counters
+public:
+    // Set/increase a counter
+    void SetCounter(const QString mcName, double mValue);
+    void AddToCounter(const QString mcName, double mValue);
+    double GetCounter(const QString mcName) const;
+
+    // Descriptive information (configuration file, image size...)
+    void SetInfo(const QString mcName, const QJsonValue mcValue);
+
+private:
+    QHash < QString, double > m_Counters;
+    QJsonObject m_Info;
+
+
+
+    // ========================================================== Serialization
+public:
+    // Complete report as JSON
+    QJsonObject ToJSON() const;
+
+    // Write report to file
+    bool WriteJSON(const QString mcFilename) const;
+
+
+
+    // ======================================================== Process metrics
+public:
+    // CPU time (user + system) of the whole process in seconds
+    static double GetProcessCPUTime();
+
+    // Peak resident set size of the process in bytes
+    static qint64 GetPeakRSS();
+};
+
+#endif
@@ -0,0 +1,206 @@
+// ProcessPool.cpp
+// Class implementation
+
+// Project includes
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "ProcessPool.h"
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QString>
+
+// System includes
+#include <chrono>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+
+
+// How often exited workers are looked for while waiting
+static const int POLL_INTERVAL_MS = 2;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+ProcessPool::ProcessPool(int mNumProcesses)
+{
+    m_NumProcesses = mNumProcesses;
+    m_NumFailed = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+ProcessPool::~ProcessPool()
+{
+    Kill();
+#if defined(__unix__) || defined(__APPLE__)
+    for (const QPair < void *, qint64 > & memory : m_SharedMemory)
+    {
+        munmap(memory.first, size_t(memory.second));
+    }
+#endif
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Worker processes can be forked
+bool ProcessPool::IsAvailable()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of worker processes
+int ProcessPool::GetNumProcesses() const
+{
+    return m_NumProcesses;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory shared with the workers
+void * ProcessPool::AllocateShared(qint64 mSize)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    // Anonymous pages are zeroed, and only use memory once written
+    void * memory = mmap(nullptr, size_t(mSize), PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("%1 bytes of shared memory could not be mapped.")
+                .arg(QString::number(mSize)));
+        return nullptr;
+    }
+    m_SharedMemory << QPair < void *, qint64 >(memory, mSize);
+    return memory;
+#else
+    Q_UNUSED(mSize);
+    return nullptr;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Fork the workers
+bool ProcessPool::Start(std::function < void(int) > mTask)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    for (int process_idx = 0; process_idx < m_NumProcesses; process_idx++)
+    {
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            // Only the forking thread exists in the worker; it must not
+            // run destructors or handlers of this process on exit
+            mTask(process_idx);
+            _exit(0);
+        }
+        if (pid < 0)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Worker %1 could not be started.")
+                    .arg(QString::number(process_idx)));
+            Kill();
+            return false;
+        }
+        m_RunningPIDs << qint64(pid);
+    }
+    return true;
+#else
+    Q_UNUSED(mTask);
+    MessageLogger::Error(METHOD_NAME,
+        "Worker processes are not available on this system.");
+    return false;
+#endif
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Wait for workers to exit
+int ProcessPool::Wait(int mTimeoutMS)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    QElapsedTimer timer;
+    timer.start();
+    while (true)
+    {
+        for (int pid_idx = m_RunningPIDs.size() - 1; pid_idx >= 0; pid_idx--)
+        {
+            int status = 0;
+            const pid_t pid = pid_t(m_RunningPIDs[pid_idx]);
+            if (waitpid(pid, &status, WNOHANG) == pid)
+            {
+                if (!WIFEXITED(status) ||
+                    WEXITSTATUS(status) != 0)
+                {
+                    m_NumFailed++;
+                }
+                m_RunningPIDs.removeAt(pid_idx);
+            }
+        }
+        if (m_RunningPIDs.isEmpty() ||
+            timer.elapsed() >= mTimeoutMS)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(POLL_INTERVAL_MS));
+    }
+#else
+    Q_UNUSED(mTimeoutMS);
+#endif
+    return m_RunningPIDs.size();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Stop workers that are still running
+void ProcessPool::Kill()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    for (qint64 pid : m_RunningPIDs)
+    {
+        kill(pid_t(pid), SIGKILL);
+        waitpid(pid_t(pid), nullptr, 0);
+    }
+#endif
+    m_RunningPIDs.clear();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Workers that crashed or were killed
+int ProcessPool::GetNumFailed() const
+{
+    return m_NumFailed;
+}
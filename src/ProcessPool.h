@@ -0,0 +1,66 @@
+// ProcessPool.h
+// Class definition
+
+#ifndef PROCESSPOOL_H
+#define PROCESSPOOL_H
+
+// Qt includes
+#include <QList>
+#include <QPair>
+
+// System includes
+#include <functional>
+
+
+
+// Define class
+class ProcessPool
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; nothing is started until Start()
+    ProcessPool(int mNumProcesses);
+
+    // Destructor; kills workers that are still running and unmaps the
+    // shared memory
+    virtual ~ProcessPool();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Worker processes can be forked on this system
+    static bool IsAvailable();
+
+    // Number of worker processes
+    int GetNumProcesses() const;
+
+    // Zeroed memory that this process and the workers write to; it must be
+    // allocated before the workers are started, and stays mapped until the
+    // pool is destroyed (nullptr: not possible)
+    void * AllocateShared(qint64 mSize);
+
+    // Fork the workers; every one calls mTask with its index (0, 1, ...)
+    // and exits. Everything else of this process is seen by the workers as
+    // it was when they were forked, sharing the pages until either side
+    // writes to them.
+    bool Start(std::function < void(int) > mTask);
+
+    // Wait up to mTimeoutMS for workers to exit; returns the number of
+    // workers still running
+    int Wait(int mTimeoutMS);
+
+    // Workers that crashed or were killed
+    int GetNumFailed() const;
+
+private:
+    // Stop workers that are still running
+    void Kill();
+
+    int m_NumProcesses;
+    QList < qint64 > m_RunningPIDs;
+    int m_NumFailed;
+    QList < QPair < void *, qint64 > > m_SharedMemory;
+};
+
+#endif
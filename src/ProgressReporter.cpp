@@ -0,0 +1,244 @@
+// ProgressReporter.cpp
+// Class implementation
+
+// Project includes
+#include "ProgressReporter.h"
+
+// Qt includes
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// System includes
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+
+
+// Interval between two samples
+static const int SAMPLE_INTERVAL_MS = 500;
+
+// Width of the progress bar in characters
+static const int BAR_WIDTH = 40;
+
+// Weight of the most recent sample in the smoothed rate
+static const double RATE_SMOOTHING = 0.3;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+ProgressReporter::ProgressReporter(Mode mMode, const QString mcStage,
+    qint64 mTotalWork) :
+    m_WorkDone(0),
+    m_CostDone(0)
+{
+    m_Mode = mMode;
+    m_Stage = mcStage;
+    m_TotalWork = qMax(mTotalWork, qint64(1));
+    m_LastSampleTime = 0.;
+    m_LastSampleCost = 0;
+    m_CostRate = 0.;
+    m_StopRequested = false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+ProgressReporter::~ProgressReporter()
+{
+    Stop();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Mode from its command line name
+bool ProgressReporter::ModeFromString(const QString mcName, Mode & mrMode)
+{
+    if (mcName == "quiet")
+    {
+        mrMode = Mode_Quiet;
+        return true;
+    }
+    if (mcName == "bar")
+    {
+        mrMode = Mode_Bar;
+        return true;
+    }
+    if (mcName == "json")
+    {
+        mrMode = Mode_JSON;
+        return true;
+    }
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Default mode
+ProgressReporter::Mode ProgressReporter::GetDefaultMode()
+{
+    return (isatty(fileno(stderr)) ? Mode_Bar : Mode_Quiet);
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Start the reporter thread
+void ProgressReporter::Start()
+{
+    m_Timer.start();
+    if (m_Mode == Mode_Quiet)
+    {
+        // No need for a thread at all
+        return;
+    }
+    m_StopRequested = false;
+    m_Thread = std::thread(&ProgressReporter::Run, this);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Stop the reporter thread
+void ProgressReporter::Stop()
+{
+    if (!m_Thread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        m_StopRequested = true;
+    }
+    m_Condition.notify_all();
+    m_Thread.join();
+
+    // Final state
+    Sample(true);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Reporter thread
+void ProgressReporter::Run()
+{
+    std::unique_lock < std::mutex > lock(m_Mutex);
+    while (!m_StopRequested)
+    {
+        m_Condition.wait_for(lock,
+            std::chrono::milliseconds(SAMPLE_INTERVAL_MS));
+        if (m_StopRequested)
+        {
+            break;
+        }
+        Sample(false);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Take a sample of the counters and show it
+void ProgressReporter::Sample(bool mIsFinal)
+{
+    const double now = m_Timer.nsecsElapsed() * 1e-9;
+    const qint64 work_done = m_WorkDone.load(std::memory_order_relaxed);
+    const qint64 cost_done = m_CostDone.load(std::memory_order_relaxed);
+    const double fraction = double(work_done) / m_TotalWork;
+
+    // Rate of cost (streamline steps per second), smoothed so a single
+    // expensive region does not make the estimate jump around
+    if (now > m_LastSampleTime)
+    {
+        const double rate =
+            (cost_done - m_LastSampleCost) / (now - m_LastSampleTime);
+        m_CostRate = (m_CostRate > 0. ?
+            RATE_SMOOTHING * rate + (1. - RATE_SMOOTHING) * m_CostRate :
+            rate);
+        m_LastSampleTime = now;
+        m_LastSampleCost = cost_done;
+    }
+
+    // Remaining time. The cost per pixel differs a lot between regions
+    // (singularities break streamlines early); since work is handed out in
+    // an interleaved order, the cost per pixel seen so far is representative
+    // for the pixels still to come.
+    double remaining = -1.;
+    if (work_done > 0 &&
+        m_CostRate > 0.)
+    {
+        const double cost_per_work = double(cost_done) / work_done;
+        const double remaining_cost =
+            cost_per_work * (m_TotalWork - work_done);
+        remaining = remaining_cost / m_CostRate;
+    }
+    if (mIsFinal)
+    {
+        remaining = 0.;
+    }
+
+    // Show
+    if (m_Mode == Mode_Bar)
+    {
+        const int filled = qBound(0, int(fraction * BAR_WIDTH), BAR_WIDTH);
+        const QString bar = QString(filled, QChar('#')) +
+            QString(BAR_WIDTH - filled, QChar('-'));
+        const QString line = QString("\r%1 [%2] %3% - elapsed %4, "
+            "remaining %5")
+            .arg(m_Stage,
+                 bar,
+                 QString::number(100. * fraction, 'f', 1),
+                 FormatTime(now),
+                 remaining >= 0. ? FormatTime(remaining) : QString("---"));
+        fputs(line.toLocal8Bit().constData(), stderr);
+        if (mIsFinal)
+        {
+            fputs("\n", stderr);
+        }
+        fflush(stderr);
+    }
+    if (m_Mode == Mode_JSON)
+    {
+        QJsonObject json;
+        json["stage"] = m_Stage;
+        json["done"] = work_done;
+        json["total"] = m_TotalWork;
+        json["fraction"] = fraction;
+        json["elapsed_seconds"] = now;
+        json["remaining_seconds"] = remaining;
+        json["steps_per_second"] = m_CostRate;
+        json["final"] = mIsFinal;
+        const QByteArray line =
+            QJsonDocument(json).toJson(QJsonDocument::Compact);
+        fwrite(line.constData(), 1, line.size(), stdout);
+        fputs("\n", stdout);
+        fflush(stdout);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Format seconds as hh:mm:ss
+QString ProgressReporter::FormatTime(double mSeconds)
+{
+    const int seconds = int(mSeconds);
+    return QString("%1:%2:%3")
+        .arg(seconds/3600, 2, 10, QChar('0'))
+        .arg(seconds%3600/60, 2, 10, QChar('0'))
+        .arg(seconds%60, 2, 10, QChar('0'));
+}
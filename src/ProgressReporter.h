@@ -0,0 +1,90 @@
+// ProgressReporter.h
+// Class definition
+
+#ifndef PROGRESSREPORTER_H
+#define PROGRESSREPORTER_H
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QString>
+
+// System includes
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+
+// Define class
+class ProgressReporter
+{
+    // ============================================================== Lifecycle
+public:
+    // How progress is shown
+    enum Mode
+    {
+        Mode_Quiet,
+        Mode_Bar,
+        Mode_JSON
+    };
+
+    // Constructor
+    ProgressReporter(Mode mMode, const QString mcStage, qint64 mTotalWork);
+
+    // Destructor
+    virtual ~ProgressReporter();
+
+    // Mode from its command line name ("quiet", "bar", "json")
+    static bool ModeFromString(const QString mcName, Mode & mrMode);
+
+    // Default mode: a progress bar if stderr is a terminal, quiet otherwise
+    static Mode GetDefaultMode();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Start/stop the reporter thread
+    void Start();
+    void Stop();
+
+    // Report finished work (pixels) and its cost (streamline steps). This is
+    // called from the tracing loop and only touches atomic counters.
+    void AddWork(qint64 mWork, qint64 mCost)
+    {
+        m_WorkDone.fetch_add(mWork, std::memory_order_relaxed);
+        m_CostDone.fetch_add(mCost, std::memory_order_relaxed);
+    }
+
+    // Format seconds as hh:mm:ss
+    static QString FormatTime(double mSeconds);
+
+private:
+    // Reporter thread
+    void Run();
+
+    // Take a sample of the counters and show it
+    void Sample(bool mIsFinal);
+
+    Mode m_Mode;
+    QString m_Stage;
+    qint64 m_TotalWork;
+
+    std::atomic < qint64 > m_WorkDone;
+    std::atomic < qint64 > m_CostDone;
+
+    // Sampling state
+    QElapsedTimer m_Timer;
+    double m_LastSampleTime;
+    qint64 m_LastSampleCost;
+    double m_CostRate;
+
+    // Thread
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_StopRequested;
+};
+
+#endif
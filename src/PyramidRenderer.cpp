@@ -0,0 +1,495 @@
+// PyramidRenderer.cpp
+// Class implementation
+
+// Project includes
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "PyramidRenderer.h"
+
+// Qt includes
+#include <QColor>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QTextStream>
+
+// System includes
+#include <thread>
+#include <vector>
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+PyramidRenderer::PyramidRenderer(LIC * mpLIC) :
+    m_PixelsDone(0)
+{
+    m_LIC = mpLIC;
+    m_BaseLevel = 0;
+    m_Progress = nullptr;
+    m_TotalPixels = 0;
+    m_TilesRendered = 0;
+    m_TilesSkipped = 0;
+    m_FieldEvaluations = 0.;
+    m_Steps = 0.;
+    m_Length = 0.;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+PyramidRenderer::~PyramidRenderer()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render all tiles that don't exist yet
+bool PyramidRenderer::Execute()
+{
+    if (!PlanLevels())
+    {
+        return false;
+    }
+    if (m_LIC -> m_Pyramid_Layout == LIC::PyramidLayout_DeepZoom &&
+        !WriteDescriptor())
+    {
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    m_LIC -> ResetCancel();
+    PerformanceReport & report = m_LIC -> GetMutablePerformanceReport();
+    report.StartStage("GeneratePyramid");
+
+    // Every tile is only a few tracing tiles, so tiles are rendered in
+    // parallel, each one by a single thread
+    m_TotalPixels = 0;
+    for (int level_idx = m_BaseLevel; level_idx < m_Levels.size();
+         level_idx++)
+    {
+        m_TotalPixels += qint64(m_Levels[level_idx].width) *
+            m_Levels[level_idx].height;
+    }
+    ProgressReporter progress(m_LIC -> m_ProgressMode, "GeneratePyramid",
+        m_TotalPixels);
+    m_Progress = &progress;
+    progress.Start();
+
+    // === Base level: the whole frame in one tile. Its strength range is
+    // used on all levels, so colors stay the same when zooming.
+    LIC base_renderer;
+    const Tile base_tile = { m_BaseLevel, 0, 0 };
+    bool success = SetUpRenderer(base_renderer, m_LIC -> GetNumThreads()) &&
+        TraceTile(base_renderer, base_tile);
+    if (success)
+    {
+        m_Levels[m_BaseLevel].normalization =
+            base_renderer.GetNormalization(QRect());
+        if (QFile::exists(GetTileFilename(base_tile)))
+        {
+            m_TilesSkipped++;
+        } else
+        {
+            success = SaveTile(base_renderer, base_tile);
+        }
+        success = SaveSmallLevels(base_renderer) && success;
+    }
+
+    // === Center tile of every other level: intensity is normalized per
+    // level (longer streaks are smoother), but the same for all of its
+    // tiles, so there are no seams
+    QList < Tile > center_tiles;
+    for (int level_idx = m_BaseLevel + 1; level_idx < m_Levels.size();
+         level_idx++)
+    {
+        const Level & level = m_Levels[level_idx];
+        center_tiles << Tile({ level_idx, level.num_columns / 2,
+            level.num_rows / 2 });
+    }
+    const LIC::Normalization base_normalization =
+        m_Levels[m_BaseLevel].normalization;
+    success = success && RenderTiles(center_tiles,
+        [this, &base_normalization](LIC & mrRenderer, const Tile & mcTile)
+        {
+            if (!TraceTile(mrRenderer, mcTile))
+            {
+                return false;
+            }
+            LIC::Normalization normalization =
+                mrRenderer.GetNormalization(QRect());
+            normalization.min_strength = base_normalization.min_strength;
+            normalization.max_strength = base_normalization.max_strength;
+            {
+                std::lock_guard < std::mutex > lock(m_Mutex);
+                m_Levels[mcTile.level].normalization = normalization;
+            }
+            if (QFile::exists(GetTileFilename(mcTile)))
+            {
+                std::lock_guard < std::mutex > lock(m_Mutex);
+                m_TilesSkipped++;
+                return true;
+            }
+            return SaveTile(mrRenderer, mcTile);
+        });
+
+    // === All other tiles; the ones that exist already are skipped, so an
+    // interrupted pyramid is completed by running again
+    QList < Tile > tiles;
+    for (int level_idx = m_BaseLevel + 1; level_idx < m_Levels.size();
+         level_idx++)
+    {
+        const Level & level = m_Levels[level_idx];
+        for (int row = 0; row < level.num_rows; row++)
+        {
+            for (int column = 0; column < level.num_columns; column++)
+            {
+                if (column != level.num_columns / 2 ||
+                    row != level.num_rows / 2)
+                {
+                    tiles << Tile({ level_idx, column, row });
+                }
+            }
+        }
+    }
+    success = success && RenderTiles(tiles,
+        [this](LIC & mrRenderer, const Tile & mcTile)
+        {
+            if (QFile::exists(GetTileFilename(mcTile)))
+            {
+                const QRect frame(0, 0, m_Levels[mcTile.level].width,
+                    m_Levels[mcTile.level].height);
+                const int tile_size = m_LIC -> m_Pyramid_TileSize;
+                const QRect tile = QRect(mcTile.column * tile_size,
+                    mcTile.row * tile_size, tile_size, tile_size)
+                        .intersected(frame);
+                m_PixelsDone += qint64(tile.width()) * tile.height();
+                m_Progress -> AddWork(qint64(tile.width()) * tile.height(),
+                    0);
+                std::lock_guard < std::mutex > lock(m_Mutex);
+                m_TilesSkipped++;
+                return true;
+            }
+            return TraceTile(mrRenderer, mcTile) &&
+                SaveTile(mrRenderer, mcTile);
+        });
+    progress.Stop();
+    m_Progress = nullptr;
+    report.EndStage("GeneratePyramid");
+
+    // Figures of all tiles
+    const double seconds = timer.nsecsElapsed() * 1e-9;
+    report.SetInfo("pyramid_levels", int(m_Levels.size()));
+    report.SetCounter("tiles_rendered", m_TilesRendered);
+    report.SetCounter("tiles_skipped", m_TilesSkipped);
+    report.SetCounter("pixels", double(m_PixelsDone));
+    report.SetCounter("field_evaluations", m_FieldEvaluations);
+    report.SetCounter("streamline_steps", m_Steps);
+    report.SetCounter("streamline_length", m_Length);
+    if (seconds > 0.)
+    {
+        report.SetCounter("pixels_per_second", m_PixelsDone / seconds);
+    }
+    if (m_LIC -> IsCancelled())
+    {
+        MessageLogger::Error(METHOD_NAME, "Rendering has been cancelled.");
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size, steps, and tiles of all levels
+bool PyramidRenderer::PlanLevels()
+{
+    const int width = m_LIC -> GetImageWidth();
+    const int height = m_LIC -> GetImageHeight();
+    const int tile_size = m_LIC -> m_Pyramid_TileSize;
+    int max_level = 0;
+    while ((1 << max_level) < qMax(width, height))
+    {
+        max_level++;
+    }
+
+    m_Levels.clear();
+    m_BaseLevel = 0;
+    for (int level_idx = 0; level_idx <= max_level; level_idx++)
+    {
+        const int scale = 1 << (max_level - level_idx);
+        Level level;
+        level.index = level_idx;
+        level.width = (width + scale - 1) / scale;
+        level.height = (height + scale - 1) / scale;
+
+        // Steps are in pixels, so streaks keep their length relative to
+        // the image
+        level.steps = qMax(1, qRound(double(m_LIC -> m_Steps) / scale));
+        level.num_columns = (level.width + tile_size - 1) / tile_size;
+        level.num_rows = (level.height + tile_size - 1) / tile_size;
+        if (level.num_columns == 1 &&
+            level.num_rows == 1)
+        {
+            m_BaseLevel = level_idx;
+        }
+        m_Levels << level;
+    }
+
+    // The base level is traced, so it needs the minimum size of an image
+    const Level & base = m_Levels[m_BaseLevel];
+    if (base.width < 10 ||
+        base.height < 10)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("A %1x%2 image is too narrow for a pyramid with tiles of "
+                "%3 pixels; both sides need at least 10 pixels in a single "
+                "tile.").arg(QString::number(width),
+                    QString::number(height),
+                    QString::number(tile_size)));
+        return false;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render tiles with one renderer per thread
+bool PyramidRenderer::RenderTiles(const QList < Tile > mcTiles,
+    std::function < bool(LIC &, const Tile &) > mRenderTile)
+{
+    if (mcTiles.isEmpty())
+    {
+        return true;
+    }
+
+    // Renderers are reused for all tiles of a thread, so buffers are only
+    // allocated once; memory is bounded by the tiles in progress
+    const int num_threads =
+        qBound(1, m_LIC -> GetNumThreads(), int(mcTiles.size()));
+    std::atomic < int > next_tile(0);
+    std::atomic < bool > success(true);
+    auto render_tiles = [&](bool mIsCallingThread)
+    {
+        LIC renderer;
+        if (!SetUpRenderer(renderer, 1))
+        {
+            success = false;
+            return;
+        }
+        while (success &&
+            !m_LIC -> IsCancelled())
+        {
+            const int tile_idx = next_tile.fetch_add(1);
+            if (tile_idx >= mcTiles.size())
+            {
+                break;
+            }
+            if (!mRenderTile(renderer, mcTiles[tile_idx]))
+            {
+                success = false;
+            }
+            if (!mIsCallingThread)
+            {
+                continue;
+            }
+            if (m_LIC -> m_ProgressCallback)
+            {
+                m_LIC -> m_ProgressCallback(
+                    double(m_PixelsDone) / m_TotalPixels);
+            }
+            if (m_LIC -> m_CancelCallback &&
+                m_LIC -> m_CancelCallback())
+            {
+                m_LIC -> Cancel();
+            }
+        }
+    };
+    std::vector < std::thread > helpers;
+    for (int helper_idx = 1; helper_idx < num_threads; helper_idx++)
+    {
+        helpers.emplace_back(render_tiles, false);
+    }
+    render_tiles(true);
+    for (std::thread & helper : helpers)
+    {
+        helper.join();
+    }
+    return success && !m_LIC -> IsCancelled();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace a tile
+bool PyramidRenderer::TraceTile(LIC & mrRenderer, const Tile & mcTile)
+{
+    // The tile is a region of interest of a frame of the level's size
+    const Level & level = m_Levels[mcTile.level];
+    const int tile_size = m_LIC -> m_Pyramid_TileSize;
+    const QRect tile = QRect(mcTile.column * tile_size,
+        mcTile.row * tile_size, tile_size, tile_size)
+            .intersected(QRect(0, 0, level.width, level.height));
+    mrRenderer.SetResolution(level.width, level.height);
+    mrRenderer.SetSteps(level.steps);
+    mrRenderer.SetROI(tile);
+    mrRenderer.GetMutablePerformanceReport().Clear();
+    const bool traced = mrRenderer.RunTracingStages();
+
+    // Totals
+    const PerformanceReport & report = mrRenderer.GetPerformanceReport();
+    const qint64 num_pixels = qint64(tile.width()) * tile.height();
+    const double steps = report.GetCounter("streamline_steps");
+    m_PixelsDone += num_pixels;
+    m_Progress -> AddWork(num_pixels, qint64(steps));
+    std::lock_guard < std::mutex > lock(m_Mutex);
+    m_FieldEvaluations += report.GetCounter("field_evaluations");
+    m_Steps += steps;
+    m_Length += report.GetCounter("streamline_length");
+    m_TilesRendered += (traced ? 1 : 0);
+    return traced;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Write a traced tile
+bool PyramidRenderer::SaveTile(LIC & mrRenderer, const Tile & mcTile)
+{
+    // XYZ tiles all have the same size; the part outside of the frame
+    // stays black
+    const int tile_size = m_LIC -> m_Pyramid_TileSize;
+    const bool full_size =
+        (m_LIC -> m_Pyramid_Layout == LIC::PyramidLayout_XYZ);
+    QImage image(full_size ? tile_size : mrRenderer.GetImageWidth(),
+        full_size ? tile_size : mrRenderer.GetImageHeight(),
+        QImage::Format_RGBX8888);
+    image.fill(QColor(0, 0, 0));
+    mrRenderer.GenerateImage(image.bits(), image.bytesPerLine(),
+        LIC::PixelFormat_RGBX8, QRect(), LIC::Channel_Color,
+        &m_Levels[mcTile.level].normalization);
+
+    // Written right away, so a viewer can show finished tiles
+    const QString filename = GetTileFilename(mcTile);
+    if (!QDir().mkpath(QFileInfo(filename).path()) ||
+        !image.save(filename, "png"))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Tile \"%1\" could not be saved.").arg(filename));
+        return false;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Levels below the first single tile level
+bool PyramidRenderer::SaveSmallLevels(LIC & mrBaseRenderer)
+{
+    // XYZ starts with the base level
+    if (m_LIC -> m_Pyramid_Layout != LIC::PyramidLayout_DeepZoom ||
+        m_BaseLevel == 0)
+    {
+        return true;
+    }
+
+    const Level & base = m_Levels[m_BaseLevel];
+    QImage base_image(base.width, base.height, QImage::Format_RGBX8888);
+    mrBaseRenderer.GenerateImage(base_image.bits(), base_image.bytesPerLine(),
+        LIC::PixelFormat_RGBX8, QRect(), LIC::Channel_Color,
+        &base.normalization);
+    bool success = true;
+    for (int level_idx = 0; level_idx < m_BaseLevel; level_idx++)
+    {
+        const Level & level = m_Levels[level_idx];
+        const Tile tile = { level_idx, 0, 0 };
+        const QString filename = GetTileFilename(tile);
+        if (QFile::exists(filename))
+        {
+            continue;
+        }
+        const QImage image = base_image.scaled(level.width, level.height,
+            Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        if (!QDir().mkpath(QFileInfo(filename).path()) ||
+            !image.save(filename, "png"))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Tile \"%1\" could not be saved.").arg(filename));
+            success = false;
+        }
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Renderer for tiles
+bool PyramidRenderer::SetUpRenderer(LIC & mrRenderer, int mNumThreads) const
+{
+    mrRenderer.SetProgressMode(ProgressReporter::Mode_Quiet);
+    mrRenderer.SetNumThreads(mNumThreads);
+    return mrRenderer.SetXMLConfiguration(m_LIC -> m_ConfigurationXML);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Where a tile goes
+QString PyramidRenderer::GetTileFilename(const Tile & mcTile) const
+{
+    const QString directory = m_LIC -> m_Pyramid_Directory;
+    if (m_LIC -> m_Pyramid_Layout == LIC::PyramidLayout_XYZ)
+    {
+        return QString("%1/%2/%3/%4.png").arg(directory,
+            QString::number(mcTile.level - m_BaseLevel),
+            QString::number(mcTile.column),
+            QString::number(mcTile.row));
+    }
+    return QString("%1_files/%2/%3_%4.png").arg(directory,
+        QString::number(mcTile.level),
+        QString::number(mcTile.column),
+        QString::number(mcTile.row));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Deep Zoom descriptor
+bool PyramidRenderer::WriteDescriptor() const
+{
+    const QString filename = m_LIC -> m_Pyramid_Directory + ".dzi";
+    QFile descriptor_file(filename);
+    if (!QDir().mkpath(QFileInfo(filename).path()) ||
+        !descriptor_file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+            QIODevice::Text))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Descriptor \"%1\" could not be written.")
+                .arg(filename));
+        return false;
+    }
+    QTextStream stream(&descriptor_file);
+    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" "
+        << "Format=\"png\" Overlap=\"0\" TileSize=\""
+        << m_LIC -> m_Pyramid_TileSize << "\">\n"
+        << "  <Size Width=\"" << m_LIC -> GetImageWidth()
+        << "\" Height=\"" << m_LIC -> GetImageHeight() << "\"/>\n"
+        << "</Image>\n";
+    return true;
+}
@@ -0,0 +1,108 @@
+// PyramidRenderer.h
+// Class definition
+
+#ifndef PYRAMIDRENDERER_H
+#define PYRAMIDRENDERER_H
+
+// Project includes
+#include "LIC.h"
+
+// Qt includes
+#include <QList>
+#include <QString>
+
+// System includes
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+
+
+// Define class
+class PyramidRenderer
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; renders the pyramid of a configured renderer, and adds
+    // its figures to the performance report of that renderer
+    PyramidRenderer(LIC * mpLIC);
+
+    // Destructor
+    virtual ~PyramidRenderer();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Render all tiles that don't exist yet
+    bool Execute();
+
+private:
+    // Levels are numbered as in Deep Zoom: level 0 is 1x1 pixels, and every
+    // level has twice the resolution of the one before; the last one has
+    // the resolution of the configuration. Levels from the first one that
+    // needs more than one tile are traced at their own resolution; the
+    // ones below are scaled down from the last single tile level.
+    struct Level
+    {
+        int index = 0;
+        int width = 0;
+        int height = 0;
+        int steps = 1;
+        int num_columns = 1;
+        int num_rows = 1;
+
+        // Intensity of the center tile, strength of the whole frame
+        LIC::Normalization normalization;
+    };
+    bool PlanLevels();
+
+    QList < Level > m_Levels;
+    int m_BaseLevel;
+
+    // One tile of a level
+    struct Tile
+    {
+        int level;
+        int column;
+        int row;
+    };
+
+    // Render tiles with one renderer per thread; the calling thread is one
+    // of them and the only one calling callbacks
+    bool RenderTiles(const QList < Tile > mcTiles,
+        std::function < bool(LIC &, const Tile &) > mRenderTile);
+
+    // Trace a tile; returns false if cancelled
+    bool TraceTile(LIC & mrRenderer, const Tile & mcTile);
+
+    // Write a traced tile
+    bool SaveTile(LIC & mrRenderer, const Tile & mcTile);
+
+    // Levels below the first single tile level (Deep Zoom only)
+    bool SaveSmallLevels(LIC & mrBaseRenderer);
+
+    // Renderer for tiles, configured like the one of the pyramid
+    bool SetUpRenderer(LIC & mrRenderer, int mNumThreads) const;
+
+    // Where a tile goes
+    QString GetTileFilename(const Tile & mcTile) const;
+
+    // Deep Zoom descriptor (.dzi)
+    bool WriteDescriptor() const;
+
+    LIC * m_LIC;
+
+    // Progress and totals of all renderers
+    ProgressReporter * m_Progress;
+    std::mutex m_Mutex;
+    std::atomic < qint64 > m_PixelsDone;
+    qint64 m_TotalPixels;
+    int m_TilesRendered;
+    int m_TilesSkipped;
+    double m_FieldEvaluations;
+    double m_Steps;
+    double m_Length;
+};
+
+#endif
@@ -0,0 +1,189 @@
+// RenderClient.cpp
+// Class implementation
+
+// Project includes
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "RenderClient.h"
+#include "RenderServer.h"
+
+// Qt includes
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLocalSocket>
+
+
+
+// Milliseconds to wait for the server
+static const int CONNECT_TIMEOUT_MS = 5000;
+
+// A cold request may trace a large image
+static const int RESPONSE_TIMEOUT_MS = 600000;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+RenderClient::RenderClient(const QString mcSocketName)
+{
+    m_SocketName = mcSocketName;
+    m_Format = "png";
+    m_Repeat = 1;
+    m_Priority = 0;
+    m_DeadlineMS = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+RenderClient::~RenderClient()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Format of the result
+bool RenderClient::SetFormat(const QString mcFormat)
+{
+    if (!RenderServer::GetFormats().contains(mcFormat))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid format \"%1\"; must be one of %2.")
+                .arg(mcFormat, RenderServer::GetFormats().join(", ")));
+        return false;
+    }
+    m_Format = mcFormat;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Send the same request this many times
+void RenderClient::SetRepeat(int mRepeat)
+{
+    m_Repeat = qMax(1, mRepeat);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Priority and deadline of the requests
+void RenderClient::SetPriority(int mPriority, int mDeadlineMS)
+{
+    m_Priority = mPriority;
+    m_DeadlineMS = qMax(0, mDeadlineMS);
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Have a running server render a configuration file
+bool RenderClient::Execute(const QString mcConfigFilename,
+    const QString mcOutputFilename)
+{
+    QFile config_file(mcConfigFilename);
+    if (!config_file.open(QIODevice::ReadOnly))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Configuration \"%1\" could not be read.")
+                .arg(mcConfigFilename));
+        return false;
+    }
+    const QByteArray configuration = config_file.readAll();
+
+    QLocalSocket socket;
+    socket.connectToServer(m_SocketName);
+    if (!socket.waitForConnected(CONNECT_TIMEOUT_MS))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("No server on \"%1\": %2").arg(m_SocketName,
+                socket.errorString()));
+        return false;
+    }
+
+    // Requests go one after the other over the same connection, like a
+    // tool would send them
+    QDataStream stream(&socket);
+    stream.setVersion(QDataStream::Qt_6_0);
+    QByteArray data;
+    for (int request_idx = 0; request_idx < m_Repeat; request_idx++)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        stream << m_Format << configuration << qint32(m_Priority)
+            << qint32(m_DeadlineMS);
+        if (!socket.waitForBytesWritten(RESPONSE_TIMEOUT_MS))
+        {
+            MessageLogger::Error(METHOD_NAME, "Request could not be sent.");
+            return false;
+        }
+
+        // Large images arrive in several parts
+        bool success = false;
+        QString message;
+        qint32 width = 0;
+        qint32 height = 0;
+        double server_seconds = 0.;
+        QString stages;
+        while (true)
+        {
+            stream.startTransaction();
+            stream >> success >> message >> width >> height >> data
+                >> server_seconds >> stages;
+            if (stream.commitTransaction())
+            {
+                break;
+            }
+            if (!socket.waitForReadyRead(RESPONSE_TIMEOUT_MS))
+            {
+                MessageLogger::Error(METHOD_NAME,
+                    "Server did not answer.");
+                return false;
+            }
+        }
+        if (!success)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Server failed: %1").arg(message));
+            return false;
+        }
+        qDebug().noquote() <<
+            QString("Request %1: %2x%3 in %4 ms (server %5 ms; %6).")
+                .arg(QString::number(request_idx + 1),
+                     QString::number(width),
+                     QString::number(height),
+                     QString::number(timer.nsecsElapsed() * 1e-6, 'f', 1),
+                     QString::number(server_seconds * 1e3, 'f', 1),
+                     stages);
+    }
+
+    // PNG files as they are, raw buffers without any header
+    QFile output_file(mcOutputFilename);
+    if (!output_file.open(QIODevice::WriteOnly) ||
+        output_file.write(data) != data.size())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Output \"%1\" could not be written.")
+                .arg(mcOutputFilename));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+// RenderClient.h
+// Class definition
+
+#ifndef RENDERCLIENT_H
+#define RENDERCLIENT_H
+
+// Qt includes
+#include <QString>
+
+
+
+// Define class
+class RenderClient
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    RenderClient(const QString mcSocketName);
+
+    // Destructor
+    virtual ~RenderClient();
+
+
+
+    // ========================================================== Configuration
+public:
+    // Format of the result (see RenderServer::GetFormats())
+    bool SetFormat(const QString mcFormat);
+
+    // Send the same request this many times, to see how warm caches help
+    void SetRepeat(int mRepeat);
+
+    // Priority of the requests (higher first), and their deadline in
+    // milliseconds from sending (0: none)
+    void SetPriority(int mPriority, int mDeadlineMS = 0);
+
+private:
+    QString m_SocketName;
+    QString m_Format;
+    int m_Repeat;
+    int m_Priority;
+    int m_DeadlineMS;
+
+
+
+    // ========================================================== Functionality
+public:
+    // Have a running server render a configuration file and save the
+    // result; prints the latency of every request
+    bool Execute(const QString mcConfigFilename,
+        const QString mcOutputFilename);
+};
+
+#endif
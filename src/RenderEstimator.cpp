@@ -0,0 +1,450 @@
+// RenderEstimator.cpp
+// Class implementation
+
+// Project includes
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "RenderEstimator.h"
+#include "SimdKernels.h"
+
+// Qt includes
+#include <QDebug>
+#include <QElapsedTimer>
+
+// System includes
+#include <cmath>
+
+
+
+// Samples are one pixel in each cell of a grid of this size over the
+// traced pixels, so fields whose cost varies (e.g. near singularities) are
+// covered evenly
+static const int SAMPLE_GRID = 20;
+
+// Evaluations of the formulas are timed in this many passes over the
+// sample positions, since a single one is too short for the clock
+static const int FORMULA_REPEATS = 20;
+
+// Range of the prediction, in standard errors of the sample
+static const double ERROR_RANGE = 2.;
+
+// The calibration traces up to this many tiles per thread, fewer if that
+// would take longer than the given time; its pixels are timed one by one
+// on a grid of this size
+static const int CALIBRATION_TILES_PER_THREAD = 4;
+static const double CALIBRATION_SECONDS = 1.;
+static const int CALIBRATION_GRID = 8;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+RenderEstimator::RenderEstimator(LIC * mpLIC)
+{
+    m_LIC = mpLIC;
+    m_NumSamples = 0;
+    m_EvaluationSeconds = 0.;
+    m_PixelSeconds = 0.;
+    m_PixelSecondsError = 0.;
+    m_StepsPerPixel = 0.;
+    m_EvaluationsPerPixel = 0.;
+    m_BreaksPerPixel = 0.;
+    m_NoiseSecondsPerValue = 0.;
+    m_CalibrationPixels = 0;
+    m_Efficiency = 1.;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+RenderEstimator::~RenderEstimator()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Predict the cost of rendering the configuration
+bool RenderEstimator::Execute()
+{
+    LIC & lic = *m_LIC;
+    if (!lic.IsValid())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("The configuration is not valid."));
+        return false;
+    }
+    if (lic.HasPyramid())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Estimates are not available for tile pyramids."));
+        return false;
+    }
+
+    // Pixels of the render; a sweep traces all of every frame
+    const int num_images = (lic.HasSweep() ? lic.GetSweepCount() : 1);
+    const QRect rect = (lic.HasSweep() ?
+        QRect(0, 0, lic.GetImageWidth(), lic.GetImageHeight()) :
+        lic.GetTraceRect());
+    const double num_pixels =
+        double(rect.width()) * rect.height() * num_images;
+
+    // Tracing is spread over the threads (or processes), but never over
+    // more of them than there are tiles; noise is generated by one thread
+    const int num_threads = qMax(1,
+        qMin(lic.GetNumThreads(), lic.GetNumTiles() * num_images));
+    bool calibrated = false;
+    lic.RunStage("Estimate",
+        [this, num_threads, &calibrated]()
+        {
+            Sample();
+            calibrated = Calibrate(num_threads);
+            return true;
+        });
+    PerformanceReport & report = lic.GetMutablePerformanceReport();
+
+    // Threads don't scale perfectly (hyperthreads share a core, memory is
+    // shared, worker processes copy their tiles); without a calibration,
+    // the time is a lower bound
+    const double parallel_threads = num_threads * m_Efficiency;
+    const QRect window = lic.GetNoiseWindow();
+    const double noise_seconds = m_NoiseSecondsPerValue *
+        window.width() * window.height();
+    const double trace_seconds =
+        num_pixels * m_PixelSeconds / parallel_threads;
+    const double error_seconds =
+        num_pixels * ERROR_RANGE * m_PixelSecondsError / parallel_threads;
+    const double seconds = noise_seconds + trace_seconds;
+    const double min_seconds = noise_seconds +
+        qMax(0., trace_seconds - error_seconds);
+    const double max_seconds = seconds + error_seconds;
+    const qint64 peak_memory = GetPeakMemory();
+    const QString backend =
+        (lic.UsesWorkerProcesses() ? "processes" : "threads");
+
+    report.SetInfo("estimate_threads", num_threads);
+    report.SetInfo("estimate_backend", backend);
+    report.SetCounter("estimate_samples", m_NumSamples);
+    report.SetCounter("estimate_seconds_per_evaluation", m_EvaluationSeconds);
+    report.SetCounter("estimate_seconds_per_pixel", m_PixelSeconds);
+    report.SetCounter("estimate_steps_per_pixel", m_StepsPerPixel);
+    report.SetCounter("estimate_field_evaluations_per_pixel",
+        m_EvaluationsPerPixel);
+    report.SetCounter("estimate_singularity_breaks_per_pixel",
+        m_BreaksPerPixel);
+    report.SetCounter("estimate_calibration_pixels",
+        double(m_CalibrationPixels));
+    report.SetCounter("estimate_parallel_efficiency",
+        (calibrated ? m_Efficiency : -1.));
+    report.SetCounter("estimate_pixels", num_pixels);
+    report.SetCounter("estimate_seconds", seconds);
+    report.SetCounter("estimate_seconds_min", min_seconds);
+    report.SetCounter("estimate_seconds_max", max_seconds);
+    report.SetCounter("estimate_peak_memory_bytes", double(peak_memory));
+
+    qDebug().noquote() << QString("Estimate from %1 pixels: "
+        "%2 us per evaluation of the field, %3 evaluations, %4 steps, and "
+        "%5 singularity breaks per pixel.")
+        .arg(QString::number(m_NumSamples),
+            QString::number(m_EvaluationSeconds * 1e6, 'g', 3),
+            QString::number(m_EvaluationsPerPixel, 'f', 1),
+            QString::number(m_StepsPerPixel, 'f', 1),
+            QString::number(m_BreaksPerPixel, 'f', 2));
+    if (calibrated)
+    {
+        qDebug().noquote() << QString("%1 %2 reach %3% of perfect scaling "
+            "on %4 pixels.")
+            .arg(QString::number(num_threads),
+                backend,
+                QString::number(m_Efficiency * 100., 'f', 0),
+                QString::number(m_CalibrationPixels));
+    } else
+    {
+        qDebug().noquote() << "The calibration has been cancelled; the "
+            "estimate assumes perfect scaling and is a lower bound.";
+    }
+    qDebug().noquote() << QString("Rendering %1 pixels with %2 %3 takes "
+        "%4%5 (%6 to %7) and needs about %8 MiB.")
+        .arg(QString::number(num_pixels, 'f', 0),
+            QString::number(num_threads),
+            backend,
+            (calibrated ? "about " : "at least "),
+            ProgressReporter::FormatTime(seconds),
+            ProgressReporter::FormatTime(min_seconds),
+            ProgressReporter::FormatTime(max_seconds),
+            QString::number(double(peak_memory) / (1 << 20), 'f', 0));
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace the sample and measure it
+void RenderEstimator::Sample()
+{
+    LIC & lic = *m_LIC;
+
+    // Every sample is a region of interest of one pixel; the region of the
+    // configuration is restored afterwards
+    const QRect roi = lic.GetRegion();
+    const int image_width = lic.GetImageWidth();
+    const int image_height = lic.GetImageHeight();
+    const int image_x = (roi.isEmpty() ? 0 : roi.x());
+    const int image_y = (roi.isEmpty() ? 0 : roi.y());
+    const QRect rect = (lic.HasSweep() ?
+        QRect(0, 0, image_width, image_height) :
+        lic.GetTraceRect());
+
+    // The noise windows of all samples have the same size, and the values
+    // of the noise don't change the cost of tracing, so one window serves
+    // all of them
+    QElapsedTimer timer;
+    lic.SetRegion(QRect(image_x + rect.left(), image_y + rect.top(), 1, 1));
+    timer.start();
+    lic.GenerateNoise();
+    const QRect window = lic.GetNoiseWindow();
+    m_NoiseSecondsPerValue = timer.nsecsElapsed() * 1e-9 /
+        (double(window.width()) * window.height());
+
+    // Trace one pixel in each cell of the grid; the frames of a sweep take
+    // turns
+    double lic_r = 0.;
+    double lic_g = 0.;
+    double lic_b = 0.;
+    double lic_strength = 0.;
+    LIC::TraceTarget target;
+    target.lic_r = &lic_r;
+    target.lic_g = &lic_g;
+    target.lic_b = &lic_b;
+    target.lic_strength = &lic_strength;
+    LIC::TraceWorkspace workspace;
+    QList < double > pixel_seconds;
+    QList < QPair < int, int > > positions;
+    qint64 evaluations = 0;
+    qint64 steps = 0;
+    qint64 breaks = 0;
+    for (int cell_x = 0; cell_x < SAMPLE_GRID; cell_x++)
+    {
+        for (int cell_y = 0; cell_y < SAMPLE_GRID; cell_y++)
+        {
+            // Random pixel of the cell, the same in every run
+            const int sample = cell_x * SAMPLE_GRID + cell_y;
+            const int ix = rect.left() + int((cell_x +
+                SimdKernels::GetPositionNoise(1, cell_x, cell_y)) *
+                rect.width() / SAMPLE_GRID);
+            const int iy = rect.top() + int((cell_y +
+                SimdKernels::GetPositionNoise(2, cell_x, cell_y)) *
+                rect.height() / SAMPLE_GRID);
+            lic.SetRegion(QRect(image_x + ix, image_y + iy, 1, 1));
+            lic.InitializeWorkspace(workspace);
+            target.sweep_value = (lic.HasSweep() ?
+                lic.GetSweepValue(sample % lic.GetSweepCount()) :
+                lic.GetImageTarget().sweep_value);
+            lic.SetWorkspaceTarget(workspace, target);
+            workspace.field_evaluations = 0;
+            workspace.steps = 0;
+            workspace.singularity_breaks = 0;
+
+            timer.restart();
+            lic.TracePixel(0, 0, workspace);
+            pixel_seconds << timer.nsecsElapsed() * 1e-9;
+            positions << QPair < int, int >(image_x + ix, image_y + iy);
+            evaluations += workspace.field_evaluations;
+            steps += workspace.steps;
+            breaks += workspace.singularity_breaks;
+        }
+    }
+
+    // Cost of the formulas alone, at the positions of the sample
+    const QSize frame = lic.GetFrameSize();
+    double x_min = 0.;
+    double x_max = 0.;
+    double y_min = 0.;
+    double y_max = 0.;
+    lic.GetImageRange(x_min, x_max, y_min, y_max);
+    const double dx = (x_max - x_min) / (frame.width() - 1.);
+    const double dy = (y_max - y_min) / (frame.height() - 1.);
+    timer.restart();
+    for (int repeat = 0; repeat < FORMULA_REPEATS; repeat++)
+    {
+        for (const QPair < int, int > & position : positions)
+        {
+            lic.EvaluateVectorfield(x_min + position.first * dx,
+                y_min + (frame.height() - 1 - position.second) * dy,
+                workspace);
+        }
+    }
+    m_EvaluationSeconds = timer.nsecsElapsed() * 1e-9 /
+        (double(FORMULA_REPEATS) * positions.size());
+
+    // Mean cost of a pixel, and its standard error
+    m_NumSamples = pixel_seconds.size();
+    double sum = 0.;
+    for (double value : pixel_seconds)
+    {
+        sum += value;
+    }
+    m_PixelSeconds = sum / m_NumSamples;
+    double sum_squares = 0.;
+    for (double value : pixel_seconds)
+    {
+        sum_squares += (value - m_PixelSeconds) * (value - m_PixelSeconds);
+    }
+    m_PixelSecondsError = (m_NumSamples > 1 ?
+        sqrt(sum_squares / (m_NumSamples - 1.) / m_NumSamples) : 0.);
+    m_StepsPerPixel = double(steps) / m_NumSamples;
+    m_EvaluationsPerPixel = double(evaluations) / m_NumSamples;
+    m_BreaksPerPixel = double(breaks) / m_NumSamples;
+
+    // Back to the configured image; its noise is generated when rendering
+    lic.SetRegion(roi);
+    lic.TakeNoisePlanes();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Find how well tracing scales
+bool RenderEstimator::Calibrate(int mNumThreads)
+{
+    LIC & lic = *m_LIC;
+
+    // The block is a region of interest; the region of the configuration
+    // is restored afterwards
+    const QRect roi = lic.GetRegion();
+    const int image_width = lic.GetImageWidth();
+    const int image_height = lic.GetImageHeight();
+    const int image_x = (roi.isEmpty() ? 0 : roi.x());
+    const int image_y = (roi.isEmpty() ? 0 : roi.y());
+    const QRect rect = (lic.HasSweep() ?
+        QRect(0, 0, image_width, image_height) :
+        lic.GetTraceRect());
+
+    // Enough tiles to keep every thread busy, in the middle of the traced
+    // pixels
+    const int tile_size = lic.GetTileSize();
+    const double tile_seconds =
+        qMax(m_PixelSeconds, 1e-9) * tile_size * tile_size;
+    const int num_tiles = qBound(mNumThreads,
+        int(qMin(CALIBRATION_SECONDS * mNumThreads / tile_seconds, 1e6)),
+        CALIBRATION_TILES_PER_THREAD * mNumThreads);
+    const int num_tiles_x = int(ceil(sqrt(double(num_tiles))));
+    const int num_tiles_y = (num_tiles + num_tiles_x - 1) / num_tiles_x;
+    QRect block(0, 0, num_tiles_x * tile_size, num_tiles_y * tile_size);
+    block.moveCenter(rect.center());
+    block = block.intersected(rect);
+    lic.SetRegion(block.translated(image_x, image_y));
+    lic.GenerateNoise();
+    lic.AllocateTracedPlanes();
+
+    // Pixels of the block one by one on this thread
+    LIC::TraceWorkspace workspace;
+    lic.InitializeWorkspace(workspace);
+    lic.SetWorkspaceTarget(workspace, lic.GetImageTarget());
+    QElapsedTimer timer;
+    timer.start();
+    for (int cell_x = 0; cell_x < CALIBRATION_GRID; cell_x++)
+    {
+        for (int cell_y = 0; cell_y < CALIBRATION_GRID; cell_y++)
+        {
+            const int ix = int((cell_x +
+                SimdKernels::GetPositionNoise(3, cell_x, cell_y)) *
+                block.width() / CALIBRATION_GRID);
+            const int iy = int((cell_y +
+                SimdKernels::GetPositionNoise(4, cell_x, cell_y)) *
+                block.height() / CALIBRATION_GRID);
+            lic.TracePixel(ix, iy, workspace);
+        }
+    }
+    const double pixel_seconds = timer.nsecsElapsed() * 1e-9 /
+        (CALIBRATION_GRID * CALIBRATION_GRID);
+
+    // The whole block the way it is rendered, without showing progress
+    const ProgressReporter::Mode progress_mode = lic.GetProgressMode();
+    lic.SetProgressMode(ProgressReporter::Mode_Quiet);
+    timer.restart();
+    const bool success = lic.TraceTargets({ lic.GetImageTarget() });
+    const double block_seconds = timer.nsecsElapsed() * 1e-9;
+    lic.SetProgressMode(progress_mode);
+    m_CalibrationPixels = qint64(block.width()) * block.height();
+
+    // Share of perfect scaling; more than that is noise of the sample
+    m_Efficiency = 1.;
+    if (success &&
+        block_seconds > 0.)
+    {
+        m_Efficiency = qBound(0.01, m_CalibrationPixels * pixel_seconds /
+            (block_seconds * qMin(mNumThreads, lic.GetNumTiles())), 1.);
+    }
+
+    // Back to the configured image
+    lic.SetRegion(roi);
+    lic.TakeNoisePlanes();
+    lic.TakeTracedPlanes();
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory of the planes, noise, and images of a render
+qint64 RenderEstimator::GetPeakMemory() const
+{
+    const LIC & lic = *m_LIC;
+    const qint64 plane_bytes = qint64(sizeof(double)) *
+        lic.GetImageWidth() * lic.GetImageHeight();
+
+    // Noise
+    const QRect window = lic.GetNoiseWindow();
+    qint64 bytes = 3 * qint64(sizeof(double)) * window.width() *
+        window.height();
+
+    // Traced planes; a sweep traces groups of frames together. Worker
+    // processes trace into planes in shared memory, which are copied.
+    const int num_frames = (lic.HasSweep() ? lic.GetSweepGroupSize() : 1);
+    qint64 plane_copies = 1;
+    if (lic.UsesWorkerProcesses())
+    {
+        plane_copies = 2;
+    }
+    bytes += 4 * plane_bytes * num_frames * plane_copies;
+
+    // Images: the contact sheet of a sweep, or the largest output with its
+    // crop and the scaled copy of that
+    const qint64 pixel_bytes = 4;
+    qint64 image_bytes = 0;
+    if (lic.HasSweep())
+    {
+        const QSize sheet = lic.GetContactSheetSize();
+        image_bytes = pixel_bytes * lic.GetImageWidth() *
+            lic.GetImageHeight();
+        if (!sheet.isEmpty())
+        {
+            image_bytes += pixel_bytes * sheet.width() * sheet.height();
+        }
+    } else
+    {
+        const QRect trace_rect = lic.GetTraceRect();
+        const qint64 traced_bytes =
+            pixel_bytes * trace_rect.width() * trace_rect.height();
+        for (const LIC::Output & output : lic.GetOutputs())
+        {
+            const QRect crop = (output.crop.isEmpty() ?
+                trace_rect : output.crop.intersected(trace_rect));
+            const qint64 crop_bytes =
+                pixel_bytes * crop.width() * crop.height();
+            image_bytes = qMax(image_bytes, traced_bytes + 2 * crop_bytes);
+        }
+    }
+    return bytes + image_bytes;
+}
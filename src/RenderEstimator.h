@@ -0,0 +1,68 @@
+// RenderEstimator.h
+// Class definition
+
+#ifndef RENDERESTIMATOR_H
+#define RENDERESTIMATOR_H
+
+// Project includes
+#include "LIC.h"
+
+// Qt includes
+#include <QString>
+
+
+
+// Define class
+class RenderEstimator
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; estimates the cost of rendering a configured renderer
+    RenderEstimator(LIC * mpLIC);
+
+    // Destructor
+    virtual ~RenderEstimator();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Trace a few hundred pixels spread over the image (and over the
+    // frames of a sweep) on this thread, and a small block of tiles with
+    // the renderer's threads and backend to find how well they scale;
+    // then predict the wall time and the peak memory of rendering. Nothing
+    // is written; the figures are shown and added to the performance
+    // report of the renderer.
+    bool Execute();
+
+private:
+    // Trace the sample and measure it
+    void Sample();
+
+    // Trace a block of tiles with mNumThreads threads (or processes) and
+    // compare it with tracing its pixels one by one on this thread; false
+    // if tracing was cancelled
+    bool Calibrate(int mNumThreads);
+
+    // Memory of the planes, noise, and images of a render
+    qint64 GetPeakMemory() const;
+
+    LIC * m_LIC;
+
+    // Measurements of the sample
+    int m_NumSamples;
+    double m_EvaluationSeconds;
+    double m_PixelSeconds;
+    double m_PixelSecondsError;
+    double m_StepsPerPixel;
+    double m_EvaluationsPerPixel;
+    double m_BreaksPerPixel;
+    double m_NoiseSecondsPerValue;
+
+    // Measurements of the calibration: pixels traced, and the share of
+    // perfect scaling reached (including the overhead of the backend)
+    qint64 m_CalibrationPixels;
+    double m_Efficiency;
+};
+
+#endif
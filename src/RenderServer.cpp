@@ -0,0 +1,479 @@
+// RenderServer.cpp
+// Class implementation
+
+// Project includes
+#include "LIC.h"
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "RenderServer.h"
+#include "TileScheduler.h"
+
+// Qt includes
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMetaObject>
+#include <QThread>
+
+
+
+// Noise and traced images of this many bytes are kept by default; a
+// 512x512 preview needs 14 MB
+static const qint64 DEFAULT_CACHE_SIZE = qint64(1) << 30;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+RenderServer::RenderServer(const QString mcSocketName)
+{
+    m_SocketName = mcSocketName;
+    m_NumThreads = 0;
+    m_CacheSize = DEFAULT_CACHE_SIZE;
+    m_Scheduler = nullptr;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+RenderServer::~RenderServer()
+{
+    // Running requests release their threads within a column of pixels
+    for (LIC * renderer : m_Running)
+    {
+        renderer -> Cancel();
+    }
+    for (auto & render_thread : m_RenderThreads)
+    {
+        render_thread.second.join();
+    }
+    for (const CacheEntry & entry : m_Cache)
+    {
+        delete entry.renderer;
+    }
+    delete m_Scheduler;
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads used for tracing
+void RenderServer::SetNumThreads(int mNumThreads)
+{
+    m_NumThreads = mNumThreads;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Memory for noise and traced images kept between requests
+void RenderServer::SetCacheSize(qint64 mBytes)
+{
+    m_CacheSize = mBytes;
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Serve requests until the application quits
+int RenderServer::Execute()
+{
+    // A server that crashed leaves its socket file behind
+    QLocalServer::removeServer(m_SocketName);
+    if (!m_Server.listen(m_SocketName))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Cannot listen on \"%1\": %2").arg(m_SocketName,
+                m_Server.errorString()));
+        return 1;
+    }
+
+    // Threads that render requests only wait for the scheduler while
+    // tracing, so all cores are in the scheduler
+    m_Scheduler = new TileScheduler(
+        m_NumThreads > 0 ? m_NumThreads : QThread::idealThreadCount());
+
+    QObject::connect(&m_Server, &QLocalServer::newConnection, &m_Server,
+        [this]()
+        {
+            NewConnection();
+        });
+    qDebug().noquote() << QString("Serving on \"%1\".")
+        .arg(m_Server.fullServerName());
+    return QCoreApplication::exec();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Pixel formats a request can ask for
+QStringList RenderServer::GetFormats()
+{
+    return QStringList({ "png", "rgbx8", "rgb_float" });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Client connected
+void RenderServer::NewConnection()
+{
+    while (m_Server.hasPendingConnections())
+    {
+        QLocalSocket * socket = m_Server.nextPendingConnection();
+        QObject::connect(socket, &QLocalSocket::readyRead, socket,
+            [this, socket]()
+            {
+                ReadRequests(socket);
+            });
+        QObject::connect(socket, &QLocalSocket::disconnected, socket,
+            [this, socket]()
+            {
+                // Nobody waits for the answer anymore; finished tiles stay
+                // in the renderer for the next request
+                if (m_Running.contains(socket))
+                {
+                    m_Running.take(socket) -> Cancel();
+                }
+                socket -> deleteLater();
+            });
+
+        // Requests may have arrived with the connection
+        ReadRequests(socket);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Start the next request of a connection
+void RenderServer::ReadRequests(QLocalSocket * mpSocket)
+{
+    QDataStream stream(mpSocket);
+    stream.setVersion(QDataStream::Qt_6_0);
+    while (!m_Running.contains(mpSocket))
+    {
+        // Large configurations arrive in several parts
+        stream.startTransaction();
+        QString format;
+        QByteArray configuration;
+        qint32 priority = 0;
+        qint32 deadline_ms = 0;
+        stream >> format >> configuration >> priority >> deadline_ms;
+        if (!stream.commitTransaction())
+        {
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        Result result;
+        const int entry_idx = (GetFormats().contains(format) ?
+            AcquireEntry(configuration, result.message) : -1);
+        if (!GetFormats().contains(format))
+        {
+            result.message = QString("Invalid format \"%1\"; must be one "
+                "of %2.").arg(format, GetFormats().join(", "));
+        }
+        if (entry_idx < 0)
+        {
+            WriteResult(mpSocket, result, timer.nsecsElapsed() * 1e-9);
+            continue;
+        }
+
+        // Rendered on a thread of its own; tracing goes through the
+        // scheduler
+        CacheEntry & entry = m_Cache[entry_idx];
+        entry.busy = true;
+        LIC * renderer = entry.renderer;
+        renderer -> SetPriority(priority, deadline_ms > 0 ?
+            QDeadlineTimer(deadline_ms) :
+            QDeadlineTimer(QDeadlineTimer::Forever));
+        renderer -> ResetCancel();
+        m_Running.insert(mpSocket, renderer);
+        const QString noise_key = entry.noise_key;
+        const QString tracing_key = entry.tracing_key;
+        QPointer < QLocalSocket > socket(mpSocket);
+        m_RenderThreads[renderer] = std::thread(
+            [this, socket, renderer, format, noise_key, tracing_key, timer]()
+            {
+                const Result result =
+                    Render(renderer, format, noise_key, tracing_key);
+                const double seconds = timer.nsecsElapsed() * 1e-9;
+                QMetaObject::invokeMethod(&m_Server,
+                    [this, socket, renderer, result, seconds]()
+                    {
+                        RenderFinished(socket, renderer, result, seconds);
+                    }, Qt::QueuedConnection);
+            });
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Answer a request
+void RenderServer::WriteResult(QLocalSocket * mpSocket,
+    const Result & mcResult, double mSeconds)
+{
+    if (!mcResult.success)
+    {
+        MessageLogger::Error(METHOD_NAME, mcResult.message);
+    }
+    QDataStream stream(mpSocket);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << mcResult.success << mcResult.message << qint32(mcResult.width)
+        << qint32(mcResult.height) << mcResult.data << mSeconds
+        << mcResult.stages.join(", ");
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render a configuration into a PNG file or a raw buffer
+RenderServer::Result RenderServer::Render(LIC * mpRenderer,
+    const QString mcFormat, const QString mcNoiseKey,
+    const QString mcTracingKey)
+{
+    Result result;
+    result.noise_key = mcNoiseKey;
+    result.tracing_key = mcTracingKey;
+    mpRenderer -> GetMutablePerformanceReport().Clear();
+
+    // Only stages with changed inputs run
+    const QString noise_key = mpRenderer -> GetNoiseKey();
+    const QString tracing_key = mpRenderer -> GetTracingKey();
+    if (noise_key != result.noise_key)
+    {
+        mpRenderer -> RunStage("GenerateNoise",
+            [mpRenderer]()
+            {
+                mpRenderer -> GenerateNoise();
+                return true;
+            });
+        result.noise_key = noise_key;
+        result.stages << "noise";
+    }
+    if (tracing_key != result.tracing_key)
+    {
+        result.tracing_key.clear();
+        const bool traced = mpRenderer -> RunStage("GenerateLIC",
+            [mpRenderer]()
+            {
+                return mpRenderer -> GenerateLIC();
+            });
+        if (!traced)
+        {
+            result.message = "Rendering has been cancelled.";
+            return result;
+        }
+        result.tracing_key = tracing_key;
+        result.stages << "tracing";
+    }
+
+    // Image
+    mpRenderer -> RunStage("GenerateImage",
+        [mpRenderer, mcFormat, &result]()
+        {
+            result.width = mpRenderer -> GetImageWidth();
+            result.height = mpRenderer -> GetImageHeight();
+            result.success = true;
+            if (mcFormat == "png")
+            {
+                QImage image(result.width, result.height,
+                    QImage::Format_RGBX8888);
+                mpRenderer -> GenerateImage(image.bits(),
+                    image.bytesPerLine(), LIC::PixelFormat_RGBX8);
+                QBuffer buffer(&result.data);
+                result.success = buffer.open(QIODevice::WriteOnly) &&
+                    image.save(&buffer, "png");
+                if (!result.success)
+                {
+                    result.message = "Image could not be encoded.";
+                }
+            } else
+            {
+                const LIC::PixelFormat pixel_format =
+                    (mcFormat == "rgbx8" ? LIC::PixelFormat_RGBX8 :
+                        LIC::PixelFormat_RGB_Float);
+                const qsizetype stride =
+                    (pixel_format == LIC::PixelFormat_RGBX8 ?
+                        4 : 3 * qsizetype(sizeof(float))) * result.width;
+                result.data.resize(stride * result.height);
+                mpRenderer -> GenerateImage(result.data.data(), stride,
+                    pixel_format);
+            }
+            return result.success;
+        });
+    result.stages << "image";
+    return result;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Request has been rendered
+void RenderServer::RenderFinished(QPointer < QLocalSocket > mpSocket,
+    LIC * mpRenderer, const Result & mcResult, double mSeconds)
+{
+    m_RenderThreads[mpRenderer].join();
+    m_RenderThreads.erase(mpRenderer);
+
+    // The renderer is available again
+    for (CacheEntry & entry : m_Cache)
+    {
+        if (entry.renderer == mpRenderer)
+        {
+            entry.noise_key = mcResult.noise_key;
+            entry.tracing_key = mcResult.tracing_key;
+            entry.busy = false;
+        }
+    }
+
+    // Buffers may have grown
+    TrimCache();
+
+    // The connection may be gone (and its request cancelled)
+    if (!mpSocket ||
+        m_Running.value(mpSocket) != mpRenderer)
+    {
+        return;
+    }
+    m_Running.remove(mpSocket);
+    WriteResult(mpSocket, mcResult, mSeconds);
+    ReadRequests(mpSocket);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Renderer for a configuration
+int RenderServer::AcquireEntry(const QByteArray & mcConfiguration,
+    QString & mrMessage)
+{
+    // Same text: formulas are still compiled, and nothing needs to be
+    // parsed
+    for (int entry_idx = 0; entry_idx < m_Cache.size(); entry_idx++)
+    {
+        if (!m_Cache[entry_idx].busy &&
+            m_Cache[entry_idx].configuration == mcConfiguration)
+        {
+            m_Cache.prepend(m_Cache.takeAt(entry_idx));
+            return 0;
+        }
+    }
+
+    LIC * renderer = new LIC();
+    renderer -> SetProgressMode(ProgressReporter::Mode_Quiet);
+    renderer -> SetNumThreads(m_NumThreads);
+    renderer -> SetScheduler(m_Scheduler);
+    if (!renderer -> SetXMLConfiguration(QString::fromUtf8(mcConfiguration)))
+    {
+        delete renderer;
+        mrMessage = "Invalid configuration; see the log of the server.";
+        return -1;
+    }
+    if (renderer -> HasSweep())
+    {
+        delete renderer;
+        mrMessage = "Sweeps cannot be rendered by the server.";
+        return -1;
+    }
+
+    // Planes of the entry with the most in common are moved over (the
+    // traced image is only valid together with its noise); that entry is
+    // replaced, since its configuration is no longer needed as often
+    const QString noise_key = renderer -> GetNoiseKey();
+    const QString tracing_key = renderer -> GetTracingKey();
+    int match_idx = -1;
+    for (int entry_idx = 0; entry_idx < m_Cache.size(); entry_idx++)
+    {
+        if (m_Cache[entry_idx].busy)
+        {
+            continue;
+        }
+        if (m_Cache[entry_idx].tracing_key == tracing_key)
+        {
+            match_idx = entry_idx;
+            break;
+        }
+        if (match_idx < 0 &&
+            m_Cache[entry_idx].noise_key == noise_key)
+        {
+            match_idx = entry_idx;
+        }
+    }
+    CacheEntry entry;
+    if (match_idx >= 0)
+    {
+        entry = m_Cache.takeAt(match_idx);
+        LIC * previous = entry.renderer;
+        renderer -> AdoptNoisePlanes(previous -> TakeNoisePlanes());
+        renderer -> AdoptTracedPlanes(previous -> TakeTracedPlanes());
+        delete previous;
+    }
+    entry.renderer = renderer;
+    entry.configuration = mcConfiguration;
+    m_Cache.prepend(entry);
+    return 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Drop least recently used entries
+void RenderServer::TrimCache()
+{
+    // Busy entries are being written to, so their size is unknown; they
+    // are counted when they are done
+    qint64 total_size = 0;
+    for (const CacheEntry & entry : m_Cache)
+    {
+        total_size += (entry.busy ? 0 : GetEntrySize(entry));
+    }
+    for (int entry_idx = m_Cache.size() - 1;
+         entry_idx > 0 && total_size > m_CacheSize;
+         entry_idx--)
+    {
+        if (m_Cache[entry_idx].busy)
+        {
+            continue;
+        }
+        const CacheEntry entry = m_Cache.takeAt(entry_idx);
+        total_size -= GetEntrySize(entry);
+        delete entry.renderer;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Bytes of the planes of an entry
+qint64 RenderServer::GetEntrySize(const CacheEntry & mcEntry)
+{
+    const LIC * renderer = mcEntry.renderer;
+    qint64 num_values = 0;
+    for (const QList < double > & plane : renderer -> GetNoisePlanes() +
+        renderer -> GetTracedPlanes())
+    {
+        num_values += plane.size();
+    }
+    return num_values * qint64(sizeof(double));
+}
@@ -0,0 +1,156 @@
+// RenderServer.h
+// Class definition
+
+#ifndef RENDERSERVER_H
+#define RENDERSERVER_H
+
+// Qt includes
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+
+// System includes
+#include <map>
+#include <thread>
+
+// Forward declaration
+class LIC;
+class TileScheduler;
+
+
+
+// Define class
+class RenderServer
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor
+    RenderServer(const QString mcSocketName);
+
+    // Destructor; cancels requests still being rendered
+    virtual ~RenderServer();
+
+
+
+    // ========================================================== Configuration
+public:
+    // Number of threads used for tracing (0: one per core)
+    void SetNumThreads(int mNumThreads);
+
+    // Memory for noise and traced images kept between requests
+    void SetCacheSize(qint64 mBytes);
+
+private:
+    QString m_SocketName;
+    int m_NumThreads;
+    qint64 m_CacheSize;
+
+
+
+    // ========================================================== Functionality
+public:
+    // Serve requests on a local socket until the application quits.
+    //
+    // A request is a QDataStream (Qt 6.0) of
+    //     QString format ("png", "rgbx8", or "rgb_float")
+    //     QByteArray configuration (XML text, as in a configuration file)
+    //     qint32 priority (higher first)
+    //     qint32 deadline (milliseconds from now; 0: none)
+    // and is answered with
+    //     bool success
+    //     QString message (why it failed)
+    //     qint32 width, qint32 height
+    //     QByteArray data (PNG file, or lines of pixels from the top)
+    //     double seconds (spent in the server)
+    //     QString stages (the ones that ran; "image" only if warm)
+    // A connection may send any number of requests; they are answered in
+    // order. Requests of different connections are rendered at the same
+    // time, and their tiles are traced by priority and deadline, so a
+    // preview doesn't wait for a poster. Closing the connection cancels
+    // its request. Outputs, sweeps, and pyramids of the configuration are
+    // ignored; the image is returned instead.
+    int Execute();
+
+    // Pixel formats a request can ask for
+    static QStringList GetFormats();
+
+private:
+    // Client connected
+    void NewConnection();
+
+    // Start the next request of a connection, unless one is running
+    void ReadRequests(QLocalSocket * mpSocket);
+
+    // Answer of a request
+    struct Result
+    {
+        bool success = false;
+        QString message;
+        int width = 0;
+        int height = 0;
+        QByteArray data;
+        QStringList stages;
+
+        // What the planes of the renderer hold now
+        QString noise_key;
+        QString tracing_key;
+    };
+    void WriteResult(QLocalSocket * mpSocket, const Result & mcResult,
+        double mSeconds);
+
+    // Render a configuration into a PNG file or a raw buffer; runs on a
+    // thread of its own, and only touches the renderer
+    static Result Render(LIC * mpRenderer, const QString mcFormat,
+        const QString mcNoiseKey, const QString mcTracingKey);
+
+    // Request has been rendered
+    void RenderFinished(QPointer < QLocalSocket > mpSocket,
+        LIC * mpRenderer, const Result & mcResult, double mSeconds);
+
+    // A renderer for a configuration, with whatever it can reuse from
+    // earlier requests moved into it. Entries being rendered are busy and
+    // left alone until they are done.
+    struct CacheEntry
+    {
+        LIC * renderer = nullptr;
+
+        // Text of the last configuration; the same text again isn't even
+        // parsed
+        QByteArray configuration;
+
+        // What the planes have been computed for (empty: nothing valid)
+        QString noise_key;
+        QString tracing_key;
+
+        bool busy = false;
+    };
+    int AcquireEntry(const QByteArray & mcConfiguration,
+        QString & mrMessage);
+
+    // Drop the least recently used entries until they fit into the cache
+    // size; the most recent one and busy ones are always kept
+    void TrimCache();
+
+    // Bytes of the planes of an entry
+    static qint64 GetEntrySize(const CacheEntry & mcEntry);
+
+    // Most recently used first
+    QList < CacheEntry > m_Cache;
+
+    // Requests being rendered, by connection and by renderer
+    QHash < QLocalSocket *, LIC * > m_Running;
+    std::map < LIC *, std::thread > m_RenderThreads;
+
+    // Threads are started once, not for every request, and go to the most
+    // urgent request at every tile
+    TileScheduler * m_Scheduler;
+
+    QLocalServer m_Server;
+};
+
+#endif
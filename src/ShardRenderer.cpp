@@ -0,0 +1,407 @@
+// ShardRenderer.cpp
+// Class implementation
+
+// Project includes
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "ShardRenderer.h"
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QFile>
+#include <QSaveFile>
+
+// System includes
+#include <cstring>
+
+
+
+// Version of the file layout; increase when it changes
+static const qint32 SHARD_FILE_VERSION = 1;
+
+// Start of every file
+static const char SHARD_FILE_MAGIC[8] = { 'L', 'I', 'C', 'S', 'H', 'A', 'R',
+    'D' };
+
+// Layout: header, then every tile of the shard as a tile header and the
+// pixels of the tile in all four planes (red, green, blue, strength), each
+// plane column by column like the planes of the renderer. The range of
+// values of the shard's pixels is in the header; the merge combines them
+// instead of looking at all pixels again.
+struct ShardFileHeader
+{
+    char magic[8];
+    qint32 version;
+    qint32 shard;
+    qint32 num_shards;
+    qint32 width;
+    qint32 height;
+    qint32 num_tiles;
+    qint32 rect_x;
+    qint32 rect_y;
+    qint32 rect_width;
+    qint32 rect_height;
+    char key_hash[32];
+    double min_intensity;
+    double max_intensity;
+    double min_strength;
+    double max_strength;
+};
+struct ShardTileHeader
+{
+    qint32 tile;
+    qint32 num_pixels;
+};
+
+// Hash of the configuration a shard was traced for
+static QByteArray GetKeyHash(const QString mcKey)
+{
+    return QCryptographicHash::hash(mcKey.toUtf8(),
+        QCryptographicHash::Sha256);
+}
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+ShardRenderer::ShardRenderer(LIC * mpLIC)
+{
+    m_LIC = mpLIC;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+ShardRenderer::~ShardRenderer()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Trace a share of the tiles
+bool ShardRenderer::Render(int mShard, int mNumShards)
+{
+    if (!CheckConfiguration(mNumShards))
+    {
+        return false;
+    }
+    if (mShard < 0 ||
+        mShard >= mNumShards)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid shard %1; must be 0 to %2.")
+                .arg(QString::number(mShard),
+                     QString::number(mNumShards - 1)));
+        return false;
+    }
+    LIC & lic = *m_LIC;
+    PerformanceReport & report = lic.GetMutablePerformanceReport();
+    lic.ResetCancel();
+    report.SetInfo("shard", QString("%1/%2").arg(QString::number(mShard),
+        QString::number(mNumShards)));
+
+    // Noise
+    lic.RunStage("GenerateNoise",
+        [&lic]()
+        {
+            lic.GenerateNoise();
+            return true;
+        });
+
+    // Only the tiles of this shard; the others count as done
+    const QRect rect = lic.GetTraceRect();
+    const QList < int > tiles = lic.GetShardTiles(mShard, mNumShards, rect);
+    QList < bool > tiles_done(lic.GetNumTiles(), true);
+    for (int tile : tiles)
+    {
+        tiles_done[tile] = false;
+    }
+    lic.AllocateTracedPlanes();
+    const bool traced = lic.RunStage("GenerateLIC",
+        [&lic, &rect, &tiles_done]()
+        {
+            return lic.TraceTargets({ lic.GetImageTarget() }, rect,
+                &tiles_done);
+        });
+    if (!traced)
+    {
+        MessageLogger::Error(METHOD_NAME, "Rendering has been cancelled.");
+        return false;
+    }
+    report.SetCounter("tiles", int(tiles.size()));
+
+    // Range of the shard's pixels
+    report.StartStage("WriteShard");
+    LIC::Normalization normalization;
+    for (int tile : tiles)
+    {
+        const LIC::Normalization tile_normalization =
+            lic.GetNormalization(lic.GetTilePixels(tile, rect));
+        normalization.min_intensity = qMin(normalization.min_intensity,
+            tile_normalization.min_intensity);
+        normalization.max_intensity = qMax(normalization.max_intensity,
+            tile_normalization.max_intensity);
+        normalization.min_strength = qMin(normalization.min_strength,
+            tile_normalization.min_strength);
+        normalization.max_strength = qMax(normalization.max_strength,
+            tile_normalization.max_strength);
+    }
+
+    // Header
+    ShardFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHARD_FILE_MAGIC, sizeof(header.magic));
+    header.version = SHARD_FILE_VERSION;
+    header.shard = mShard;
+    header.num_shards = mNumShards;
+    header.width = lic.GetImageWidth();
+    header.height = lic.GetImageHeight();
+    header.num_tiles = tiles.size();
+    header.rect_x = rect.x();
+    header.rect_y = rect.y();
+    header.rect_width = rect.width();
+    header.rect_height = rect.height();
+    const QByteArray key_hash = GetKeyHash(lic.GetTracingKey(rect));
+    memcpy(header.key_hash, key_hash.constData(), sizeof(header.key_hash));
+    header.min_intensity = normalization.min_intensity;
+    header.max_intensity = normalization.max_intensity;
+    header.min_strength = normalization.min_strength;
+    header.max_strength = normalization.max_strength;
+
+    // Tiles; the file only appears when it is complete, so a merge never
+    // reads half a shard
+    const QString filename = GetShardFilename(mShard, mNumShards);
+    QSaveFile shard_file(filename);
+    bool success = shard_file.open(QIODevice::WriteOnly) &&
+        shard_file.write(reinterpret_cast < const char * >(&header),
+            sizeof(header)) == qint64(sizeof(header));
+    const LIC::TraceTarget target = lic.GetImageTarget();
+    const QList < const double * > planes({ target.lic_r, target.lic_g,
+        target.lic_b, target.lic_strength });
+    for (int tile : tiles)
+    {
+        const QRect pixels = lic.GetTilePixels(tile, rect);
+        ShardTileHeader tile_header;
+        tile_header.tile = tile;
+        tile_header.num_pixels = pixels.width() * pixels.height();
+        success = success &&
+            shard_file.write(reinterpret_cast < const char * >(&tile_header),
+                sizeof(tile_header)) == qint64(sizeof(tile_header));
+        const qint64 column_bytes =
+            pixels.height() * qint64(sizeof(double));
+        for (const double * plane : planes)
+        {
+            for (int ix = pixels.left(); ix <= pixels.right(); ix++)
+            {
+                const double * column = plane +
+                    qint64(ix) * lic.GetImageHeight() + pixels.top();
+                success = success &&
+                    shard_file.write(
+                        reinterpret_cast < const char * >(column),
+                        column_bytes) == column_bytes;
+            }
+        }
+    }
+    success = success && shard_file.commit();
+    report.EndStage("WriteShard");
+    if (!success)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Shard \"%1\" could not be written.").arg(filename));
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Assemble all shards and write the outputs
+bool ShardRenderer::Merge(int mNumShards)
+{
+    if (!CheckConfiguration(mNumShards))
+    {
+        return false;
+    }
+    LIC & lic = *m_LIC;
+    PerformanceReport & report = lic.GetMutablePerformanceReport();
+    report.StartStage("ReadShards");
+
+    const QRect rect = lic.GetTraceRect();
+    const QByteArray key_hash = GetKeyHash(lic.GetTracingKey(rect));
+    lic.AllocateTracedPlanes();
+    const LIC::TraceTarget target = lic.GetImageTarget();
+    const QList < double * > planes({ target.lic_r, target.lic_g,
+        target.lic_b, target.lic_strength });
+
+    // Every tile must come from exactly one shard
+    QList < bool > tiles_merged(lic.GetNumTiles(), false);
+    LIC::Normalization normalization;
+    bool success = true;
+    for (int shard = 0; success && shard < mNumShards; shard++)
+    {
+        const QString filename = GetShardFilename(shard, mNumShards);
+        QFile shard_file(filename);
+        const uchar * data = nullptr;
+        if (!shard_file.open(QIODevice::ReadOnly) ||
+            shard_file.size() < qint64(sizeof(ShardFileHeader)) ||
+            !(data = shard_file.map(0, shard_file.size())))
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Shard \"%1\" could not be read.").arg(filename));
+            success = false;
+            break;
+        }
+
+        // Same configuration, and the shard it claims to be
+        ShardFileHeader header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, SHARD_FILE_MAGIC,
+                sizeof(header.magic)) != 0 ||
+            header.version != SHARD_FILE_VERSION ||
+            header.shard != shard ||
+            header.num_shards != mNumShards ||
+            header.width != lic.GetImageWidth() ||
+            header.height != lic.GetImageHeight() ||
+            QRect(header.rect_x, header.rect_y, header.rect_width,
+                header.rect_height) != rect ||
+            memcmp(header.key_hash, key_hash.constData(),
+                sizeof(header.key_hash)) != 0)
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Shard \"%1\" has not been rendered for this "
+                    "configuration.").arg(filename));
+            success = false;
+            break;
+        }
+        normalization.min_intensity =
+            qMin(normalization.min_intensity, header.min_intensity);
+        normalization.max_intensity =
+            qMax(normalization.max_intensity, header.max_intensity);
+        normalization.min_strength =
+            qMin(normalization.min_strength, header.min_strength);
+        normalization.max_strength =
+            qMax(normalization.max_strength, header.max_strength);
+
+        // Tiles
+        qint64 offset = sizeof(header);
+        for (int tile_idx = 0; success && tile_idx < header.num_tiles;
+             tile_idx++)
+        {
+            ShardTileHeader tile_header;
+            success = (offset + qint64(sizeof(tile_header)) <=
+                shard_file.size());
+            if (success)
+            {
+                memcpy(&tile_header, data + offset, sizeof(tile_header));
+                offset += sizeof(tile_header);
+            }
+            const int tile = tile_header.tile;
+            success = success &&
+                tile >= 0 &&
+                tile < tiles_merged.size() &&
+                !tiles_merged[tile];
+            const QRect pixels =
+                (success ? lic.GetTilePixels(tile, rect) : QRect());
+            const qint64 column_bytes =
+                pixels.height() * qint64(sizeof(double));
+            success = success &&
+                tile_header.num_pixels == pixels.width() * pixels.height() &&
+                offset + 4 * pixels.width() * column_bytes <=
+                    shard_file.size();
+            if (!success)
+            {
+                MessageLogger::Error(METHOD_NAME,
+                    QString("Shard \"%1\" is damaged.").arg(filename));
+                break;
+            }
+            for (double * plane : planes)
+            {
+                for (int ix = pixels.left(); ix <= pixels.right(); ix++)
+                {
+                    memcpy(plane + qint64(ix) * lic.GetImageHeight() +
+                        pixels.top(), data + offset, column_bytes);
+                    offset += column_bytes;
+                }
+            }
+            tiles_merged[tile] = true;
+        }
+        shard_file.unmap(const_cast < uchar * >(data));
+    }
+
+    // Nothing missing
+    for (int tile = 0; success && tile < tiles_merged.size(); tile++)
+    {
+        if (!tiles_merged[tile] &&
+            !lic.GetTilePixels(tile, rect).isEmpty())
+        {
+            MessageLogger::Error(METHOD_NAME,
+                QString("Tile %1 is in none of the shards.")
+                    .arg(QString::number(tile)));
+            success = false;
+        }
+    }
+    report.EndStage("ReadShards");
+    if (!success)
+    {
+        return false;
+    }
+
+    // Outputs, with the range of all shards
+    return lic.RunStage("GenerateImage",
+        [&lic, &rect, &normalization]()
+        {
+            return lic.WriteOutputs(rect, &normalization);
+        });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File of a shard
+QString ShardRenderer::GetShardFilename(int mShard, int mNumShards) const
+{
+    return QString("%1.shard-%2-of-%3")
+        .arg(m_LIC -> GetOutputs().first().filename, QString::number(mShard),
+            QString::number(mNumShards));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration can be sharded
+bool ShardRenderer::CheckConfiguration(int mNumShards) const
+{
+    if (!m_LIC -> IsValid() ||
+        m_LIC -> GetOutputs().isEmpty())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Set of parameters isn't valid; can't execute."));
+        return false;
+    }
+    if (m_LIC -> HasSweep() ||
+        m_LIC -> HasPyramid())
+    {
+        MessageLogger::Error(METHOD_NAME,
+            "Sweeps and pyramids cannot be rendered in shards.");
+        return false;
+    }
+    if (mNumShards < 1)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Invalid number of shards %1.")
+                .arg(QString::number(mNumShards)));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+// ShardRenderer.h
+// Class definition
+
+#ifndef SHARDRENDERER_H
+#define SHARDRENDERER_H
+
+// Project includes
+#include "LIC.h"
+
+// Qt includes
+#include <QString>
+
+
+
+// Define class
+class ShardRenderer
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; renders shards of a configured renderer, or merges them
+    // into its outputs
+    ShardRenderer(LIC * mpLIC);
+
+    // Destructor
+    virtual ~ShardRenderer();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Trace a deterministic share of the tiles (shard mShard of
+    // mNumShards) and write it to the shard file. Shards need nothing from
+    // each other, so they can run on different machines.
+    bool Render(int mShard, int mNumShards);
+
+    // Assemble all shard files into the traced image and write the outputs.
+    // Normalization combines the ranges of all shards, so the outputs are
+    // the same as if the image had been rendered in one process.
+    bool Merge(int mNumShards);
+
+    // File of a shard, next to the first output ("out.png.shard-3-of-8")
+    QString GetShardFilename(int mShard, int mNumShards) const;
+
+private:
+    // Configuration can be sharded
+    bool CheckConfiguration(int mNumShards) const;
+
+    LIC * m_LIC;
+};
+
+#endif
@@ -0,0 +1,92 @@
+// SimdKernels.h
+// Class definition
+
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+// Qt includes
+#include <QtGlobal>
+
+// Vector kernels need x86 and a compiler that can build functions for
+// instruction sets the rest of the binary doesn't assume
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIC_SIMD_X86
+#endif
+
+
+
+// Define class
+class SimdKernels
+{
+    // ================================================================ Kernels
+public:
+    // Kernels work on segments of columns of the planes, which are
+    // contiguous in memory, and give the same results for every
+    // instruction set. Longest segment of the color kernel:
+    static const int MAX_SEGMENT = 64;
+
+    // Range of a segment, added to mpRange (smallest and largest value of
+    // all color channels, smallest and largest strength). Returns false if
+    // there is a NaN; then the range depends on the order of the values,
+    // and mpRange is undefined.
+    bool (*min_max)(const double * mcpR, const double * mcpG,
+        const double * mcpB, const double * mcpStrength, int mNum,
+        double * mpRange);
+
+    // How colors are computed from the planes (see LIC::GenerateImage())
+    struct ColorParameters
+    {
+        // Segment of the planes
+        const double * lic_r;
+        const double * lic_g;
+        const double * lic_b;
+        const double * lic_strength;
+
+        // Intensity mapped to [0, 255] (false: white)
+        bool use_intensity;
+        double min_intensity;
+        double intensity_scale;
+
+        // Colormap (nullptr: none), indexed by the scaled strength
+        const float * lut_r;
+        const float * lut_g;
+        const float * lut_b;
+        int lut_size;
+        bool log_scale;
+        double min_strength;
+        double strength_scale;
+    };
+
+    // Colors in [0, 255] of a segment of at most MAX_SEGMENT pixels
+    void (*color)(const ColorParameters & mcParameters, int mNum,
+        double * mpRed, double * mpGreen, double * mpBlue);
+
+    // Noise that only depends on the seed and the position, for mNum
+    // positions from (mX, mY) downwards
+    void (*position_noise)(int mSeed, int mX, int mY, int mNum,
+        double * mpValues);
+
+    // Uniform random number in [0, 1) that only depends on the seed and
+    // the position (SplitMix64 finalizer)
+    static double GetPositionNoise(int mSeed, int mX, int mY);
+
+    // Color of one pixel of a segment; kernels use it for what is left
+    // over after their full vectors
+    static void ColorPixel(const ColorParameters & mcParameters,
+        const double * mcpScaledStrength, int mIdx, double * mpRed,
+        double * mpGreen, double * mpBlue);
+
+    // Strength of a segment as it is mapped to colors; mpBuffer is used if
+    // it's on a log scale
+    static const double * GetScaledStrength(
+        const ColorParameters & mcParameters, int mNum, double * mpBuffer);
+
+    // Kernels for each instruction set. Those that can't be built for this
+    // platform are the generic ones.
+    static const SimdKernels & GetGeneric();
+    static const SimdKernels & GetSSE42();
+    static const SimdKernels & GetAVX2();
+    static const SimdKernels & GetAVX512();
+};
+
+#endif
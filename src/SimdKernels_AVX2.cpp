@@ -0,0 +1,249 @@
+// SimdKernels_AVX2.cpp
+// Kernels for AVX2 (four doubles per vector)
+
+// Project includes
+#include "SimdKernels.h"
+
+// System includes
+#if defined(LIC_SIMD_X86)
+#include <immintrin.h>
+#include <limits>
+#endif
+
+
+
+#if defined(LIC_SIMD_X86)
+
+#define LIC_TARGET __attribute__((target("avx2")))
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Range of a segment
+LIC_TARGET static bool MinMax_AVX2(const double * mcpR, const double * mcpG,
+    const double * mcpB, const double * mcpStrength, int mNum,
+    double * mpRange)
+{
+    const double infinity = std::numeric_limits < double >::infinity();
+    __m256d min_color = _mm256_set1_pd(infinity);
+    __m256d max_color = _mm256_set1_pd(-infinity);
+    __m256d min_strength = _mm256_set1_pd(infinity);
+    __m256d max_strength = _mm256_set1_pd(-infinity);
+    __m256d nan = _mm256_setzero_pd();
+    int idx = 0;
+    for ( ; idx + 4 <= mNum; idx += 4)
+    {
+        const __m256d r = _mm256_loadu_pd(mcpR + idx);
+        const __m256d g = _mm256_loadu_pd(mcpG + idx);
+        const __m256d b = _mm256_loadu_pd(mcpB + idx);
+        const __m256d s = _mm256_loadu_pd(mcpStrength + idx);
+        nan = _mm256_or_pd(nan, _mm256_or_pd(_mm256_cmp_pd(r, g, _CMP_UNORD_Q),
+            _mm256_cmp_pd(b, s, _CMP_UNORD_Q)));
+        min_color = _mm256_min_pd(min_color,
+            _mm256_min_pd(r, _mm256_min_pd(g, b)));
+        max_color = _mm256_max_pd(max_color,
+            _mm256_max_pd(r, _mm256_max_pd(g, b)));
+        min_strength = _mm256_min_pd(min_strength, s);
+        max_strength = _mm256_max_pd(max_strength, s);
+    }
+    if (_mm256_movemask_pd(nan))
+    {
+        return false;
+    }
+
+    // Lanes
+    double lanes[4][4];
+    _mm256_storeu_pd(lanes[0], min_color);
+    _mm256_storeu_pd(lanes[1], max_color);
+    _mm256_storeu_pd(lanes[2], min_strength);
+    _mm256_storeu_pd(lanes[3], max_strength);
+    for (int lane = 0; lane < 4; lane++)
+    {
+        mpRange[0] = qMin(mpRange[0], lanes[0][lane]);
+        mpRange[1] = qMax(mpRange[1], lanes[1][lane]);
+        mpRange[2] = qMin(mpRange[2], lanes[2][lane]);
+        mpRange[3] = qMax(mpRange[3], lanes[3][lane]);
+    }
+
+    // Rest
+    return SimdKernels::GetGeneric().min_max(mcpR + idx, mcpG + idx,
+        mcpB + idx, mcpStrength + idx, mNum - idx, mpRange);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Intensity of one channel mapped to [0, 255]
+LIC_TARGET static inline __m256d Intensity_AVX2(const double * mcpValues,
+    __m256d mMinIntensity, __m256d mIntensityScale)
+{
+    // Same as qBound(0., value, 255.), which maps NaN to 0
+    const __m256d value = _mm256_mul_pd(
+        _mm256_sub_pd(_mm256_loadu_pd(mcpValues), mMinIntensity),
+        mIntensityScale);
+    return _mm256_max_pd(_mm256_min_pd(_mm256_set1_pd(255.), value),
+        _mm256_setzero_pd());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Colors of a segment
+LIC_TARGET static void Color_AVX2(
+    const SimdKernels::ColorParameters & mcParameters, int mNum,
+    double * mpRed, double * mpGreen, double * mpBlue)
+{
+    double buffer[SimdKernels::MAX_SEGMENT];
+    const double * strength =
+        SimdKernels::GetScaledStrength(mcParameters, mNum, buffer);
+
+    const __m256d white = _mm256_set1_pd(255.);
+    const __m256d min_intensity = _mm256_set1_pd(mcParameters.min_intensity);
+    const __m256d intensity_scale =
+        _mm256_set1_pd(mcParameters.intensity_scale);
+    const __m256d min_strength = _mm256_set1_pd(mcParameters.min_strength);
+    const __m256d strength_scale =
+        _mm256_set1_pd(mcParameters.strength_scale);
+    const __m128i first_entry = _mm_setzero_si128();
+    const __m128i last_entry = _mm_set1_epi32(mcParameters.lut_size - 1);
+    int idx = 0;
+    for ( ; idx + 4 <= mNum; idx += 4)
+    {
+        __m256d red = white;
+        __m256d green = white;
+        __m256d blue = white;
+        if (mcParameters.use_intensity)
+        {
+            red = Intensity_AVX2(mcParameters.lic_r + idx, min_intensity,
+                intensity_scale);
+            green = Intensity_AVX2(mcParameters.lic_g + idx, min_intensity,
+                intensity_scale);
+            blue = Intensity_AVX2(mcParameters.lic_b + idx, min_intensity,
+                intensity_scale);
+        }
+        if (mcParameters.lut_r)
+        {
+            // Truncated like int(); values out of range become INT_MIN
+            __m128i entry = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_sub_pd(
+                _mm256_loadu_pd(strength + idx), min_strength),
+                strength_scale));
+            entry = _mm_min_epi32(_mm_max_epi32(entry, first_entry),
+                last_entry);
+            red = _mm256_mul_pd(red, _mm256_cvtps_pd(
+                _mm_i32gather_ps(mcParameters.lut_r, entry, 4)));
+            green = _mm256_mul_pd(green, _mm256_cvtps_pd(
+                _mm_i32gather_ps(mcParameters.lut_g, entry, 4)));
+            blue = _mm256_mul_pd(blue, _mm256_cvtps_pd(
+                _mm_i32gather_ps(mcParameters.lut_b, entry, 4)));
+        }
+        _mm256_storeu_pd(mpRed + idx, red);
+        _mm256_storeu_pd(mpGreen + idx, green);
+        _mm256_storeu_pd(mpBlue + idx, blue);
+    }
+
+    // Rest
+    for ( ; idx < mNum; idx++)
+    {
+        SimdKernels::ColorPixel(mcParameters, strength, idx, mpRed, mpGreen,
+            mpBlue);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Low 64 bits of the products of the lanes
+LIC_TARGET static inline __m256i MultiplyLow64(__m256i mA, __m256i mB)
+{
+    const __m256i low = _mm256_mul_epu32(mA, mB);
+    const __m256i cross = _mm256_add_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(mA, 32), mB),
+        _mm256_mul_epu32(mA, _mm256_srli_epi64(mB, 32)));
+    return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Position noise of a segment
+LIC_TARGET static void PositionNoise_AVX2(int mSeed, int mX, int mY,
+    int mNum, double * mpValues)
+{
+    // The hash is stepped along the column, which only works while the
+    // unsigned row doesn't wrap
+    if (mY < 0 &&
+        mY + mNum > 0)
+    {
+        SimdKernels::GetGeneric().position_noise(mSeed, mX, mY, mNum,
+            mpValues);
+        return;
+    }
+
+    const quint64 row_factor = 0x94D049BB133111EBull;
+    const quint64 first = quint64(quint32(mSeed)) * 0x9E3779B97F4A7C15ull +
+        quint64(quint32(mX)) * 0xBF58476D1CE4E5B9ull +
+        quint64(quint32(mY)) * row_factor;
+    __m256i z = _mm256_set_epi64x(qint64(first + 3 * row_factor),
+        qint64(first + 2 * row_factor), qint64(first + row_factor),
+        qint64(first));
+    const __m256i step = _mm256_set1_epi64x(qint64(4 * row_factor));
+    const __m256i factor_1 =
+        _mm256_set1_epi64x(qint64(0xBF58476D1CE4E5B9ull));
+    const __m256i factor_2 =
+        _mm256_set1_epi64x(qint64(0x94D049BB133111EBull));
+
+    // 53 bits are converted exactly in two halves
+    const __m256i low_mask = _mm256_set1_epi64x(0xFFFFFFFFll);
+    const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000ll);
+    const __m256d magic = _mm256_set1_pd(4503599627370496.);
+    const __m256d high_scale = _mm256_set1_pd(4294967296.);
+    const __m256d scale = _mm256_set1_pd(1. / (quint64(1) << 53));
+    int idx = 0;
+    for ( ; idx + 4 <= mNum; idx += 4)
+    {
+        __m256i hash = MultiplyLow64(
+            _mm256_xor_si256(z, _mm256_srli_epi64(z, 30)), factor_1);
+        hash = MultiplyLow64(
+            _mm256_xor_si256(hash, _mm256_srli_epi64(hash, 27)), factor_2);
+        hash = _mm256_srli_epi64(
+            _mm256_xor_si256(hash, _mm256_srli_epi64(hash, 31)), 11);
+        const __m256d low = _mm256_sub_pd(_mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_and_si256(hash, low_mask), magic_bits)),
+            magic);
+        const __m256d high = _mm256_sub_pd(_mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_srli_epi64(hash, 32), magic_bits)),
+            magic);
+        _mm256_storeu_pd(mpValues + idx, _mm256_mul_pd(
+            _mm256_add_pd(_mm256_mul_pd(high, high_scale), low), scale));
+        z = _mm256_add_epi64(z, step);
+    }
+
+    // Rest
+    for ( ; idx < mNum; idx++)
+    {
+        mpValues[idx] = SimdKernels::GetPositionNoise(mSeed, mX, mY + idx);
+    }
+}
+
+#undef LIC_TARGET
+
+#endif
+
+
+
+// ================================================================ Kernels
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels for AVX2
+const SimdKernels & SimdKernels::GetAVX2()
+{
+#if defined(LIC_SIMD_X86)
+    static const SimdKernels kernels = { MinMax_AVX2, Color_AVX2,
+        PositionNoise_AVX2 };
+    return kernels;
+#else
+    return GetGeneric();
+#endif
+}
@@ -0,0 +1,225 @@
+// SimdKernels_AVX512.cpp
+// Kernels for AVX-512 (eight doubles per vector)
+
+// Project includes
+#include "SimdKernels.h"
+
+// System includes
+#if defined(LIC_SIMD_X86)
+#include <immintrin.h>
+#include <limits>
+#endif
+
+
+
+#if defined(LIC_SIMD_X86)
+
+// 64-bit products and conversions need the DQ extension
+#define LIC_TARGET __attribute__((target("avx512f,avx512dq")))
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Range of a segment
+LIC_TARGET static bool MinMax_AVX512(const double * mcpR,
+    const double * mcpG, const double * mcpB, const double * mcpStrength,
+    int mNum, double * mpRange)
+{
+    const double infinity = std::numeric_limits < double >::infinity();
+    __m512d min_color = _mm512_set1_pd(infinity);
+    __m512d max_color = _mm512_set1_pd(-infinity);
+    __m512d min_strength = _mm512_set1_pd(infinity);
+    __m512d max_strength = _mm512_set1_pd(-infinity);
+    __mmask8 nan = 0;
+    int idx = 0;
+    for ( ; idx + 8 <= mNum; idx += 8)
+    {
+        const __m512d r = _mm512_loadu_pd(mcpR + idx);
+        const __m512d g = _mm512_loadu_pd(mcpG + idx);
+        const __m512d b = _mm512_loadu_pd(mcpB + idx);
+        const __m512d s = _mm512_loadu_pd(mcpStrength + idx);
+        nan |= _mm512_cmp_pd_mask(r, g, _CMP_UNORD_Q) |
+            _mm512_cmp_pd_mask(b, s, _CMP_UNORD_Q);
+        min_color = _mm512_min_pd(min_color,
+            _mm512_min_pd(r, _mm512_min_pd(g, b)));
+        max_color = _mm512_max_pd(max_color,
+            _mm512_max_pd(r, _mm512_max_pd(g, b)));
+        min_strength = _mm512_min_pd(min_strength, s);
+        max_strength = _mm512_max_pd(max_strength, s);
+    }
+    if (nan)
+    {
+        return false;
+    }
+
+    // Lanes
+    double lanes[4][8];
+    _mm512_storeu_pd(lanes[0], min_color);
+    _mm512_storeu_pd(lanes[1], max_color);
+    _mm512_storeu_pd(lanes[2], min_strength);
+    _mm512_storeu_pd(lanes[3], max_strength);
+    for (int lane = 0; lane < 8; lane++)
+    {
+        mpRange[0] = qMin(mpRange[0], lanes[0][lane]);
+        mpRange[1] = qMax(mpRange[1], lanes[1][lane]);
+        mpRange[2] = qMin(mpRange[2], lanes[2][lane]);
+        mpRange[3] = qMax(mpRange[3], lanes[3][lane]);
+    }
+
+    // Rest
+    return SimdKernels::GetGeneric().min_max(mcpR + idx, mcpG + idx,
+        mcpB + idx, mcpStrength + idx, mNum - idx, mpRange);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Intensity of one channel mapped to [0, 255]
+LIC_TARGET static inline __m512d Intensity_AVX512(const double * mcpValues,
+    __m512d mMinIntensity, __m512d mIntensityScale)
+{
+    // Same as qBound(0., value, 255.), which maps NaN to 0
+    const __m512d value = _mm512_mul_pd(
+        _mm512_sub_pd(_mm512_loadu_pd(mcpValues), mMinIntensity),
+        mIntensityScale);
+    return _mm512_max_pd(_mm512_min_pd(_mm512_set1_pd(255.), value),
+        _mm512_setzero_pd());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Colors of a segment
+LIC_TARGET static void Color_AVX512(
+    const SimdKernels::ColorParameters & mcParameters, int mNum,
+    double * mpRed, double * mpGreen, double * mpBlue)
+{
+    double buffer[SimdKernels::MAX_SEGMENT];
+    const double * strength =
+        SimdKernels::GetScaledStrength(mcParameters, mNum, buffer);
+
+    const __m512d white = _mm512_set1_pd(255.);
+    const __m512d min_intensity = _mm512_set1_pd(mcParameters.min_intensity);
+    const __m512d intensity_scale =
+        _mm512_set1_pd(mcParameters.intensity_scale);
+    const __m512d min_strength = _mm512_set1_pd(mcParameters.min_strength);
+    const __m512d strength_scale =
+        _mm512_set1_pd(mcParameters.strength_scale);
+    const __m256i first_entry = _mm256_setzero_si256();
+    const __m256i last_entry = _mm256_set1_epi32(mcParameters.lut_size - 1);
+    int idx = 0;
+    for ( ; idx + 8 <= mNum; idx += 8)
+    {
+        __m512d red = white;
+        __m512d green = white;
+        __m512d blue = white;
+        if (mcParameters.use_intensity)
+        {
+            red = Intensity_AVX512(mcParameters.lic_r + idx, min_intensity,
+                intensity_scale);
+            green = Intensity_AVX512(mcParameters.lic_g + idx, min_intensity,
+                intensity_scale);
+            blue = Intensity_AVX512(mcParameters.lic_b + idx, min_intensity,
+                intensity_scale);
+        }
+        if (mcParameters.lut_r)
+        {
+            // Truncated like int(); values out of range become INT_MIN
+            __m256i entry = _mm512_cvttpd_epi32(_mm512_mul_pd(_mm512_sub_pd(
+                _mm512_loadu_pd(strength + idx), min_strength),
+                strength_scale));
+            entry = _mm256_min_epi32(_mm256_max_epi32(entry, first_entry),
+                last_entry);
+            red = _mm512_mul_pd(red, _mm512_cvtps_pd(
+                _mm256_i32gather_ps(mcParameters.lut_r, entry, 4)));
+            green = _mm512_mul_pd(green, _mm512_cvtps_pd(
+                _mm256_i32gather_ps(mcParameters.lut_g, entry, 4)));
+            blue = _mm512_mul_pd(blue, _mm512_cvtps_pd(
+                _mm256_i32gather_ps(mcParameters.lut_b, entry, 4)));
+        }
+        _mm512_storeu_pd(mpRed + idx, red);
+        _mm512_storeu_pd(mpGreen + idx, green);
+        _mm512_storeu_pd(mpBlue + idx, blue);
+    }
+
+    // Rest
+    for ( ; idx < mNum; idx++)
+    {
+        SimdKernels::ColorPixel(mcParameters, strength, idx, mpRed, mpGreen,
+            mpBlue);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Position noise of a segment
+LIC_TARGET static void PositionNoise_AVX512(int mSeed, int mX, int mY,
+    int mNum, double * mpValues)
+{
+    // The hash is stepped along the column, which only works while the
+    // unsigned row doesn't wrap
+    if (mY < 0 &&
+        mY + mNum > 0)
+    {
+        SimdKernels::GetGeneric().position_noise(mSeed, mX, mY, mNum,
+            mpValues);
+        return;
+    }
+
+    const quint64 row_factor = 0x94D049BB133111EBull;
+    const quint64 first = quint64(quint32(mSeed)) * 0x9E3779B97F4A7C15ull +
+        quint64(quint32(mX)) * 0xBF58476D1CE4E5B9ull +
+        quint64(quint32(mY)) * row_factor;
+    __m512i z = _mm512_add_epi64(_mm512_set1_epi64(qint64(first)),
+        _mm512_mullo_epi64(_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0),
+            _mm512_set1_epi64(qint64(row_factor))));
+    const __m512i step = _mm512_set1_epi64(qint64(8 * row_factor));
+    const __m512i factor_1 = _mm512_set1_epi64(qint64(0xBF58476D1CE4E5B9ull));
+    const __m512i factor_2 = _mm512_set1_epi64(qint64(0x94D049BB133111EBull));
+    const __m512d scale = _mm512_set1_pd(1. / (quint64(1) << 53));
+    int idx = 0;
+    for ( ; idx + 8 <= mNum; idx += 8)
+    {
+        __m512i hash = _mm512_mullo_epi64(
+            _mm512_xor_si512(z, _mm512_srli_epi64(z, 30)), factor_1);
+        hash = _mm512_mullo_epi64(
+            _mm512_xor_si512(hash, _mm512_srli_epi64(hash, 27)), factor_2);
+        hash = _mm512_srli_epi64(
+            _mm512_xor_si512(hash, _mm512_srli_epi64(hash, 31)), 11);
+
+        // 53 bits are converted exactly
+        _mm512_storeu_pd(mpValues + idx,
+            _mm512_mul_pd(_mm512_cvtepu64_pd(hash), scale));
+        z = _mm512_add_epi64(z, step);
+    }
+
+    // Rest
+    for ( ; idx < mNum; idx++)
+    {
+        mpValues[idx] = SimdKernels::GetPositionNoise(mSeed, mX, mY + idx);
+    }
+}
+
+#undef LIC_TARGET
+
+#endif
+
+
+
+// ================================================================ Kernels
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels for AVX-512
+const SimdKernels & SimdKernels::GetAVX512()
+{
+#if defined(LIC_SIMD_X86)
+    static const SimdKernels kernels = { MinMax_AVX512, Color_AVX512,
+        PositionNoise_AVX512 };
+    return kernels;
+#else
+    return GetGeneric();
+#endif
+}
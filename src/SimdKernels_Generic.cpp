@@ -0,0 +1,152 @@
+// SimdKernels_Generic.cpp
+// Kernels without vector instructions; all other kernels give the same
+// results as these
+
+// Project includes
+#include "SimdKernels.h"
+
+// System includes
+#include <cmath>
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Range of a segment
+static bool MinMax_Generic(const double * mcpR, const double * mcpG,
+    const double * mcpB, const double * mcpStrength, int mNum,
+    double * mpRange)
+{
+    for (int idx = 0; idx < mNum; idx++)
+    {
+        if (std::isnan(mcpR[idx]) ||
+            std::isnan(mcpG[idx]) ||
+            std::isnan(mcpB[idx]) ||
+            std::isnan(mcpStrength[idx]))
+        {
+            return false;
+        }
+        mpRange[0] = qMin(mpRange[0],
+            qMin(mcpR[idx], qMin(mcpG[idx], mcpB[idx])));
+        mpRange[1] = qMax(mpRange[1],
+            qMax(mcpR[idx], qMax(mcpG[idx], mcpB[idx])));
+        mpRange[2] = qMin(mpRange[2], mcpStrength[idx]);
+        mpRange[3] = qMax(mpRange[3], mcpStrength[idx]);
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Colors of a segment
+static void Color_Generic(const SimdKernels::ColorParameters & mcParameters,
+    int mNum, double * mpRed, double * mpGreen, double * mpBlue)
+{
+    double buffer[SimdKernels::MAX_SEGMENT];
+    const double * strength =
+        SimdKernels::GetScaledStrength(mcParameters, mNum, buffer);
+    for (int idx = 0; idx < mNum; idx++)
+    {
+        SimdKernels::ColorPixel(mcParameters, strength, idx, mpRed, mpGreen,
+            mpBlue);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Position noise of a segment
+static void PositionNoise_Generic(int mSeed, int mX, int mY, int mNum,
+    double * mpValues)
+{
+    for (int idx = 0; idx < mNum; idx++)
+    {
+        mpValues[idx] = SimdKernels::GetPositionNoise(mSeed, mX, mY + idx);
+    }
+}
+
+
+
+// ================================================================ Kernels
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Uniform random number that only depends on the seed and the position
+double SimdKernels::GetPositionNoise(int mSeed, int mX, int mY)
+{
+    quint64 z = quint64(quint32(mSeed)) * 0x9E3779B97F4A7C15ull +
+        quint64(quint32(mX)) * 0xBF58476D1CE4E5B9ull +
+        quint64(quint32(mY)) * 0x94D049BB133111EBull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z = z ^ (z >> 31);
+    return (z >> 11) * (1. / (quint64(1) << 53));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Color of one pixel of a segment
+void SimdKernels::ColorPixel(const ColorParameters & mcParameters,
+    const double * mcpScaledStrength, int mIdx, double * mpRed,
+    double * mpGreen, double * mpBlue)
+{
+    double red = 255.;
+    double green = 255.;
+    double blue = 255.;
+    if (mcParameters.use_intensity)
+    {
+        red = qBound(0., (mcParameters.lic_r[mIdx] -
+            mcParameters.min_intensity) * mcParameters.intensity_scale, 255.);
+        green = qBound(0., (mcParameters.lic_g[mIdx] -
+            mcParameters.min_intensity) * mcParameters.intensity_scale, 255.);
+        blue = qBound(0., (mcParameters.lic_b[mIdx] -
+            mcParameters.min_intensity) * mcParameters.intensity_scale, 255.);
+    }
+    if (mcParameters.lut_r)
+    {
+        const int lut_idx = qBound(0,
+            int((mcpScaledStrength[mIdx] - mcParameters.min_strength) *
+                mcParameters.strength_scale),
+            mcParameters.lut_size - 1);
+        red *= mcParameters.lut_r[lut_idx];
+        green *= mcParameters.lut_g[lut_idx];
+        blue *= mcParameters.lut_b[lut_idx];
+    }
+    mpRed[mIdx] = red;
+    mpGreen[mIdx] = green;
+    mpBlue[mIdx] = blue;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Strength of a segment as it is mapped to colors
+const double * SimdKernels::GetScaledStrength(
+    const ColorParameters & mcParameters, int mNum, double * mpBuffer)
+{
+    if (!mcParameters.log_scale)
+    {
+        return mcParameters.lic_strength;
+    }
+
+    // The threshold of the log scale is the same as for singularities in
+    // the tracer
+    for (int idx = 0; idx < mNum; idx++)
+    {
+        mpBuffer[idx] = log10(qMax(mcParameters.lic_strength[idx], 1e-14));
+    }
+    return mpBuffer;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels without vector instructions
+const SimdKernels & SimdKernels::GetGeneric()
+{
+    static const SimdKernels kernels = { MinMax_Generic, Color_Generic,
+        PositionNoise_Generic };
+    return kernels;
+}
@@ -0,0 +1,242 @@
+// SimdKernels_SSE42.cpp
+// Kernels for SSE4.2 (two doubles per vector)
+
+// Project includes
+#include "SimdKernels.h"
+
+// System includes
+#if defined(LIC_SIMD_X86)
+#include <immintrin.h>
+#include <limits>
+#endif
+
+
+
+#if defined(LIC_SIMD_X86)
+
+#define LIC_TARGET __attribute__((target("sse4.2")))
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Range of a segment
+LIC_TARGET static bool MinMax_SSE42(const double * mcpR, const double * mcpG,
+    const double * mcpB, const double * mcpStrength, int mNum,
+    double * mpRange)
+{
+    const double infinity = std::numeric_limits < double >::infinity();
+    __m128d min_color = _mm_set1_pd(infinity);
+    __m128d max_color = _mm_set1_pd(-infinity);
+    __m128d min_strength = _mm_set1_pd(infinity);
+    __m128d max_strength = _mm_set1_pd(-infinity);
+    __m128d nan = _mm_setzero_pd();
+    int idx = 0;
+    for ( ; idx + 2 <= mNum; idx += 2)
+    {
+        const __m128d r = _mm_loadu_pd(mcpR + idx);
+        const __m128d g = _mm_loadu_pd(mcpG + idx);
+        const __m128d b = _mm_loadu_pd(mcpB + idx);
+        const __m128d s = _mm_loadu_pd(mcpStrength + idx);
+        nan = _mm_or_pd(nan, _mm_or_pd(_mm_cmpunord_pd(r, g),
+            _mm_cmpunord_pd(b, s)));
+        min_color = _mm_min_pd(min_color, _mm_min_pd(r, _mm_min_pd(g, b)));
+        max_color = _mm_max_pd(max_color, _mm_max_pd(r, _mm_max_pd(g, b)));
+        min_strength = _mm_min_pd(min_strength, s);
+        max_strength = _mm_max_pd(max_strength, s);
+    }
+    if (_mm_movemask_pd(nan))
+    {
+        return false;
+    }
+
+    // Lanes
+    double lanes[4][2];
+    _mm_storeu_pd(lanes[0], min_color);
+    _mm_storeu_pd(lanes[1], max_color);
+    _mm_storeu_pd(lanes[2], min_strength);
+    _mm_storeu_pd(lanes[3], max_strength);
+    for (int lane = 0; lane < 2; lane++)
+    {
+        mpRange[0] = qMin(mpRange[0], lanes[0][lane]);
+        mpRange[1] = qMax(mpRange[1], lanes[1][lane]);
+        mpRange[2] = qMin(mpRange[2], lanes[2][lane]);
+        mpRange[3] = qMax(mpRange[3], lanes[3][lane]);
+    }
+
+    // Rest
+    return SimdKernels::GetGeneric().min_max(mcpR + idx, mcpG + idx,
+        mcpB + idx, mcpStrength + idx, mNum - idx, mpRange);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Intensity of one channel mapped to [0, 255]
+LIC_TARGET static inline __m128d Intensity_SSE42(const double * mcpValues,
+    __m128d mMinIntensity, __m128d mIntensityScale)
+{
+    // Same as qBound(0., value, 255.), which maps NaN to 0
+    const __m128d value = _mm_mul_pd(
+        _mm_sub_pd(_mm_loadu_pd(mcpValues), mMinIntensity), mIntensityScale);
+    return _mm_max_pd(_mm_min_pd(_mm_set1_pd(255.), value), _mm_setzero_pd());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Colors of a segment
+LIC_TARGET static void Color_SSE42(
+    const SimdKernels::ColorParameters & mcParameters, int mNum,
+    double * mpRed, double * mpGreen, double * mpBlue)
+{
+    double buffer[SimdKernels::MAX_SEGMENT];
+    const double * strength =
+        SimdKernels::GetScaledStrength(mcParameters, mNum, buffer);
+
+    const __m128d white = _mm_set1_pd(255.);
+    const __m128d min_intensity = _mm_set1_pd(mcParameters.min_intensity);
+    const __m128d intensity_scale =
+        _mm_set1_pd(mcParameters.intensity_scale);
+    const __m128d min_strength = _mm_set1_pd(mcParameters.min_strength);
+    const __m128d strength_scale = _mm_set1_pd(mcParameters.strength_scale);
+    const __m128i first_entry = _mm_setzero_si128();
+    const __m128i last_entry = _mm_set1_epi32(mcParameters.lut_size - 1);
+    int idx = 0;
+    for ( ; idx + 2 <= mNum; idx += 2)
+    {
+        __m128d red = white;
+        __m128d green = white;
+        __m128d blue = white;
+        if (mcParameters.use_intensity)
+        {
+            red = Intensity_SSE42(mcParameters.lic_r + idx, min_intensity,
+                intensity_scale);
+            green = Intensity_SSE42(mcParameters.lic_g + idx, min_intensity,
+                intensity_scale);
+            blue = Intensity_SSE42(mcParameters.lic_b + idx, min_intensity,
+                intensity_scale);
+        }
+        if (mcParameters.lut_r)
+        {
+            // Truncated like int(); values out of range become INT_MIN
+            __m128i entry = _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(
+                _mm_loadu_pd(strength + idx), min_strength), strength_scale));
+            entry = _mm_min_epi32(_mm_max_epi32(entry, first_entry),
+                last_entry);
+            int entries[4];
+            _mm_storeu_si128(reinterpret_cast < __m128i * >(entries), entry);
+            red = _mm_mul_pd(red, _mm_set_pd(
+                mcParameters.lut_r[entries[1]],
+                mcParameters.lut_r[entries[0]]));
+            green = _mm_mul_pd(green, _mm_set_pd(
+                mcParameters.lut_g[entries[1]],
+                mcParameters.lut_g[entries[0]]));
+            blue = _mm_mul_pd(blue, _mm_set_pd(
+                mcParameters.lut_b[entries[1]],
+                mcParameters.lut_b[entries[0]]));
+        }
+        _mm_storeu_pd(mpRed + idx, red);
+        _mm_storeu_pd(mpGreen + idx, green);
+        _mm_storeu_pd(mpBlue + idx, blue);
+    }
+
+    // Rest
+    for ( ; idx < mNum; idx++)
+    {
+        SimdKernels::ColorPixel(mcParameters, strength, idx, mpRed, mpGreen,
+            mpBlue);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Low 64 bits of the products of the lanes
+LIC_TARGET static inline __m128i MultiplyLow64(__m128i mA, __m128i mB)
+{
+    const __m128i low = _mm_mul_epu32(mA, mB);
+    const __m128i cross = _mm_add_epi64(
+        _mm_mul_epu32(_mm_srli_epi64(mA, 32), mB),
+        _mm_mul_epu32(mA, _mm_srli_epi64(mB, 32)));
+    return _mm_add_epi64(low, _mm_slli_epi64(cross, 32));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Position noise of a segment
+LIC_TARGET static void PositionNoise_SSE42(int mSeed, int mX, int mY,
+    int mNum, double * mpValues)
+{
+    // The hash is stepped along the column, which only works while the
+    // unsigned row doesn't wrap
+    if (mY < 0 &&
+        mY + mNum > 0)
+    {
+        SimdKernels::GetGeneric().position_noise(mSeed, mX, mY, mNum,
+            mpValues);
+        return;
+    }
+
+    const quint64 row_factor = 0x94D049BB133111EBull;
+    const quint64 first = quint64(quint32(mSeed)) * 0x9E3779B97F4A7C15ull +
+        quint64(quint32(mX)) * 0xBF58476D1CE4E5B9ull +
+        quint64(quint32(mY)) * row_factor;
+    __m128i z = _mm_set_epi64x(qint64(first + row_factor), qint64(first));
+    const __m128i step = _mm_set1_epi64x(qint64(2 * row_factor));
+    const __m128i factor_1 = _mm_set1_epi64x(qint64(0xBF58476D1CE4E5B9ull));
+    const __m128i factor_2 = _mm_set1_epi64x(qint64(0x94D049BB133111EBull));
+
+    // 53 bits are converted exactly in two halves
+    const __m128i low_mask = _mm_set1_epi64x(0xFFFFFFFFll);
+    const __m128i magic_bits = _mm_set1_epi64x(0x4330000000000000ll);
+    const __m128d magic = _mm_set1_pd(4503599627370496.);
+    const __m128d high_scale = _mm_set1_pd(4294967296.);
+    const __m128d scale = _mm_set1_pd(1. / (quint64(1) << 53));
+    int idx = 0;
+    for ( ; idx + 2 <= mNum; idx += 2)
+    {
+        __m128i hash = MultiplyLow64(
+            _mm_xor_si128(z, _mm_srli_epi64(z, 30)), factor_1);
+        hash = MultiplyLow64(_mm_xor_si128(hash, _mm_srli_epi64(hash, 27)),
+            factor_2);
+        hash = _mm_srli_epi64(_mm_xor_si128(hash, _mm_srli_epi64(hash, 31)),
+            11);
+        const __m128d low = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(
+            _mm_and_si128(hash, low_mask), magic_bits)), magic);
+        const __m128d high = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(
+            _mm_srli_epi64(hash, 32), magic_bits)), magic);
+        _mm_storeu_pd(mpValues + idx, _mm_mul_pd(
+            _mm_add_pd(_mm_mul_pd(high, high_scale), low), scale));
+        z = _mm_add_epi64(z, step);
+    }
+
+    // Rest
+    for ( ; idx < mNum; idx++)
+    {
+        mpValues[idx] = SimdKernels::GetPositionNoise(mSeed, mX, mY + idx);
+    }
+}
+
+#undef LIC_TARGET
+
+#endif
+
+
+
+// ================================================================ Kernels
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels for SSE4.2
+const SimdKernels & SimdKernels::GetSSE42()
+{
+#if defined(LIC_SIMD_X86)
+    static const SimdKernels kernels = { MinMax_SSE42, Color_SSE42,
+        PositionNoise_SSE42 };
+    return kernels;
+#else
+    return GetGeneric();
+#endif
+}
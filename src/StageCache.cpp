@@ -0,0 +1,228 @@
+// StageCache.cpp
+// Class implementation
+
+// Project includes
+#include "Macros.h"
+#include "MessageLogger.h"
+#include "StageCache.h"
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+// System includes
+#include <cstring>
+
+
+
+// Version of the file layout; increase when it changes
+static const qint32 CACHE_FILE_VERSION = 1;
+
+// Start of every file
+static const char CACHE_FILE_MAGIC[8] = { 'L', 'I', 'C', 'C', 'A', 'C', 'H',
+    'E' };
+
+// Layout: header, key (UTF-8), padding to 8 bytes, planes one after the
+// other. The key is stored to tell the (unlikely) hash collision from a
+// hit.
+struct CacheFileHeader
+{
+    char magic[8];
+    qint32 version;
+    qint32 num_planes;
+    qint64 plane_size;
+    qint64 key_size;
+};
+
+// Planes start here
+static qint64 GetDataOffset(qint64 mKeySize)
+{
+    return (qint64(sizeof(CacheFileHeader)) + mKeySize + 7) / 8 * 8;
+}
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+StageCache::StageCache()
+{
+    // Nothing to do
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+StageCache::~StageCache()
+{
+    // Nothing to do
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Directory the files are kept in
+void StageCache::SetDirectory(const QString mcDirectory)
+{
+    m_Directory = mcDirectory;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Directory the files are kept in
+QString StageCache::GetDirectory() const
+{
+    return m_Directory;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Cache is used at all
+bool StageCache::IsEnabled() const
+{
+    return !m_Directory.isEmpty();
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Planes of a stage stored under a key
+bool StageCache::Load(const QString mcStage, const QString mcKey,
+    const QList < QList < double > * > mcPlanes, qsizetype mPlaneSize) const
+{
+    if (!IsEnabled())
+    {
+        return false;
+    }
+
+    // Not cached yet is the usual case, not an error
+    QFile cache_file(GetFilename(mcStage, mcKey));
+    if (!cache_file.exists() ||
+        !cache_file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    // The file is mapped, so the planes are copied straight from the page
+    // cache; there is no parsing and no intermediate buffer
+    const QByteArray key = mcKey.toUtf8();
+    const qint64 data_offset = GetDataOffset(key.size());
+    const qint64 plane_bytes = qint64(mPlaneSize) * qint64(sizeof(double));
+    const qint64 file_size = data_offset + mcPlanes.size() * plane_bytes;
+    if (cache_file.size() != file_size)
+    {
+        return false;
+    }
+    const uchar * data = cache_file.map(0, file_size);
+    if (!data)
+    {
+        return false;
+    }
+    CacheFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    const bool matches =
+        memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == CACHE_FILE_VERSION &&
+        header.num_planes == mcPlanes.size() &&
+        header.plane_size == mPlaneSize &&
+        header.key_size == key.size() &&
+        memcmp(data + sizeof(header), key.constData(), key.size()) == 0;
+    if (matches)
+    {
+        const uchar * plane_data = data + data_offset;
+        for (QList < double > * plane : mcPlanes)
+        {
+            plane -> resize(mPlaneSize);
+            memcpy(plane -> data(), plane_data, plane_bytes);
+            plane_data += plane_bytes;
+        }
+    }
+    cache_file.unmap(const_cast < uchar * >(data));
+    return matches;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Store planes
+bool StageCache::Store(const QString mcStage, const QString mcKey,
+    const QList < const QList < double > * > mcPlanes) const
+{
+    if (!IsEnabled())
+    {
+        return false;
+    }
+    if (!QDir().mkpath(m_Directory))
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Cache directory \"%1\" could not be created.")
+                .arg(m_Directory));
+        return false;
+    }
+
+    // Header and key
+    const QByteArray key = mcKey.toUtf8();
+    CacheFileHeader header;
+    memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_FILE_VERSION;
+    header.num_planes = mcPlanes.size();
+    header.plane_size = (mcPlanes.isEmpty() ? 0 : mcPlanes[0] -> size());
+    header.key_size = key.size();
+    QByteArray prefix(reinterpret_cast < const char * >(&header),
+        sizeof(header));
+    prefix += key;
+    prefix.resize(GetDataOffset(key.size()), '\0');
+
+    // Written to a temporary file that replaces the old one only when
+    // complete, so concurrent runs never see half a file
+    const QString filename = GetFilename(mcStage, mcKey);
+    QSaveFile cache_file(filename);
+    bool success = cache_file.open(QIODevice::WriteOnly) &&
+        cache_file.write(prefix) == prefix.size();
+    for (const QList < double > * plane : mcPlanes)
+    {
+        const qint64 plane_bytes = plane -> size() * qint64(sizeof(double));
+        success = success &&
+            plane -> size() == header.plane_size &&
+            cache_file.write(
+                reinterpret_cast < const char * >(plane -> constData()),
+                plane_bytes) == plane_bytes;
+    }
+    success = success && cache_file.commit();
+    if (!success)
+    {
+        MessageLogger::Error(METHOD_NAME,
+            QString("Cache file \"%1\" could not be written.")
+                .arg(filename));
+    }
+    return success;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// File of a stage and key
+QString StageCache::GetFilename(const QString mcStage,
+    const QString mcKey) const
+{
+    const QByteArray hash = QCryptographicHash::hash(mcKey.toUtf8(),
+        QCryptographicHash::Sha256).toHex();
+    return QDir(m_Directory).filePath(
+        QString("%1-%2.bin").arg(mcStage, QString::fromLatin1(hash)));
+}
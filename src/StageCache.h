@@ -0,0 +1,58 @@
+// StageCache.h
+// Class definition
+
+#ifndef STAGECACHE_H
+#define STAGECACHE_H
+
+// Qt includes
+#include <QList>
+#include <QString>
+
+
+
+// Define class
+class StageCache
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; the cache is disabled until it has a directory
+    StageCache();
+
+    // Destructor
+    virtual ~StageCache();
+
+
+
+    // ========================================================== Configuration
+public:
+    // Directory the files are kept in (empty: disabled)
+    void SetDirectory(const QString mcDirectory);
+    QString GetDirectory() const;
+    bool IsEnabled() const;
+
+private:
+    QString m_Directory;
+
+
+
+    // ========================================================== Functionality
+public:
+    // Planes of a stage stored under a key (everything the stage depends
+    // on). Files are named after a hash of stage and key, so nothing needs
+    // to be invalidated: changed inputs simply give another file.
+    // Returns false if there is no such file (or it doesn't match); the
+    // planes are left unchanged then.
+    bool Load(const QString mcStage, const QString mcKey,
+        const QList < QList < double > * > mcPlanes,
+        qsizetype mPlaneSize) const;
+
+    // Store planes; returns false if the file could not be written
+    bool Store(const QString mcStage, const QString mcKey,
+        const QList < const QList < double > * > mcPlanes) const;
+
+private:
+    // File of a stage and key
+    QString GetFilename(const QString mcStage, const QString mcKey) const;
+};
+
+#endif
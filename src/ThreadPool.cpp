@@ -0,0 +1,93 @@
+// ThreadPool.cpp
+// Class implementation
+
+// Project includes
+#include "ThreadPool.h"
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+ThreadPool::ThreadPool(int mNumThreads)
+{
+    m_StopRequested = false;
+    for (int thread_idx = 0; thread_idx < mNumThreads; thread_idx++)
+    {
+        m_Threads.emplace_back(&ThreadPool::Run, this);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        m_StopRequested = true;
+    }
+    m_Condition.notify_all();
+    for (std::thread & thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads
+int ThreadPool::GetNumThreads() const
+{
+    return int(m_Threads.size());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Queue a task
+void ThreadPool::Submit(std::function < void() > mTask)
+{
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        m_Tasks.push_back(mTask);
+    }
+    m_Condition.notify_one();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Worker thread
+void ThreadPool::Run()
+{
+    while (true)
+    {
+        std::function < void() > task;
+        {
+            std::unique_lock < std::mutex > lock(m_Mutex);
+            m_Condition.wait(lock,
+                [this]()
+                {
+                    return m_StopRequested || !m_Tasks.empty();
+                });
+            if (m_Tasks.empty())
+            {
+                // Stop requested and nothing left to do
+                return;
+            }
+            task = m_Tasks.front();
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
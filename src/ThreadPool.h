@@ -0,0 +1,49 @@
+// ThreadPool.h
+// Class definition
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// System includes
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// Define class
+class ThreadPool
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; starts the threads right away
+    ThreadPool(int mNumThreads);
+
+    // Destructor; finishes queued tasks, then stops the threads
+    virtual ~ThreadPool();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Number of threads
+    int GetNumThreads() const;
+
+    // Queue a task; returns immediately
+    void Submit(std::function < void() > mTask);
+
+private:
+    // Worker thread
+    void Run();
+
+    std::vector < std::thread > m_Threads;
+    std::deque < std::function < void() > > m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_StopRequested;
+};
+
+#endif
@@ -0,0 +1,201 @@
+// TileScheduler.cpp
+// Class implementation
+
+// Project includes
+#include "TileScheduler.h"
+
+// System includes
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+
+
+// Callers poll at least this often while waiting for their job
+static const int POLL_INTERVAL_MS = 20;
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constructor
+TileScheduler::TileScheduler(int mNumThreads)
+{
+    m_NextSequence = 0;
+    m_StopRequested = false;
+    const int num_threads = std::max(1, mNumThreads);
+    for (int thread_idx = 0; thread_idx < num_threads; thread_idx++)
+    {
+        m_Threads.emplace_back(
+            [this, thread_idx]()
+            {
+                Run(thread_idx);
+            });
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destructor
+TileScheduler::~TileScheduler()
+{
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        m_StopRequested = true;
+    }
+    m_WorkCondition.notify_all();
+    for (std::thread & thread : m_Threads)
+    {
+        thread.join();
+    }
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of threads
+int TileScheduler::GetNumThreads() const
+{
+    return int(m_Threads.size());
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Run the items of a job
+void TileScheduler::RunJob(int mNumItems, int mPriority,
+    const QDeadlineTimer & mcDeadline,
+    const std::atomic < bool > & mcCancelRequested,
+    std::function < void(int, int) > mRunItem,
+    std::function < void() > mPoll)
+{
+    if (mNumItems <= 0)
+    {
+        return;
+    }
+
+    // The job lives on this stack until all of its items have returned
+    Job job;
+    job.priority = mPriority;
+    job.deadline = mcDeadline;
+    job.cancel_requested = &mcCancelRequested;
+    job.run_item = mRunItem;
+    job.num_items = mNumItems;
+    {
+        std::lock_guard < std::mutex > lock(m_Mutex);
+        job.sequence = m_NextSequence++;
+        m_Jobs << &job;
+    }
+    m_WorkCondition.notify_all();
+
+    while (true)
+    {
+        {
+            std::unique_lock < std::mutex > lock(m_Mutex);
+
+            // Items that haven't been started are dropped right away, so
+            // the threads go to other jobs
+            if (job.cancel_requested -> load(std::memory_order_relaxed))
+            {
+                job.next_item = job.num_items;
+            }
+            if (job.next_item >= job.num_items &&
+                job.num_running == 0)
+            {
+                m_Jobs.removeAll(&job);
+                break;
+            }
+            m_DoneCondition.wait_for(lock,
+                std::chrono::milliseconds(POLL_INTERVAL_MS));
+        }
+        if (mPoll)
+        {
+            mPoll();
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Job to take the next item from
+TileScheduler::Job * TileScheduler::GetNextJob() const
+{
+    // Jobs are few, so looking at all of them is cheaper than keeping them
+    // sorted
+    Job * next_job = nullptr;
+    for (Job * job : m_Jobs)
+    {
+        if (job -> next_item >= job -> num_items ||
+            job -> cancel_requested -> load(std::memory_order_relaxed))
+        {
+            continue;
+        }
+        if (!next_job ||
+            job -> priority > next_job -> priority)
+        {
+            next_job = job;
+            continue;
+        }
+        if (job -> priority < next_job -> priority)
+        {
+            continue;
+        }
+
+        // A deadline comes before none at all (which is the latest one)
+        const qint64 deadline = (job -> deadline.isForever() ?
+            std::numeric_limits < qint64 >::max() :
+            job -> deadline.deadline());
+        const qint64 next_deadline = (next_job -> deadline.isForever() ?
+            std::numeric_limits < qint64 >::max() :
+            next_job -> deadline.deadline());
+        if (deadline < next_deadline ||
+            (deadline == next_deadline &&
+             job -> sequence < next_job -> sequence))
+        {
+            next_job = job;
+        }
+    }
+    return next_job;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Worker thread
+void TileScheduler::Run(int mThreadIdx)
+{
+    std::unique_lock < std::mutex > lock(m_Mutex);
+    while (true)
+    {
+        Job * job = nullptr;
+        m_WorkCondition.wait(lock,
+            [this, &job]()
+            {
+                job = GetNextJob();
+                return m_StopRequested || job;
+            });
+        if (!job)
+        {
+            // Stop requested and nothing left to do
+            return;
+        }
+
+        // Items run without the lock, so other threads can pick theirs
+        const int item = job -> next_item++;
+        job -> num_running++;
+        lock.unlock();
+        job -> run_item(item, mThreadIdx);
+        lock.lock();
+        job -> num_running--;
+        m_DoneCondition.notify_all();
+    }
+}
@@ -0,0 +1,88 @@
+// TileScheduler.h
+// Class definition
+
+#ifndef TILESCHEDULER_H
+#define TILESCHEDULER_H
+
+// Qt includes
+#include <QDeadlineTimer>
+#include <QList>
+
+// System includes
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// Define class
+class TileScheduler
+{
+    // ============================================================== Lifecycle
+public:
+    // Constructor; starts the threads right away
+    TileScheduler(int mNumThreads);
+
+    // Destructor; waits for running jobs, then stops the threads
+    virtual ~TileScheduler();
+
+
+
+    // ========================================================== Functionality
+public:
+    // Number of threads
+    int GetNumThreads() const;
+
+    // Run the items (tiles) of a job on the threads of the scheduler, while
+    // other threads run jobs of their own. mRunItem is called with the item
+    // and the index of the thread running it (a thread only runs one item
+    // at a time). Whenever a thread is free, it takes the next item of the
+    // job with the highest priority, then of the one with the earliest
+    // deadline, then of the one that came first; a job preempts others at
+    // item boundaries. Items of a cancelled job are dropped.
+    //
+    // Blocks until the job is done or cancelled and all of its running items
+    // have returned. mPoll is called on the calling thread after items of
+    // the job are done (and every few milliseconds), so it can call
+    // callbacks that aren't thread-safe.
+    void RunJob(int mNumItems, int mPriority,
+        const QDeadlineTimer & mcDeadline,
+        const std::atomic < bool > & mcCancelRequested,
+        std::function < void(int, int) > mRunItem,
+        std::function < void() > mPoll);
+
+private:
+    // A job being run
+    struct Job
+    {
+        int priority;
+        QDeadlineTimer deadline;
+        qint64 sequence;
+        const std::atomic < bool > * cancel_requested;
+        std::function < void(int, int) > run_item;
+        int num_items;
+        int next_item = 0;
+        int num_running = 0;
+    };
+
+    // Job to take the next item from; nullptr if there is none
+    Job * GetNextJob() const;
+
+    // Worker thread
+    void Run(int mThreadIdx);
+
+    std::vector < std::thread > m_Threads;
+    QList < Job * > m_Jobs;
+    qint64 m_NextSequence;
+    std::mutex m_Mutex;
+
+    // Workers wait for items, callers for items being done
+    std::condition_variable m_WorkCondition;
+    std::condition_variable m_DoneCondition;
+    bool m_StopRequested;
+};
+
+#endif
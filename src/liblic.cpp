@@ -0,0 +1,291 @@
+// liblic.cpp
+// Plain C interface of the LIC library
+
+// Project includes
+#include "LIC.h"
+#include "liblic.h"
+
+
+
+// A renderer is just the LIC object
+struct lic_renderer
+{
+    LIC lic;
+};
+
+
+
+// ================================================================== Lifecycle
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Create a renderer
+lic_renderer * lic_create(void)
+{
+    lic_renderer * renderer = new lic_renderer();
+
+    // A library doesn't draw progress bars on its own
+    renderer -> lic.SetProgressMode(ProgressReporter::Mode_Quiet);
+    return renderer;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Destroy a renderer
+void lic_destroy(lic_renderer * renderer)
+{
+    delete renderer;
+}
+
+
+
+// ============================================================== Configuration
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration from an XML file
+lic_status lic_load_file(lic_renderer * renderer, const char * filename)
+{
+    if (!renderer ||
+        !filename)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    return (renderer -> lic.ReadXMLConfiguration(QString::fromUtf8(filename)) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration from XML text
+lic_status lic_load_xml(lic_renderer * renderer, const char * xml)
+{
+    if (!renderer ||
+        !xml)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    return (renderer -> lic.SetXMLConfiguration(QString::fromUtf8(xml)) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Vector field
+lic_status lic_set_vectorfield(lic_renderer * renderer,
+    const char * formula_x, const char * formula_y,
+    const char * const * parameter_names, const double * parameter_values,
+    int num_parameters, int iterations)
+{
+    if (!renderer ||
+        !formula_x ||
+        !formula_y ||
+        num_parameters < 0 ||
+        (num_parameters > 0 &&
+         (!parameter_names || !parameter_values)))
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    QHash < QString, double > parameters;
+    for (int idx = 0; idx < num_parameters; idx++)
+    {
+        parameters[QString::fromUtf8(parameter_names[idx])] =
+            parameter_values[idx];
+    }
+    return (renderer -> lic.SetVectorfield(QString::fromUtf8(formula_x),
+        QString::fromUtf8(formula_y), parameters, iterations) ?
+            LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Region of the plane shown in the image
+lic_status lic_set_range(lic_renderer * renderer,
+    double x_min, double x_max, double y_min, double y_max)
+{
+    if (!renderer)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    return (renderer -> lic.SetImageRange(x_min, x_max, y_min, y_max) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the image
+lic_status lic_set_resolution(lic_renderer * renderer, int width, int height)
+{
+    if (!renderer)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    return (renderer -> lic.SetResolution(width, height) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of steps in each direction
+lic_status lic_set_steps(lic_renderer * renderer, int steps)
+{
+    if (!renderer)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    return (renderer -> lic.SetSteps(steps) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// White noise background
+lic_status lic_set_white_noise(lic_renderer * renderer, double cutoff,
+    int seed)
+{
+    if (!renderer)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    return (renderer -> lic.SetWhiteNoiseBackground(cutoff, seed) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Coloring by strength
+lic_status lic_set_coloring(lic_renderer * renderer, const char * colormap,
+    double gamma, int log_scale)
+{
+    if (!renderer)
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    const QString name = (colormap ? QString::fromUtf8(colormap) : QString());
+    return (renderer -> lic.SetColoring(name, gamma, log_scale != 0) ?
+        LIC_OK : LIC_ERROR_CONFIGURATION);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of tracing threads
+void lic_set_threads(lic_renderer * renderer, int num_threads)
+{
+    if (renderer)
+    {
+        renderer -> lic.SetNumThreads(qMax(num_threads, 0));
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Progress callback
+void lic_set_progress_callback(lic_renderer * renderer,
+    lic_progress_callback callback, void * user_data)
+{
+    if (!renderer)
+    {
+        return;
+    }
+    if (!callback)
+    {
+        renderer -> lic.SetProgressCallback(nullptr);
+        return;
+    }
+    renderer -> lic.SetProgressCallback(
+        [callback, user_data](double mFraction)
+        {
+            callback(mFraction, user_data);
+        });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Cancel callback
+void lic_set_cancel_callback(lic_renderer * renderer,
+    lic_cancel_callback callback, void * user_data)
+{
+    if (!renderer)
+    {
+        return;
+    }
+    if (!callback)
+    {
+        renderer -> lic.SetCancelCallback(nullptr);
+        return;
+    }
+    renderer -> lic.SetCancelCallback(
+        [callback, user_data]()
+        {
+            return callback(user_data) != 0;
+        });
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the image
+int lic_get_width(const lic_renderer * renderer)
+{
+    return (renderer ? renderer -> lic.GetImageWidth() : 0);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Size of the image
+int lic_get_height(const lic_renderer * renderer)
+{
+    return (renderer ? renderer -> lic.GetImageHeight() : 0);
+}
+
+
+
+// ============================================================== Functionality
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Render into a caller-owned buffer
+lic_status lic_render(lic_renderer * renderer, void * buffer, size_t stride,
+    lic_pixel_format format)
+{
+    if (!renderer ||
+        !buffer ||
+        (format != LIC_PIXEL_FORMAT_RGBX8 &&
+         format != LIC_PIXEL_FORMAT_RGB_FLOAT))
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Every line has to hold a full row of pixels
+    const size_t bytes_per_pixel = (format == LIC_PIXEL_FORMAT_RGBX8 ?
+        4 : 3 * sizeof(float));
+    const int width = lic_get_width(renderer);
+    if (width < 0 ||
+        stride < bytes_per_pixel * size_t(width))
+    {
+        return LIC_ERROR_INVALID_ARGUMENT;
+    }
+    const LIC::PixelFormat pixel_format = (format == LIC_PIXEL_FORMAT_RGBX8 ?
+        LIC::PixelFormat_RGBX8 : LIC::PixelFormat_RGB_Float);
+    if (renderer -> lic.Render(buffer, qsizetype(stride), pixel_format))
+    {
+        return LIC_OK;
+    }
+    return (renderer -> lic.IsCancelled() ?
+        LIC_ERROR_CANCELLED : LIC_ERROR_CONFIGURATION);
+}
@@ -0,0 +1,102 @@
+// liblic.h
+// Plain C interface of the LIC library
+
+#ifndef LIBLIC_H
+#define LIBLIC_H
+
+// System includes
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  define LIC_EXPORT __declspec(dllexport)
+#else
+#  define LIC_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Renderer; one per thread at a time
+typedef struct lic_renderer lic_renderer;
+
+// Result of calls
+typedef enum
+{
+    LIC_OK = 0,
+    LIC_ERROR_INVALID_ARGUMENT = 1,
+    LIC_ERROR_CONFIGURATION = 2,
+    LIC_ERROR_CANCELLED = 3
+} lic_status;
+
+// Layout of pixels in the caller's buffer
+typedef enum
+{
+    // Four bytes per pixel: red, green, blue, and 255
+    LIC_PIXEL_FORMAT_RGBX8 = 0,
+
+    // Three floats per pixel in [0, 1]: red, green, blue
+    LIC_PIXEL_FORMAT_RGB_FLOAT = 1
+} lic_pixel_format;
+
+// Called with the finished fraction in [0, 1] while tracing
+typedef void (*lic_progress_callback)(double fraction, void * user_data);
+
+// Asked regularly while tracing; return non-zero to cancel
+typedef int (*lic_cancel_callback)(void * user_data);
+
+// Create/destroy a renderer
+LIC_EXPORT lic_renderer * lic_create(void);
+LIC_EXPORT void lic_destroy(lic_renderer * renderer);
+
+// Configuration from an XML file or XML text (same format as for the
+// LIC application)
+LIC_EXPORT lic_status lic_load_file(lic_renderer * renderer,
+    const char * filename);
+LIC_EXPORT lic_status lic_load_xml(lic_renderer * renderer, const char * xml);
+
+// Configuration without XML
+LIC_EXPORT lic_status lic_set_vectorfield(lic_renderer * renderer,
+    const char * formula_x, const char * formula_y,
+    const char * const * parameter_names, const double * parameter_values,
+    int num_parameters, int iterations);
+LIC_EXPORT lic_status lic_set_range(lic_renderer * renderer,
+    double x_min, double x_max, double y_min, double y_max);
+LIC_EXPORT lic_status lic_set_resolution(lic_renderer * renderer,
+    int width, int height);
+LIC_EXPORT lic_status lic_set_steps(lic_renderer * renderer, int steps);
+LIC_EXPORT lic_status lic_set_white_noise(lic_renderer * renderer,
+    double cutoff, int seed);
+
+// Coloring by strength; a NULL colormap renders grayscale
+LIC_EXPORT lic_status lic_set_coloring(lic_renderer * renderer,
+    const char * colormap, double gamma, int log_scale);
+
+// Number of tracing threads (0: one per core)
+LIC_EXPORT void lic_set_threads(lic_renderer * renderer, int num_threads);
+
+// Callbacks are called on the thread that calls lic_render()
+LIC_EXPORT void lic_set_progress_callback(lic_renderer * renderer,
+    lic_progress_callback callback, void * user_data);
+LIC_EXPORT void lic_set_cancel_callback(lic_renderer * renderer,
+    lic_cancel_callback callback, void * user_data);
+
+// Size of the image
+LIC_EXPORT int lic_get_width(const lic_renderer * renderer);
+LIC_EXPORT int lic_get_height(const lic_renderer * renderer);
+
+// Render into a caller-owned buffer of lic_get_height() lines with
+// stride bytes each; a NULL buffer or a stride shorter than
+// lic_get_width() pixels gives LIC_ERROR_INVALID_ARGUMENT
+LIC_EXPORT lic_status lic_render(lic_renderer * renderer, void * buffer,
+    size_t stride, lic_pixel_format format);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,10 +1,19 @@
 // main.cpp
 
 // Project includes
+#include "Autotuner.h"
+#include "BatchRenderer.h"
+#include "Checkpoint.h"
+#include "ConfigWatcher.h"
+#include "CpuDispatch.h"
 #include "LIC.h"
+#include "RenderClient.h"
+#include "RenderEstimator.h"
+#include "RenderServer.h"
+#include "ShardRenderer.h"
 
 // Qt includes
-#include <QApplication>
+#include <QCoreApplication>
 #include <QDebug>
 
 
@@ -13,26 +22,423 @@
 // Main
 int main(int mNumParameters, char * mpParameter[])
 {
-    // Application
-    QApplication app(mNumParameters, mpParameter);
+    // Application; rendering only needs QtCore and the image encoder, so
+    // there is no GUI platform to set up (and none needed on servers)
+    QCoreApplication app(mNumParameters, mpParameter);
+
+    // Parse command line
+    QStringList config_filenames;
+    QStringList manifest_filenames;
+    QString report_filename;
+    QString cache_directory;
+    QString watch_filename;
+    QString checkpoint_filename;
+    bool resume = false;
+    int shard = -1;
+    int num_shards = 0;
+    bool merge = false;
+    QString serve_socket;
+    QString client_socket;
+    QString client_format = "png";
+    QString client_output;
+    int client_repeat = 1;
+    int client_priority = 0;
+    int client_deadline = 0;
+    ProgressReporter::Mode progress_mode = ProgressReporter::GetDefaultMode();
+    int num_threads = 0;
+    LIC::Backend backend = LIC::Backend_Threads;
+    bool backend_set = false;
+    bool autotune = false;
+    QString tuning_cache;
+    bool estimate = false;
+    bool numa_placement = true;
+    bool pin_threads = false;
+    const QStringList arguments = app.arguments();
+    for (int idx = 1; idx < arguments.size(); idx++)
+    {
+        const QString argument = arguments[idx];
+        if (argument == "--report" &&
+            idx + 1 < arguments.size())
+        {
+            report_filename = arguments[++idx];
+            continue;
+        }
+        if (argument == "--progress" &&
+            idx + 1 < arguments.size())
+        {
+            const QString mode = arguments[++idx];
+            if (!ProgressReporter::ModeFromString(mode, progress_mode))
+            {
+                qDebug().noquote() <<
+                    QString("Invalid progress mode \"%1\"; must be one of "
+                        "quiet, bar, or json.").arg(mode);
+                return 1;
+            }
+            continue;
+        }
+        if (argument == "--batch" &&
+            idx + 1 < arguments.size())
+        {
+            manifest_filenames << arguments[++idx];
+            continue;
+        }
+        if (argument == "--watch" &&
+            idx + 1 < arguments.size())
+        {
+            watch_filename = arguments[++idx];
+            continue;
+        }
+        if (argument == "--serve" &&
+            idx + 1 < arguments.size())
+        {
+            serve_socket = arguments[++idx];
+            continue;
+        }
+        if (argument == "--client" &&
+            idx + 1 < arguments.size())
+        {
+            client_socket = arguments[++idx];
+            continue;
+        }
+        if (argument == "--format" &&
+            idx + 1 < arguments.size())
+        {
+            client_format = arguments[++idx];
+            continue;
+        }
+        if (argument == "--output" &&
+            idx + 1 < arguments.size())
+        {
+            client_output = arguments[++idx];
+            continue;
+        }
+        if (argument == "--repeat" &&
+            idx + 1 < arguments.size())
+        {
+            client_repeat = arguments[++idx].toInt();
+            continue;
+        }
+        if (argument == "--priority" &&
+            idx + 1 < arguments.size())
+        {
+            client_priority = arguments[++idx].toInt();
+            continue;
+        }
+        if (argument == "--deadline" &&
+            idx + 1 < arguments.size())
+        {
+            client_deadline = arguments[++idx].toInt();
+            continue;
+        }
+        if (argument == "--checkpoint" &&
+            idx + 1 < arguments.size())
+        {
+            checkpoint_filename = arguments[++idx];
+            continue;
+        }
+        if (argument == "--resume")
+        {
+            resume = true;
+            continue;
+        }
+        if (argument == "--shard" &&
+            idx + 1 < arguments.size())
+        {
+            // Shard i of n, as "i/n"
+            const QStringList parts = arguments[++idx].split('/');
+            bool shard_ok = false;
+            bool num_shards_ok = false;
+            if (parts.size() == 2)
+            {
+                shard = parts[0].toInt(&shard_ok);
+                num_shards = parts[1].toInt(&num_shards_ok);
+            }
+            if (!shard_ok ||
+                !num_shards_ok)
+            {
+                qDebug().noquote() <<
+                    QString("Invalid shard \"%1\"; must be i/n.")
+                        .arg(arguments[idx]);
+                return 1;
+            }
+            continue;
+        }
+        if (argument == "--merge" &&
+            idx + 1 < arguments.size())
+        {
+            merge = true;
+            num_shards = arguments[++idx].toInt();
+            continue;
+        }
+        if (argument == "--cache" &&
+            idx + 1 < arguments.size())
+        {
+            cache_directory = arguments[++idx];
+            continue;
+        }
+        if (argument == "--backend" &&
+            idx + 1 < arguments.size())
+        {
+            const QString name = arguments[++idx];
+            if (!LIC::BackendFromString(name, backend))
+            {
+                qDebug().noquote() <<
+                    QString("Invalid backend \"%1\"; must be threads or "
+                        "processes.").arg(name);
+                return 1;
+            }
+            backend_set = true;
+            continue;
+        }
+        if (argument == "--isa" &&
+            idx + 1 < arguments.size())
+        {
+            // Kernels are picked once, before anything is rendered
+            const QString name = arguments[++idx];
+            CpuDispatch::ISA isa = CpuDispatch::ISA_Generic;
+            if (!CpuDispatch::ISAFromString(name, isa))
+            {
+                qDebug().noquote() <<
+                    QString("Invalid instruction set \"%1\"; must be "
+                        "generic, sse4.2, avx2, or avx512.").arg(name);
+                return 1;
+            }
+            if (!CpuDispatch::SetISA(isa))
+            {
+                qDebug().noquote() <<
+                    QString("This CPU does not support %1; the newest "
+                        "instruction set it supports is %2.")
+                        .arg(name, CpuDispatch::ISAToString(
+                            CpuDispatch::GetDetectedISA()));
+                return 1;
+            }
+            continue;
+        }
+        if (argument == "--autotune")
+        {
+            autotune = true;
+            continue;
+        }
+        if (argument == "--tuning-cache" &&
+            idx + 1 < arguments.size())
+        {
+            tuning_cache = arguments[++idx];
+            continue;
+        }
+        if (argument == "--estimate")
+        {
+            estimate = true;
+            continue;
+        }
+        if (argument == "--no-numa")
+        {
+            numa_placement = false;
+            continue;
+        }
+        if (argument == "--pin-threads")
+        {
+            pin_threads = true;
+            continue;
+        }
+        if (argument == "--threads" &&
+            idx + 1 < arguments.size())
+        {
+            num_threads = arguments[++idx].toInt();
+            if (num_threads < 0)
+            {
+                qDebug().noquote() <<
+                    QString("Invalid number of threads \"%1\".")
+                        .arg(arguments[idx]);
+                return 1;
+            }
+            continue;
+        }
+        config_filenames << argument;
+    }
 
     // Check for correct number of arguments
-    if (mNumParameters < 2)
+    if (config_filenames.isEmpty() &&
+        manifest_filenames.isEmpty() &&
+        watch_filename.isEmpty() &&
+        serve_socket.isEmpty())
     {
         const QString command_name = mpParameter[0];
         qDebug().noquote() <<
-            QString("Usage: %1 [config.xml]\n").arg(command_name);
+            QString("Usage: %1 [--report report.json] "
+                "[--progress quiet|bar|json] [--threads n] "
+                "[--backend threads|processes] [--no-numa] [--pin-threads] "
+                "[--isa generic|sse4.2|avx2|avx512] "
+                "[--autotune] [--tuning-cache file] [--estimate] "
+                "[--cache directory] [--checkpoint file [--resume]] "
+                "[--shard i/n | --merge n] "
+                "[--batch manifest.txt] "
+                "[--watch config.xml] [--serve socket] "
+                "[--client socket --output file [--format png|rgbx8|"
+                "rgb_float] [--repeat n] [--priority n] [--deadline ms]] "
+                "[config.xml ...]\n")
+                .arg(command_name);
         return 0;
     }
+    if (resume &&
+        checkpoint_filename.isEmpty())
+    {
+        qDebug().noquote() << "--resume needs the --checkpoint file of the "
+            "run to resume.";
+        return 1;
+    }
+    if ((shard >= 0 || merge) &&
+        config_filenames.size() != 1)
+    {
+        qDebug().noquote() << "--shard and --merge need exactly one "
+            "configuration.";
+        return 1;
+    }
+    if (estimate &&
+        (config_filenames.size() != 1 ||
+            !manifest_filenames.isEmpty() ||
+            !watch_filename.isEmpty() ||
+            !serve_socket.isEmpty() ||
+            !client_socket.isEmpty() ||
+            shard >= 0 ||
+            merge))
+    {
+        qDebug().noquote() << "--estimate needs exactly one configuration "
+            "rendered by this process, without shards.";
+        return 1;
+    }
+
+    // Keep renderers warm for requests of other tools
+    if (!serve_socket.isEmpty())
+    {
+        RenderServer server(serve_socket);
+        server.SetNumThreads(num_threads);
+        return server.Execute();
+    }
+
+    // Have a running server render a configuration
+    if (!client_socket.isEmpty())
+    {
+        RenderClient client(client_socket);
+        client.SetRepeat(client_repeat);
+        client.SetPriority(client_priority, client_deadline);
+        if (client_output.isEmpty() ||
+            !client.SetFormat(client_format))
+        {
+            qDebug().noquote() << "The client needs an output file and a "
+                "valid format.";
+            return 1;
+        }
+        return (client.Execute(config_filenames.first(), client_output) ?
+            0 : 1);
+    }
+
+    // Render again whenever the configuration is edited
+    if (!watch_filename.isEmpty())
+    {
+        ConfigWatcher watcher(watch_filename);
+        watcher.SetProgressMode(progress_mode);
+        watcher.SetNumThreads(num_threads);
+        return watcher.Execute();
+    }
+
+    // Several configurations share threads, noise, and buffers
+    if (config_filenames.size() > 1 ||
+        !manifest_filenames.isEmpty())
+    {
+        BatchRenderer batch;
+        batch.SetProgressMode(progress_mode);
+        batch.SetNumThreads(num_threads);
+        for (const QString & manifest_filename : manifest_filenames)
+        {
+            if (!batch.AddManifest(manifest_filename))
+            {
+                return 1;
+            }
+        }
+        for (const QString & config_filename : config_filenames)
+        {
+            batch.AddConfiguration(config_filename);
+        }
+        const bool success = batch.Execute();
+        if (!report_filename.isEmpty())
+        {
+            batch.WriteJSON(report_filename);
+        }
+        return (success ? 0 : 1);
+    }
 
     // Read configuration XML file
-    const QString filename = mpParameter[1];
+    const QString config_filename = config_filenames.first();
     LIC * lic = new LIC();
-    lic -> ReadXMLConfiguration(filename);
+    lic -> SetProgressMode(progress_mode);
+    lic -> SetNumThreads(num_threads);
+    lic -> SetBackend(backend);
+    lic -> SetNUMAPlacement(numa_placement);
+    lic -> SetPinThreads(pin_threads);
+    lic -> SetCacheDirectory(cache_directory);
+    lic -> SetCheckpoint(checkpoint_filename, resume);
+    bool success = lic -> ReadXMLConfiguration(config_filename);
+
+    // Settings tuned for this host, unless given on the command line.
+    // Shards may run on different hosts, but need the same tiles; so does
+    // a resumed run, whatever has been tuned since the checkpoint.
+    if (success &&
+        shard < 0 &&
+        !merge)
+    {
+        Autotuner tuner(lic);
+        if (!tuning_cache.isEmpty())
+        {
+            tuner.SetCacheFilename(tuning_cache);
+        }
+        if (autotune)
+        {
+            success = tuner.Execute();
+        } else if (!resume)
+        {
+            tuner.ApplyCached();
+        }
+        if (num_threads > 0)
+        {
+            lic -> SetNumThreads(num_threads);
+        }
+        if (backend_set)
+        {
+            lic -> SetBackend(backend);
+        }
+        const int checkpoint_tile_size =
+            (resume ? Checkpoint::ReadTileSize(checkpoint_filename) : 0);
+        if (checkpoint_tile_size > 0)
+        {
+            lic -> SetTileSize(checkpoint_tile_size);
+        }
+    }
 
-    // Do it.
-    lic -> Execute();
+    // Do it; a shard is a share of the tiles, merged into the outputs
+    // once all shards are rendered. An estimate only traces samples.
+    if (success &&
+        estimate)
+    {
+        RenderEstimator estimator(lic);
+        success = estimator.Execute();
+    } else if (success &&
+        (shard >= 0 || merge))
+    {
+        ShardRenderer shards(lic);
+        success = (merge ? shards.Merge(num_shards) :
+            shards.Render(shard, num_shards));
+    } else if (success)
+    {
+        success = lic -> Execute();
+    }
+
+    // Timings and counters
+    if (!report_filename.isEmpty())
+    {
+        lic -> GetPerformanceReport().WriteJSON(report_filename);
+    }
 
     // Done
-    return 0;
+    delete lic;
+    return (success ? 0 : 1);
 }